@@ -97,6 +97,8 @@ const char* oe_result_str(oe_result_t result)
             return "OE_INVALID_QE_IDENTITY_INFO";
         case OE_UNSUPPORTED_ENCLAVE_IMAGE:
             return "OE_UNSUPPORTED_ENCLAVE_IMAGE";
+        case OE_TIMEDOUT:
+            return "OE_TIMEDOUT";
         case __OE_RESULT_MAX:
             break;
     }
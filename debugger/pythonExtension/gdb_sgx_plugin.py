@@ -13,19 +13,20 @@ POINTER_SIZE = 8
 # These constant definitions must align with _oe_enclave structure defined in host\enclave.h
 OE_ENCLAVE_MAGIC_FIELD = 0
 OE_ENCLAVE_ADDR_FIELD = 2
-OE_ENCLAVE_HEADER_LENGTH = 0X28
-OE_ENCLAVE_HEADER_FORMAT = 'QQQQQ'
+OE_ENCLAVE_THREAD_BINDING_FIELD = 5
+OE_ENCLAVE_NUM_THREAD_BINDINGS_FIELD = 6
+OE_ENCLAVE_HEADER_LENGTH = 0X38
+OE_ENCLAVE_HEADER_FORMAT = 'QQQQQQQ'
 OE_ENCLAVE_MAGIC_VALUE = 0x20dc98463a5ad8b8
 
 # The following are the offset of the 'debug' and
 # 'simulate' flag fields which must lie one after the other.
-OE_ENCLAVE_FLAGS_OFFSET = 0x798
+OE_ENCLAVE_FLAGS_OFFSET = 0xa8
 OE_ENCLAVE_FLAGS_LENGTH = 2
 OE_ENCLAVE_FLAGS_FORMAT = 'BB'
-OE_ENCLAVE_THREAD_BINDING_OFFSET = 0x28
 
 # These constant definitions must align with ThreadBinding structure defined in host\enclave.h
-THREAD_BINDING_SIZE = 0x28
+THREAD_BINDING_SIZE = 0x40
 THREAD_BINDING_HEADER_LENGTH = 0X8
 THREAD_BINDING_HEADER_FORMAT = 'Q'
 
@@ -167,16 +168,14 @@ def enable_oeenclave_debug(oe_enclave_addr, enclave_path):
     if load_enclave_symbol(enclave_path, enclave_tuple[OE_ENCLAVE_ADDR_FIELD]) != 1:
         return False
     # Set debug flag for each TCS in this enclave.
-    thread_binding_addr = oe_enclave_addr + OE_ENCLAVE_THREAD_BINDING_OFFSET
-    thread_binding_blob = read_from_memory(thread_binding_addr, THREAD_BINDING_HEADER_LENGTH)
-    thread_binding_tuple = struct.unpack(THREAD_BINDING_HEADER_FORMAT, thread_binding_blob)
-    while thread_binding_tuple[0] > 0 :
+    thread_binding_addr = enclave_tuple[OE_ENCLAVE_THREAD_BINDING_FIELD]
+    for i in range(enclave_tuple[OE_ENCLAVE_NUM_THREAD_BINDINGS_FIELD]):
+        thread_binding_blob = read_from_memory(thread_binding_addr, THREAD_BINDING_HEADER_LENGTH)
+        thread_binding_tuple = struct.unpack(THREAD_BINDING_HEADER_FORMAT, thread_binding_blob)
         # print ("tcs address {0:#x}" .format(thread_binding_tuple[0]))
         set_tcs_debug_flag(thread_binding_tuple[0])
         # Iterate the array
         thread_binding_addr = thread_binding_addr + THREAD_BINDING_SIZE
-        thread_binding_blob = read_from_memory(thread_binding_addr, THREAD_BINDING_HEADER_LENGTH)
-        thread_binding_tuple = struct.unpack(THREAD_BINDING_HEADER_FORMAT, thread_binding_blob)
     return True
 
 def update_untrusted_ocall_frame(frame_pointer, ocallcontext_tuple):
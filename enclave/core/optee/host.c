@@ -21,6 +21,21 @@ oe_result_t oe_call_host_function(
     return OE_UNSUPPORTED;
 }
 
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size)
+{
+    OE_UNUSED(function_id);
+    OE_UNUSED(input_buffer);
+    OE_UNUSED(input_buffer_size);
+    OE_UNUSED(output_buffer);
+    OE_UNUSED(output_buffer_size);
+    return OE_UNSUPPORTED;
+}
+
 void* oe_allocate_ocall_buffer(size_t size)
 {
     OE_UNUSED(size);
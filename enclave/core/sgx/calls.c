@@ -21,9 +21,14 @@
 #include "../../sgx/report.h"
 #include "asmdefs.h"
 #include "cpuid.h"
+#include "hostheap.h"
 #include "init.h"
+#include "lockprofile.h"
 #include "report.h"
+#include "scratch.h"
+#include "switchless.h"
 #include "td.h"
+#include "threadstart.h"
 
 oe_result_t __oe_enclave_status = OE_OK;
 uint8_t __oe_initialized = 0;
@@ -167,6 +172,15 @@ static oe_result_t _handle_init_enclave(uint64_t arg_in)
                     OE_RAISE(OE_INVALID_PARAMETER);
 
                 oe_enclave = safe_args.enclave;
+
+                OE_CHECK(
+                    oe_init_scratch_regions(
+                        safe_args.scratch_regions,
+                        safe_args.num_scratch_regions));
+
+                OE_CHECK(
+                    oe_init_host_heap(
+                        safe_args.host_heap, safe_args.host_heap_size));
             }
 
             /* Call all enclave state initialization functions */
@@ -251,84 +265,201 @@ done:
 extern const oe_ecall_func_t __oe_ecalls_table[];
 extern const size_t __oe_ecalls_table_size;
 
-/**
- * This is the preferred way to call enclave functions.
- */
-static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
+/*
+**==============================================================================
+**
+** _get_marshal_buffer()
+** _put_marshal_buffer()
+**
+**     The outermost ECALL of a thread marshals its parameters in a buffer
+**     kept in the td_t, which grows in whole pages as needed and is reused
+**     by later calls.
+**     A buffer that grew beyond MARSHAL_BUFFER_HIGH_WATER is kept while
+**     large calls continue, and released after MARSHAL_BUFFER_SHRINK_CALLS
+**     calls in a row have needed no more than MARSHAL_BUFFER_HIGH_WATER
+**     bytes. Nested ECALLs (made while the outer call is still using the
+**     buffer) allocate their own. The enclave destructor releases the
+**     buffers of all threads, so that they are not reported as leaks.
+**
+**==============================================================================
+*/
+
+#define MARSHAL_BUFFER_HIGH_WATER (64 * 1024)
+#define MARSHAL_BUFFER_SHRINK_CALLS 64
+
+/* Release the buffers of all threads. Called by the enclave destructor */
+static void _free_marshal_buffers(void)
+{
+    for (size_t i = 0; i < __oe_get_num_tcs(); i++)
+    {
+        td_t* td = td_from_tcs(__oe_get_tcs(i));
+
+        oe_free(td->marshal_buffer);
+        td->marshal_buffer = NULL;
+        td->marshal_buffer_size = 0;
+        td->marshal_buffer_small_calls = 0;
+    }
+}
+
+static uint8_t* _get_marshal_buffer(td_t* td, size_t size)
+{
+    size_t capacity;
+
+    if (td->depth != 1)
+        return oe_malloc(size);
+
+    if (size <= td->marshal_buffer_size)
+        return td->marshal_buffer;
+
+    if (size > OE_SIZE_MAX - OE_PAGE_SIZE)
+        return NULL;
+
+    capacity = oe_round_up_to_page_size(size);
+
+    oe_free(td->marshal_buffer);
+    td->marshal_buffer_size = 0;
+
+    if (!(td->marshal_buffer = oe_malloc(capacity)))
+        return NULL;
+
+    td->marshal_buffer_size = capacity;
+    return td->marshal_buffer;
+}
+
+static void _put_marshal_buffer(td_t* td, uint8_t* buffer, size_t size)
+{
+    if (buffer != td->marshal_buffer)
+    {
+        oe_free(buffer);
+        return;
+    }
+
+    if (td->marshal_buffer_size <= MARSHAL_BUFFER_HIGH_WATER)
+        return;
+
+    if (size > MARSHAL_BUFFER_HIGH_WATER)
+    {
+        td->marshal_buffer_small_calls = 0;
+    }
+    else if (++td->marshal_buffer_small_calls == MARSHAL_BUFFER_SHRINK_CALLS)
+    {
+        oe_free(td->marshal_buffer);
+        td->marshal_buffer = NULL;
+        td->marshal_buffer_size = 0;
+        td->marshal_buffer_small_calls = 0;
+    }
+}
+
+/*
+**==============================================================================
+**
+** _call_enclave_function()
+**
+**     Validate the buffers of a call (args must be in enclave memory), copy
+**     the inputs into the enclave, call the function and copy the outputs to
+**     the host.
+**
+**==============================================================================
+*/
+
+static oe_result_t _call_enclave_function(
+    const oe_call_enclave_function_args_t* args,
+    size_t* output_bytes_written)
 {
-    oe_call_enclave_function_args_t args, *args_ptr;
     oe_result_t result = OE_OK;
+    td_t* td = oe_get_td();
     oe_ecall_func_t func = NULL;
     uint8_t* buffer = NULL;
     uint8_t* input_buffer = NULL;
     uint8_t* output_buffer = NULL;
     size_t buffer_size = 0;
-    size_t output_bytes_written = 0;
 
-    // Ensure that args lies outside the enclave.
-    if (!oe_is_outside_enclave(
-            (void*)arg_in, sizeof(oe_call_enclave_function_args_t)))
-        OE_RAISE(OE_INVALID_PARAMETER);
-
-    // Copy args to enclave memory to avoid TOCTOU issues.
-    args_ptr = (oe_call_enclave_function_args_t*)arg_in;
-    args = *args_ptr;
+    *output_bytes_written = 0;
 
     // Ensure that input buffer is valid.
-    if (args.input_buffer == NULL || args.input_buffer_size == 0 ||
-        !oe_is_outside_enclave(args.input_buffer, args.input_buffer_size))
+    if (args->input_buffer == NULL || args->input_buffer_size == 0 ||
+        !oe_is_outside_enclave(args->input_buffer, args->input_buffer_size))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // Ensure that output buffer is valid.
-    if (args.output_buffer == NULL || args.output_buffer_size == 0 ||
-        !oe_is_outside_enclave(args.output_buffer, args.output_buffer_size))
+    if (args->output_buffer == NULL || args->output_buffer_size == 0 ||
+        !oe_is_outside_enclave(args->output_buffer, args->output_buffer_size))
         OE_RAISE(OE_INVALID_PARAMETER);
 
     // Validate output and input buffer sizes.
     // Buffer sizes must be correctly aligned.
-    if ((args.input_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
+    if ((args->input_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    if ((args.output_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
+    if ((args->output_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
     OE_CHECK(
         oe_safe_add_u64(
-            args.input_buffer_size, args.output_buffer_size, &buffer_size));
+            args->input_buffer_size, args->output_buffer_size, &buffer_size));
 
     // Fetch matching function.
-    if (args.function_id >= __oe_ecalls_table_size)
+    if (args->function_id >= __oe_ecalls_table_size)
         OE_RAISE(OE_NOT_FOUND);
 
-    func = __oe_ecalls_table[args.function_id];
+    func = __oe_ecalls_table[args->function_id];
 
     if (func == NULL)
         OE_RAISE(OE_NOT_FOUND);
 
-    // Allocate buffers in enclave memory
-    buffer = input_buffer = oe_malloc(buffer_size);
+    // Get buffers in enclave memory
+    buffer = input_buffer = _get_marshal_buffer(td, buffer_size);
     if (buffer == NULL)
         OE_RAISE(OE_OUT_OF_MEMORY);
 
     // Copy input buffer to enclave buffer.
-    oe_memcpy(input_buffer, args.input_buffer, args.input_buffer_size);
+    oe_memcpy(input_buffer, args->input_buffer, args->input_buffer_size);
 
     // Clear out output buffer.
     // This ensures reproducible behavior if say the function is reading from
     // output buffer.
-    output_buffer = buffer + args.input_buffer_size;
-    oe_memset(output_buffer, 0, args.output_buffer_size);
+    output_buffer = buffer + args->input_buffer_size;
+    oe_memset(output_buffer, 0, args->output_buffer_size);
 
     // Call the function.
     func(
         input_buffer,
-        args.input_buffer_size,
+        args->input_buffer_size,
         output_buffer,
-        args.output_buffer_size,
-        &output_bytes_written);
+        args->output_buffer_size,
+        output_bytes_written);
 
     // Copy outputs to host memory.
-    oe_memcpy(args.output_buffer, output_buffer, output_bytes_written);
+    oe_memcpy(args->output_buffer, output_buffer, *output_bytes_written);
+
+    result = OE_OK;
+
+done:
+    if (buffer)
+        _put_marshal_buffer(td, buffer, buffer_size);
+
+    return result;
+}
+
+/**
+ * This is the preferred way to call enclave functions.
+ */
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in)
+{
+    oe_call_enclave_function_args_t args, *args_ptr;
+    oe_result_t result = OE_OK;
+    size_t output_bytes_written = 0;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_function_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args_ptr = (oe_call_enclave_function_args_t*)arg_in;
+    args = *args_ptr;
+
+    OE_CHECK(_call_enclave_function(&args, &output_bytes_written));
 
     // The ecall succeeded.
     args_ptr->output_bytes_written = output_bytes_written;
@@ -336,9 +467,64 @@ static oe_result_t _handle_call_enclave_function(uint64_t arg_in)
     result = OE_OK;
 
 done:
-    if (buffer)
-        oe_free(buffer);
+    return result;
+}
 
+/*
+**==============================================================================
+**
+** _handle_call_enclave_function_batch()
+**
+**     Perform each call of a batch in order. The outcome of each call is
+**     stored in its entry; a failing call does not stop the batch.
+**
+**==============================================================================
+*/
+
+static oe_result_t _handle_call_enclave_function_batch(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_function_batch_args_t args;
+    oe_enclave_function_call_t* calls;
+    size_t calls_size;
+
+    // Ensure that args lies outside the enclave.
+    if (!oe_is_outside_enclave(
+            (void*)arg_in, sizeof(oe_call_enclave_function_batch_args_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    // Copy args to enclave memory to avoid TOCTOU issues.
+    args = *(oe_call_enclave_function_batch_args_t*)arg_in;
+    calls = args.calls;
+
+    // Ensure that the array of calls lies outside the enclave.
+    OE_CHECK(
+        oe_safe_mul_u64(
+            args.num_calls, sizeof(oe_enclave_function_call_t), &calls_size));
+
+    if (!calls || !oe_is_outside_enclave(calls, calls_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (uint64_t i = 0; i < args.num_calls; i++)
+    {
+        oe_call_enclave_function_args_t call_args;
+        size_t output_bytes_written = 0;
+
+        // Copy the call to enclave memory to avoid TOCTOU issues.
+        call_args.function_id = calls[i].function_id;
+        call_args.input_buffer = calls[i].input_buffer;
+        call_args.input_buffer_size = calls[i].input_buffer_size;
+        call_args.output_buffer = calls[i].output_buffer;
+        call_args.output_buffer_size = calls[i].output_buffer_size;
+
+        calls[i].result =
+            _call_enclave_function(&call_args, &output_bytes_written);
+        calls[i].output_bytes_written = output_bytes_written;
+    }
+
+    result = OE_OK;
+
+done:
     return result;
 }
 
@@ -431,17 +617,32 @@ static void _handle_ecall(
         }
         case OE_ECALL_CALL_ENCLAVE_FUNCTION:
         {
-            arg_out = _handle_call_enclave_function(arg_in);
+            arg_out = oe_handle_call_enclave_function(arg_in);
+            break;
+        }
+        case OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH:
+        {
+            arg_out = _handle_call_enclave_function_batch(arg_in);
             break;
         }
         case OE_ECALL_DESTRUCTOR:
         {
+            /* Release the threads the host gave up on, so that no joiner
+             * waits for them forever */
+            oe_cancel_thread_starts();
+
             /* Call functions installed by __cxa_atexit() and oe_atexit() */
             oe_call_atexit_functions();
 
             /* Call all finalization functions */
             oe_call_fini_functions();
 
+            /* Release the per-thread ECALL marshaling buffers */
+            _free_marshal_buffers();
+
+            /* Release the enclave memory of the untrusted heap */
+            oe_free_host_heap();
+
 #if defined(OE_USE_DEBUG_MALLOC)
 
             /* If memory still allocated, print a trace and return an error */
@@ -477,6 +678,26 @@ static void _handle_ecall(
             _handle_oelog_init(arg_in);
             break;
         }
+        case OE_ECALL_INIT_SWITCHLESS:
+        {
+            arg_out = oe_handle_init_switchless(arg_in);
+            break;
+        }
+        case OE_ECALL_SWITCHLESS_WORKER:
+        {
+            arg_out = oe_handle_switchless_worker(arg_in);
+            break;
+        }
+        case OE_ECALL_THREAD_START:
+        {
+            arg_out = oe_handle_thread_start(arg_in);
+            break;
+        }
+        case OE_ECALL_GET_LOCK_PROFILE:
+        {
+            arg_out = oe_handle_get_lock_profile(arg_in);
+            break;
+        }
         default:
         {
             /* No function found with the number */
@@ -487,6 +708,11 @@ static void _handle_ecall(
 
 done:
 
+    /* The host runs the deferred OCALLs when this ECALL returns. Exception
+     * handlers do not touch the queue of the code they interrupted. */
+    if (func != OE_ECALL_VIRTUAL_EXCEPTION_HANDLER)
+        oe_clear_deferred_ocalls();
+
     /* Remove ECALL context from front of td_t.ecalls list */
     td_pop_callsite(td);
 
@@ -560,6 +786,9 @@ oe_result_t oe_ocall(uint16_t func, uint64_t arg_in, uint64_t* arg_out)
     /* Save call site where execution will resume after OCALL */
     if (oe_setjmp(&callsite->jmpbuf) == 0)
     {
+        /* The host runs the deferred OCALLs before this one */
+        oe_clear_deferred_ocalls();
+
         /* Exit, giving control back to the host so it can handle OCALL */
         _handle_exit(OE_CODE_OCALL, func, arg_in);
 
@@ -609,7 +838,7 @@ oe_result_t oe_call_host(const char* func, void* args_in)
             oe_safe_add_sizet(
                 len, 1 + sizeof(oe_call_host_args_t), &total_len));
 
-        if (!(args = oe_host_calloc(1, total_len)))
+        if (!(args = oe_scratch_calloc(total_len)))
         {
             /* If the enclave is in crashing/crashed status, new OCALL should
              * fail immediately. */
@@ -632,7 +861,7 @@ oe_result_t oe_call_host(const char* func, void* args_in)
     result = OE_OK;
 
 done:
-    oe_host_free(args);
+    oe_scratch_free(args);
     return result;
 }
 
@@ -661,7 +890,7 @@ oe_result_t oe_call_host_by_address(
 
     /* Initialize the arguments */
     {
-        if (!(args = oe_host_calloc(1, sizeof(*args))))
+        if (!(args = oe_scratch_calloc(sizeof(*args))))
         {
             /* Fail if the enclave is crashing. */
             OE_CHECK(__oe_enclave_status);
@@ -683,11 +912,95 @@ oe_result_t oe_call_host_by_address(
 
 done:
 
-    oe_host_free(args);
+    oe_scratch_free(args);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_host_function_handle()
+**
+**     The handle is the address of the host function, which is passed to
+**     oe_call_host_by_address() by oe_call_host_by_handle().
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_host_function_handle(
+    const char* func,
+    oe_host_function_handle_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_host_func_args_t* args = NULL;
+    oe_host_func_t host_func;
+
+    if (handle)
+        *handle = 0;
+
+    /* Reject invalid parameters */
+    if (!func || !handle)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Initialize the arguments */
+    {
+        size_t len = oe_strlen(func);
+        size_t total_len;
+
+        OE_CHECK(
+            oe_safe_add_sizet(
+                len, 1 + sizeof(oe_get_host_func_args_t), &total_len));
+
+        if (!(args = oe_scratch_calloc(total_len)))
+        {
+            /* Fail if the enclave is crashing. */
+            OE_CHECK(__oe_enclave_status);
+            OE_RAISE(OE_OUT_OF_MEMORY);
+        }
 
+        OE_CHECK(oe_memcpy_s(args->name, len + 1, func, len + 1));
+
+        args->func = NULL;
+        args->result = OE_UNEXPECTED;
+    }
+
+    /* Ask the host for the address of the function */
+    OE_CHECK(oe_ocall(OE_OCALL_GET_HOST_FUNC, (uint64_t)args, NULL));
+
+    /* Check the result */
+    OE_CHECK(args->result);
+
+    /* Read the address only once and verify it is outside the enclave */
+    host_func = *(oe_host_func_t volatile*)&args->func;
+
+    if (!host_func || !oe_is_outside_enclave(host_func, sizeof(host_func)))
+        OE_RAISE(OE_UNEXPECTED);
+
+    *handle = (oe_host_function_handle_t)host_func;
+
+    result = OE_OK;
+
+done:
+    oe_scratch_free(args);
     return result;
 }
 
+/*
+**==============================================================================
+**
+** oe_call_host_by_handle()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_host_by_handle(
+    oe_host_function_handle_t handle,
+    void* args)
+{
+    return oe_call_host_by_address((oe_host_func_t)handle, args);
+}
+
 /*
 **==============================================================================
 **
@@ -714,7 +1027,7 @@ oe_result_t oe_call_host_function(
 
     /* Initialize the arguments */
     {
-        if (!(args = oe_host_calloc(1, sizeof(*args))))
+        if (!(args = oe_scratch_calloc(sizeof(*args))))
         {
             /* Fail if the enclave is crashing. */
             OE_CHECK(__oe_enclave_status);
@@ -740,7 +1053,7 @@ oe_result_t oe_call_host_function(
 
 done:
 
-    oe_host_free(args);
+    oe_scratch_free(args);
 
     return result;
 }
@@ -242,6 +242,34 @@ const void* __oe_get_heap_end()
     return (const uint8_t*)__oe_get_heap_base() + __oe_get_heap_size();
 }
 
+/*
+**==============================================================================
+**
+** Thread sections:
+**
+**     The heap is followed by one section per TCS, each consisting of a
+**     guard page, the stack, another guard page and six control pages that
+**     start with the TCS page (see _oe_add_data_pages() in
+**     host/sgx/create.c).
+**
+**==============================================================================
+*/
+
+size_t __oe_get_num_tcs()
+{
+    return oe_enclave_properties_sgx.header.size_settings.num_tcs;
+}
+
+void* __oe_get_tcs(size_t index)
+{
+    const size_t num_stack_pages =
+        oe_enclave_properties_sgx.header.size_settings.num_stack_pages;
+    const size_t section_size = (2 + num_stack_pages + 6) * OE_PAGE_SIZE;
+    uint8_t* section = (uint8_t*)__oe_get_heap_end() + index * section_size;
+
+    return section + (1 + num_stack_pages + 1) * OE_PAGE_SIZE;
+}
+
 /*
 **==============================================================================
 **
@@ -8,12 +8,19 @@
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/print.h>
+#include "hostheap.h"
+#include "scratch.h"
 #include "td.h"
 
 void* oe_host_malloc(size_t size)
 {
     uint64_t arg_in = size;
     uint64_t arg_out = 0;
+    void* ptr;
+
+    /* Serve the request from the untrusted heap if possible */
+    if ((ptr = oe_host_heap_malloc(size)))
+        return ptr;
 
     if (oe_ocall(OE_OCALL_MALLOC, arg_in, &arg_out) != OE_OK)
     {
@@ -44,9 +51,32 @@ void* oe_host_realloc(void* ptr, size_t size)
 {
     oe_realloc_args_t* arg_in = NULL;
     uint64_t arg_out = 0;
+    size_t old_size;
+
+    /* Blocks of the untrusted heap are resized without leaving the enclave */
+    if ((old_size = oe_host_heap_block_size(ptr)))
+    {
+        void* new_ptr;
+
+        if (size == 0)
+        {
+            oe_host_free(ptr);
+            return NULL;
+        }
+
+        if (size <= old_size)
+            return ptr;
+
+        if (!(new_ptr = oe_host_malloc(size)))
+            return NULL;
+
+        oe_memcpy(new_ptr, ptr, old_size);
+        oe_host_free(ptr);
+        return new_ptr;
+    }
 
     if (!(arg_in =
-              (oe_realloc_args_t*)oe_host_calloc(1, sizeof(oe_realloc_args_t))))
+              (oe_realloc_args_t*)oe_scratch_calloc(sizeof(oe_realloc_args_t))))
         goto done;
 
     arg_in->ptr = ptr;
@@ -62,12 +92,15 @@ void* oe_host_realloc(void* ptr, size_t size)
         oe_abort();
 
 done:
-    oe_host_free(arg_in);
+    oe_scratch_free(arg_in);
     return (void*)arg_out;
 }
 
 void oe_host_free(void* ptr)
 {
+    if (oe_host_heap_free(ptr))
+        return;
+
     oe_ocall(OE_OCALL_FREE, (uint64_t)ptr, NULL);
 }
 
@@ -118,7 +151,7 @@ int oe_host_write(int device, const char* str, size_t len)
         OE_OK)
         goto done;
 
-    if (!(args = (oe_print_args_t*)oe_host_calloc(1, total_size)))
+    if (!(args = (oe_print_args_t*)oe_scratch_calloc(total_size)))
         goto done;
 
     /* Initialize the arguments */
@@ -137,7 +170,7 @@ int oe_host_write(int device, const char* str, size_t len)
     ret = 0;
 
 done:
-    oe_host_free(args);
+    oe_scratch_free(args);
     return ret;
 }
 
@@ -199,11 +232,11 @@ int oe_host_fprintf(int device, const char* fmt, ...)
 // Function used by oeedger8r for allocating ocall buffers.
 void* oe_allocate_ocall_buffer(size_t size)
 {
-    return oe_host_malloc(size);
+    return oe_scratch_malloc(size);
 }
 
 // Function used by oeedger8r for freeing ocall buffers.
 void oe_free_ocall_buffer(void* buffer)
 {
-    oe_host_free(buffer);
+    oe_scratch_free(buffer);
 }
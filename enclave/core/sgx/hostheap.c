@@ -0,0 +1,500 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "hostheap.h"
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Untrusted heap
+**
+**     Regions of host memory are carved into spans of OE_HOST_HEAP_SPAN_SIZE
+**     bytes. Each span serves blocks of a single size class (powers of two
+**     from 16 bytes to one span). All metadata (regions, span classes, list
+**     heads and counts) lives in enclave memory. Free blocks are linked
+**     through their first word, which lives in host memory. A link is only
+**     followed if it points to a block of the same size class, so a host
+**     that tampers with the lists cannot make the enclave use memory outside
+**     the regions. It can still make two allocations share a block, which
+**     gives it nothing it could not do by writing to untrusted memory.
+**
+**     Each TCS caches free blocks per size class in its td_t. Blocks move
+**     between a cache and the global lists in batches under a spinlock. An
+**     OCALL is only made to obtain a new region once all spans are in use.
+**
+**==============================================================================
+*/
+
+#define MIN_BLOCK_SHIFT 4
+#define NUM_CLASSES 13 /* 16 bytes .. 64 KiB */
+#define MAX_BLOCK_SIZE ((size_t)1 << (MIN_BLOCK_SHIFT + NUM_CLASSES - 1))
+#define MAX_REGIONS 64
+#define NO_CLASS 0xff
+
+/* Bytes of free blocks per size class kept in each thread cache */
+#define CACHE_BYTES (64 * 1024)
+
+/* Maximum number of blocks moved between a cache and the lists at once */
+#define MAX_BATCH 32
+
+OE_STATIC_ASSERT(MAX_BLOCK_SIZE == OE_HOST_HEAP_SPAN_SIZE);
+
+typedef struct _region
+{
+    uint8_t* base;
+    uint64_t size;
+
+    /* Size class of each span (NO_CLASS if not carved yet) */
+    uint8_t* span_classes;
+} region_t;
+
+typedef struct _size_class
+{
+    /* List of free blocks */
+    void* free_list;
+
+    /* Part of a span not handed out yet */
+    uint8_t* bump;
+    uint8_t* bump_end;
+} size_class_t;
+
+typedef struct _oe_host_heap_cache
+{
+    void* lists[NUM_CLASSES];
+    uint32_t counts[NUM_CLASSES];
+} oe_host_heap_cache_t;
+
+/* Regions are immutable once published by incrementing _num_regions */
+static region_t _regions[MAX_REGIONS];
+static volatile uint64_t _num_regions;
+static uint64_t _region_size;
+
+/* Next span to carve (in the most recent region) */
+static uint64_t _next_span;
+
+static size_class_t _classes[NUM_CLASSES];
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/* Set while a thread asks the host for a new region (without _lock) */
+static bool _growing;
+
+static size_t _class_size(uint32_t c)
+{
+    return (size_t)1 << (MIN_BLOCK_SHIFT + c);
+}
+
+static uint32_t _size_to_class(size_t size)
+{
+    uint32_t c = 0;
+
+    while (_class_size(c) < size)
+        c++;
+
+    return c;
+}
+
+static uint32_t _cache_capacity(uint32_t c)
+{
+    size_t n = CACHE_BYTES / _class_size(c);
+    return n ? (uint32_t)n : 1;
+}
+
+static uint32_t _batch_size(uint32_t c)
+{
+    uint32_t n = (_cache_capacity(c) + 1) / 2;
+    return n < MAX_BATCH ? n : MAX_BATCH;
+}
+
+/*
+**==============================================================================
+**
+** _find_block()
+**
+**     Determine whether ptr is the start of a block in a carved span and if
+**     so return its size class.
+**
+**==============================================================================
+*/
+
+static bool _find_block(const void* ptr, uint32_t* class_out)
+{
+    uint64_t n = _num_regions;
+    const uint8_t* p = (const uint8_t*)ptr;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    for (uint64_t i = 0; i < n; i++)
+    {
+        const region_t* r = &_regions[i];
+
+        if (p >= r->base && p < r->base + r->size)
+        {
+            uint64_t offset = (uint64_t)(p - r->base);
+            uint8_t c = r->span_classes[offset / OE_HOST_HEAP_SPAN_SIZE];
+
+            if (c == NO_CLASS || (offset % _class_size(c)) != 0)
+                return false;
+
+            *class_out = c;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Pop a block from a list, dropping the rest if the link was tampered with */
+static void* _pop(void** list, uint32_t c)
+{
+    void* block = *list;
+    void* next;
+    uint32_t next_class;
+
+    if (!block)
+        return NULL;
+
+    /* Read the link from host memory only once */
+    next = *(void* volatile*)block;
+
+    if (next && (!_find_block(next, &next_class) || next_class != c))
+        next = NULL;
+
+    *list = next;
+    return block;
+}
+
+static void _push(void** list, void* block)
+{
+    *(void* volatile*)block = *list;
+    *list = block;
+}
+
+/*
+**==============================================================================
+**
+** _add_region()
+**
+**     Publish a new region. Called with _lock held (or during initialization).
+**
+**==============================================================================
+*/
+
+static bool _add_region(void* base, uint64_t size)
+{
+    uint64_t n = _num_regions;
+    uint64_t num_spans = size / OE_HOST_HEAP_SPAN_SIZE;
+    uint8_t* span_classes;
+
+    if (n == MAX_REGIONS || !base || !num_spans ||
+        (size % OE_HOST_HEAP_SPAN_SIZE) != 0 ||
+        ((uint64_t)base % OE_HOST_HEAP_SPAN_SIZE) != 0 ||
+        !oe_is_outside_enclave(base, size))
+    {
+        return false;
+    }
+
+    if (!(span_classes = (uint8_t*)oe_malloc(num_spans)))
+        return false;
+
+    oe_memset(span_classes, NO_CLASS, num_spans);
+
+    _regions[n].base = (uint8_t*)base;
+    _regions[n].size = size;
+    _regions[n].span_classes = span_classes;
+    _next_span = 0;
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    _num_regions = n + 1;
+
+    return true;
+}
+
+/*
+**==============================================================================
+**
+** _carve_span()
+**
+**     Assign the next unused span to size class c, asking the host for a new
+**     region if necessary. Called with _lock held.
+**
+**     The lock is released during the OCALL so that other threads are not
+**     held up by it and so that a nested ECALL can allocate. Only one thread
+**     grows the heap at a time; meanwhile the others fail here, and
+**     oe_host_malloc() falls back to the OCALL for that request.
+**
+**==============================================================================
+*/
+
+static bool _carve_span(uint32_t c)
+{
+    region_t* r;
+
+    if (_num_regions == 0)
+        return false;
+
+    r = &_regions[_num_regions - 1];
+
+    if (_next_span == r->size / OE_HOST_HEAP_SPAN_SIZE)
+    {
+        uint64_t arg_out = 0;
+        oe_result_t result;
+        bool added;
+
+        if (_growing)
+            return false;
+
+        _growing = true;
+        oe_spin_unlock(&_lock);
+
+        result = oe_ocall(OE_OCALL_GROW_HOST_HEAP, _region_size, &arg_out);
+
+        oe_spin_lock(&_lock);
+        added = result == OE_OK && _add_region((void*)arg_out, _region_size);
+        _growing = false;
+
+        if (!added)
+            return false;
+
+        r = &_regions[_num_regions - 1];
+    }
+
+    r->span_classes[_next_span] = (uint8_t)c;
+    _classes[c].bump = r->base + _next_span * OE_HOST_HEAP_SPAN_SIZE;
+    _classes[c].bump_end = _classes[c].bump + OE_HOST_HEAP_SPAN_SIZE;
+    _next_span++;
+
+    return true;
+}
+
+/* Take up to count blocks of class c into list. Called with _lock held */
+static uint32_t _take_blocks(uint32_t c, void** list, uint32_t count)
+{
+    size_class_t* sc = &_classes[c];
+    size_t block_size = _class_size(c);
+    uint32_t n = 0;
+
+    while (n < count)
+    {
+        void* block;
+
+        if (sc->free_list)
+        {
+            block = _pop(&sc->free_list, c);
+        }
+        else
+        {
+            if (sc->bump == sc->bump_end && !_carve_span(c))
+                break;
+
+            block = sc->bump;
+            sc->bump += block_size;
+        }
+
+        _push(list, block);
+        n++;
+    }
+
+    return n;
+}
+
+static oe_host_heap_cache_t* _get_cache(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td->host_heap_cache)
+        td->host_heap_cache = oe_calloc(1, sizeof(oe_host_heap_cache_t));
+
+    return td->host_heap_cache;
+}
+
+/*
+**==============================================================================
+**
+** oe_init_host_heap()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_init_host_heap(void* base, uint64_t size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!base && !size)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    oe_spin_lock(&_lock);
+    {
+        if (_num_regions || !_add_region(base, size))
+        {
+            oe_spin_unlock(&_lock);
+            OE_RAISE(OE_INVALID_PARAMETER);
+        }
+
+        _region_size = size;
+    }
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_host_heap_malloc()
+**
+**==============================================================================
+*/
+
+void* oe_host_heap_malloc(size_t size)
+{
+    oe_host_heap_cache_t* cache;
+    uint32_t c;
+    void* block = NULL;
+
+    if (!_num_regions || size == 0 || size > MAX_BLOCK_SIZE)
+        return NULL;
+
+    c = _size_to_class(size);
+
+    /* Without a cache, take a single block from the global lists */
+    if (!(cache = _get_cache()))
+    {
+        oe_spin_lock(&_lock);
+        _take_blocks(c, &block, 1);
+        oe_spin_unlock(&_lock);
+        return block;
+    }
+
+    if (!cache->lists[c])
+    {
+        oe_spin_lock(&_lock);
+        cache->counts[c] = _take_blocks(c, &cache->lists[c], _batch_size(c));
+        oe_spin_unlock(&_lock);
+    }
+
+    if ((block = _pop(&cache->lists[c], c)))
+        cache->counts[c]--;
+
+    if (!cache->lists[c])
+        cache->counts[c] = 0;
+
+    return block;
+}
+
+/*
+**==============================================================================
+**
+** oe_host_heap_block_size()
+**
+**==============================================================================
+*/
+
+size_t oe_host_heap_block_size(const void* ptr)
+{
+    uint32_t c;
+
+    if (!ptr || !_find_block(ptr, &c))
+        return 0;
+
+    return _class_size(c);
+}
+
+/*
+**==============================================================================
+**
+** oe_host_heap_free()
+**
+**==============================================================================
+*/
+
+bool oe_host_heap_free(void* ptr)
+{
+    oe_host_heap_cache_t* cache;
+    uint32_t c;
+
+    if (!ptr || !_find_block(ptr, &c))
+        return false;
+
+    /* Without a cache, return the block to the global list */
+    if (!(cache = _get_cache()))
+    {
+        oe_spin_lock(&_lock);
+        _push(&_classes[c].free_list, ptr);
+        oe_spin_unlock(&_lock);
+        return true;
+    }
+
+    _push(&cache->lists[c], ptr);
+    cache->counts[c]++;
+
+    /* Return a batch to the global list once the cache is full */
+    if (cache->counts[c] > _cache_capacity(c))
+    {
+        uint32_t n = _batch_size(c);
+
+        oe_spin_lock(&_lock);
+        {
+            void* block;
+
+            while (n-- && (block = _pop(&cache->lists[c], c)))
+            {
+                _push(&_classes[c].free_list, block);
+                cache->counts[c]--;
+            }
+        }
+        oe_spin_unlock(&_lock);
+
+        if (!cache->lists[c])
+            cache->counts[c] = 0;
+    }
+
+    return true;
+}
+
+/*
+**==============================================================================
+**
+** oe_free_host_heap()
+**
+**==============================================================================
+*/
+
+void oe_free_host_heap(void)
+{
+    /* The blocks are host memory, which the host releases with the regions */
+    for (size_t i = 0; i < __oe_get_num_tcs(); i++)
+    {
+        td_t* td = td_from_tcs(__oe_get_tcs(i));
+
+        oe_free(td->host_heap_cache);
+        td->host_heap_cache = NULL;
+    }
+
+    oe_spin_lock(&_lock);
+    {
+        for (uint64_t i = 0; i < _num_regions; i++)
+        {
+            oe_free(_regions[i].span_classes);
+            oe_memset(&_regions[i], 0, sizeof(_regions[i]));
+        }
+
+        oe_memset(_classes, 0, sizeof(_classes));
+        _num_regions = 0;
+        _next_span = 0;
+    }
+    oe_spin_unlock(&_lock);
+}
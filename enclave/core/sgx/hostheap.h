@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_HOSTHEAP_H
+#define _OE_CORE_HOSTHEAP_H
+
+#include <openenclave/enclave.h>
+
+/* Register the first region of the untrusted heap (once) */
+oe_result_t oe_init_host_heap(void* base, uint64_t size);
+
+/*
+ * Allocate from the untrusted heap. Returns NULL if the heap is not
+ * configured, the size is not served by a size class, or the heap cannot
+ * grow; the caller then falls back to an OCALL.
+ */
+void* oe_host_heap_malloc(size_t size);
+
+/* Return the usable size of a block of the untrusted heap, or 0 if **ptr**
+ * does not belong to it */
+size_t oe_host_heap_block_size(const void* ptr);
+
+/* Release a block of the untrusted heap. Returns false (and does nothing) if
+ * **ptr** does not belong to it */
+bool oe_host_heap_free(void* ptr);
+
+/* Release the enclave memory of the untrusted heap (thread caches and region
+ * metadata). Called by the enclave destructor */
+void oe_free_host_heap(void);
+
+#endif /* _OE_CORE_HOSTHEAP_H */
@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "lockprofile.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/backtrace.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+
+#if defined(OE_USE_LOCK_PROFILING)
+
+/*
+**==============================================================================
+**
+** Profile table
+**
+**     An open-addressed table of entries keyed by a hash of the lock address
+**     and the call site. A thread claims a free slot by swapping its key in,
+**     fills in the lock and call site and then publishes the slot. Counters
+**     are updated with atomic adds, so recording never takes a lock. Once the
+**     table is full, acquisitions at new call sites are not recorded.
+**
+**==============================================================================
+*/
+
+/* Number of slots (a power of two) */
+#define LOCK_PROFILE_SLOTS 1024
+
+typedef struct _lock_profile_slot
+{
+    volatile uint64_t key;
+    volatile uint64_t published;
+    oe_lock_profile_entry_t entry;
+} lock_profile_slot_t;
+
+static lock_profile_slot_t _slots[LOCK_PROFILE_SLOTS];
+
+uint64_t oe_lock_profile_cycles(void)
+{
+    uint32_t lo;
+    uint32_t hi;
+
+    /* Requires RDTSC inside the enclave (SGX2 or simulation mode) */
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static uint64_t _hash(
+    const volatile void* lock,
+    void* const* frames,
+    int num_frames)
+{
+    uint64_t hash = (uint64_t)lock * 0x9e3779b97f4a7c15ULL;
+
+    for (int i = 0; i < num_frames; i++)
+        hash = (hash ^ (uint64_t)frames[i]) * 0x100000001b3ULL;
+
+    /* Zero marks a free slot */
+    return hash ? hash : 1;
+}
+
+static oe_lock_profile_entry_t* _get_entry(
+    oe_lock_type_t type,
+    const volatile void* lock,
+    void* const* frames,
+    int num_frames)
+{
+    uint64_t key = _hash(lock, frames, num_frames);
+
+    for (uint64_t i = 0; i < LOCK_PROFILE_SLOTS; i++)
+    {
+        lock_profile_slot_t* slot =
+            &_slots[(key + i) & (LOCK_PROFILE_SLOTS - 1)];
+
+        if (slot->key == 0 && oe_atomic_compare_and_swap(&slot->key, 0, key))
+        {
+            slot->entry.lock = (uint64_t)lock;
+            slot->entry.type = (uint32_t)type;
+            slot->entry.num_frames = (uint32_t)num_frames;
+
+            for (int j = 0; j < num_frames; j++)
+                slot->entry.frames[j] = (uint64_t)frames[j];
+
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            slot->published = 1;
+        }
+
+        if (slot->key == key)
+            return &slot->entry;
+    }
+
+    return NULL;
+}
+
+void oe_lock_profile_record(
+    oe_lock_type_t type,
+    const volatile void* lock,
+    const oe_lock_wait_t* wait)
+{
+    void* frames[OE_LOCK_PROFILE_FRAMES];
+    int num_frames;
+    oe_lock_profile_entry_t* entry;
+
+    if ((num_frames = oe_backtrace(frames, OE_LOCK_PROFILE_FRAMES)) < 0)
+        num_frames = 0;
+
+    if (!(entry = _get_entry(type, lock, frames, num_frames)))
+        return;
+
+    oe_atomic_increment((volatile uint64_t*)&entry->acquisitions);
+
+    if (wait->start)
+    {
+        uint64_t cycles = oe_lock_profile_cycles() - wait->start;
+
+        oe_atomic_increment((volatile uint64_t*)&entry->contended);
+        oe_atomic_add((volatile uint64_t*)&entry->spins, wait->spins);
+        oe_atomic_add((volatile uint64_t*)&entry->parks, wait->parks);
+        oe_atomic_add((volatile uint64_t*)&entry->wait_cycles, cycles);
+    }
+}
+
+/* Copy the published entries to the host buffer and return their number */
+static uint64_t _copy_entries(oe_lock_profile_entry_t* entries, uint64_t size)
+{
+    uint64_t n = 0;
+
+    for (size_t i = 0; i < LOCK_PROFILE_SLOTS; i++)
+    {
+        const lock_profile_slot_t* slot = &_slots[i];
+
+        if (!slot->published)
+            continue;
+
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        if (n < size)
+            entries[n] = slot->entry;
+
+        n++;
+    }
+
+    return n;
+}
+
+#endif /* defined(OE_USE_LOCK_PROFILING) */
+
+/*
+**==============================================================================
+**
+** oe_handle_get_lock_profile()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_get_lock_profile(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_lock_profile_args_t* host_args = (oe_get_lock_profile_args_t*)arg_in;
+
+    if (!host_args || !oe_is_outside_enclave(host_args, sizeof(*host_args)))
+        return OE_INVALID_PARAMETER;
+
+#if defined(OE_USE_LOCK_PROFILING)
+    {
+        oe_get_lock_profile_args_t args = *host_args;
+        uint64_t size;
+        uint64_t n;
+
+        OE_CHECK(oe_safe_mul_u64(
+            args.num_entries, sizeof(oe_lock_profile_entry_t), &size));
+
+        if (args.num_entries &&
+            (!args.entries || !oe_is_outside_enclave(args.entries, size)))
+            OE_RAISE(OE_INVALID_PARAMETER);
+
+        n = _copy_entries(args.entries, args.num_entries);
+        host_args->num_entries = n;
+
+        if (n > args.num_entries)
+            OE_RAISE_NO_TRACE(OE_BUFFER_TOO_SMALL);
+    }
+
+    result = OE_OK;
+#else
+    OE_RAISE_NO_TRACE(OE_UNSUPPORTED);
+#endif
+
+done:
+    host_args->result = result;
+    return result;
+}
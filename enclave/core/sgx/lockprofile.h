@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_LOCKPROFILE_H
+#define _OE_CORE_LOCKPROFILE_H
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/lockprofile.h>
+
+/*
+**==============================================================================
+**
+** Lock profiling hooks
+**
+**     A lock function declares an oe_lock_wait_t with OE_LOCK_WAIT(), marks
+**     the start of waiting with OE_LOCK_WAIT_BEGIN() (only the first call
+**     counts), counts spins and parks while waiting and calls
+**     OE_LOCK_ACQUIRED() once it holds the lock. Without OE_USE_LOCK_PROFILING
+**     all of these expand to nothing.
+**
+**     The recording code takes no lock, so spinlocks can be profiled too.
+**
+**==============================================================================
+*/
+
+#if defined(OE_USE_LOCK_PROFILING)
+
+typedef struct _oe_lock_wait
+{
+    /* Cycle counter when the thread began to wait (0 if it did not) */
+    uint64_t start;
+    uint64_t spins;
+    uint64_t parks;
+} oe_lock_wait_t;
+
+uint64_t oe_lock_profile_cycles(void);
+
+void oe_lock_profile_record(
+    oe_lock_type_t type,
+    const volatile void* lock,
+    const oe_lock_wait_t* wait);
+
+#define OE_LOCK_WAIT(WAIT) oe_lock_wait_t WAIT = {0, 0, 0}
+
+#define OE_LOCK_WAIT_BEGIN(WAIT)                     \
+    do                                               \
+    {                                                \
+        if (!(WAIT).start)                           \
+            (WAIT).start = oe_lock_profile_cycles(); \
+    } while (0)
+
+#define OE_LOCK_WAIT_SPINS(WAIT, N) ((WAIT).spins += (N))
+
+#define OE_LOCK_WAIT_PARK(WAIT) ((WAIT).parks++)
+
+#define OE_LOCK_ACQUIRED(TYPE, LOCK, WAIT) \
+    oe_lock_profile_record(TYPE, LOCK, &(WAIT))
+
+#else /* !defined(OE_USE_LOCK_PROFILING) */
+
+#define OE_LOCK_WAIT(WAIT)
+#define OE_LOCK_WAIT_BEGIN(WAIT)
+#define OE_LOCK_WAIT_SPINS(WAIT, N)
+#define OE_LOCK_WAIT_PARK(WAIT)
+#define OE_LOCK_ACQUIRED(TYPE, LOCK, WAIT)
+
+#endif /* !defined(OE_USE_LOCK_PROFILING) */
+
+/* Handle OE_ECALL_GET_LOCK_PROFILE from the host */
+oe_result_t oe_handle_get_lock_profile(uint64_t arg_in);
+
+#endif /* _OE_CORE_LOCKPROFILE_H */
@@ -10,6 +10,7 @@
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/thread.h>
 #include "debugmalloc.h"
+#include "threadcache.h"
 
 #define HAVE_MMAP 0
 #define LACKS_UNISTD_H
@@ -21,7 +22,7 @@
 #define USE_DL_PREFIX
 #define LACKS_STDLIB_H
 #define LACKS_STRING_H
-#define USE_LOCKS 1
+#define USE_LOCKS 2
 #define size_t size_t
 #define ptrdiff_t ptrdiff_t
 #define memset oe_memset
@@ -31,6 +32,15 @@
 
 typedef struct _FILE FILE;
 
+/* Serialize dlmalloc with the enclave's ticket spinlock */
+#define MLOCK_T oe_spinlock_t
+#define INITIAL_LOCK(lk) oe_spin_init(lk)
+#define DESTROY_LOCK(lk) oe_spin_destroy(lk)
+#define ACQUIRE_LOCK(lk) oe_spin_lock(lk)
+#define RELEASE_LOCK(lk) oe_spin_unlock(lk)
+#define TRY_LOCK(lk) (oe_spin_trylock(lk) == OE_OK)
+static MLOCK_T malloc_global_mutex = OE_SPINLOCK_INITIALIZER;
+
 static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic push
@@ -42,7 +52,20 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 
 #pragma GCC diagnostic pop
 
-/* Choose release mode or debug mode allocation functions */
+#if defined(OE_USE_THREAD_CACHE_MALLOC)
+/* dlmalloc holds this lock while it moves the break (see sys_trim()) */
+void oe_malloc_lock_morecore(void)
+{
+    ACQUIRE_MALLOC_GLOBAL_LOCK();
+}
+
+void oe_malloc_unlock_morecore(void)
+{
+    RELEASE_MALLOC_GLOBAL_LOCK();
+}
+#endif
+
+/* Choose debug mode, thread-caching or plain dlmalloc allocation functions */
 #if defined(OE_USE_DEBUG_MALLOC)
 #define MALLOC oe_debug_malloc
 #define CALLOC oe_debug_calloc
@@ -50,6 +73,13 @@ static int _dlmalloc_stats_fprintf(FILE* stream, const char* format, ...);
 #define MEMALIGN oe_debug_memalign
 #define POSIX_MEMALIGN oe_debug_posix_memalign
 #define FREE oe_debug_free
+#elif defined(OE_USE_THREAD_CACHE_MALLOC)
+#define MALLOC oe_thread_cache_malloc
+#define CALLOC oe_thread_cache_calloc
+#define REALLOC oe_thread_cache_realloc
+#define MEMALIGN oe_thread_cache_memalign
+#define POSIX_MEMALIGN oe_thread_cache_posix_memalign
+#define FREE oe_thread_cache_free
 #else
 #define MALLOC dlmalloc
 #define CALLOC dlcalloc
@@ -229,6 +259,11 @@ oe_result_t oe_get_malloc_stats(oe_malloc_stats_t* stats)
 
     *stats = _malloc_stats;
 
+#if !defined(OE_USE_DEBUG_MALLOC) && defined(OE_USE_THREAD_CACHE_MALLOC)
+    /* Spans of the thread caches are obtained outside dlmalloc */
+    oe_thread_cache_add_stats(stats);
+#endif
+
     result = OE_OK;
 
 done:
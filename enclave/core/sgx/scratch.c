@@ -0,0 +1,382 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "scratch.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include "td.h"
+
+/* Alignment of each scratch allocation */
+#define SCRATCH_ALIGNMENT 16
+
+/*
+ * Every allocation is followed by a trailer, so that the region forms a
+ * stack of frames that can be walked from the top. The trailers live in host
+ * memory: each value read from one is checked to lie below the trailer, so
+ * a host that tampers with them can at worst make frames overlap.
+ */
+typedef struct _scratch_trailer
+{
+    /* Offset of the allocation in the region */
+    uint64_t start;
+
+    /* Non-zero once the allocation was freed (out of order) */
+    uint64_t freed;
+} scratch_trailer_t;
+
+OE_STATIC_ASSERT(sizeof(scratch_trailer_t) % SCRATCH_ALIGNMENT == 0);
+
+/* Table of per-TCS scratch regions (in host memory) */
+static oe_scratch_region_t* _regions;
+static uint64_t _num_regions;
+
+/*
+**==============================================================================
+**
+** oe_init_scratch_regions()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_init_scratch_regions(
+    oe_scratch_region_t* regions,
+    uint64_t num_regions)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t size;
+
+    if (!regions || !num_regions)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    OE_CHECK(oe_safe_mul_u64(num_regions, sizeof(*regions), &size));
+
+    if (!oe_is_outside_enclave(regions, size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    _regions = regions;
+    _num_regions = num_regions;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _get_scratch_region()
+**
+**     Find the scratch region of the calling thread and cache it (and the
+**     deferred OCALL queue that goes with it) in its td_t. The region is
+**     validated once; the host cannot move it afterwards.
+**
+**==============================================================================
+*/
+
+static bool _get_scratch_region(td_t* td)
+{
+    if (td->scratch_base)
+        return true;
+
+    uint64_t tcs = (uint64_t)td_to_tcs(td);
+
+    for (uint64_t i = 0; i < _num_regions; i++)
+    {
+        /* Copy the entry into enclave memory to avoid TOCTOU issues */
+        oe_scratch_region_t region = _regions[i];
+
+        if (region.tcs != tcs)
+            continue;
+
+        if (!region.base || region.size < SCRATCH_ALIGNMENT ||
+            ((uint64_t)region.base % SCRATCH_ALIGNMENT) != 0 ||
+            !oe_is_outside_enclave(region.base, region.size))
+        {
+            return false;
+        }
+
+        /* The deferred OCALL queue is optional */
+        if (region.deferred_queue &&
+            region.deferred_queue_size > sizeof(oe_deferred_ocall_queue_t) &&
+            ((uint64_t)region.deferred_queue % OE_DEFERRED_OCALL_ALIGNMENT) ==
+                0 &&
+            oe_is_outside_enclave(
+                region.deferred_queue, region.deferred_queue_size))
+        {
+            td->deferred_queue = (uint64_t)region.deferred_queue;
+            td->deferred_size =
+                region.deferred_queue_size - sizeof(oe_deferred_ocall_queue_t);
+            td->deferred_used = 0;
+        }
+
+        td->scratch_base = (uint64_t)region.base;
+        td->scratch_size = region.size;
+        td->scratch_used = 0;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** oe_scratch_malloc()
+**
+**==============================================================================
+*/
+
+void* oe_scratch_malloc(size_t size)
+{
+    td_t* td = oe_get_td();
+    uint64_t frame_size;
+
+    if (size == 0 ||
+        size > OE_SIZE_MAX - SCRATCH_ALIGNMENT - sizeof(scratch_trailer_t))
+        return NULL;
+
+    frame_size = oe_round_up_to_multiple(size, SCRATCH_ALIGNMENT) +
+                 sizeof(scratch_trailer_t);
+
+    if (_get_scratch_region(td) &&
+        frame_size <= td->scratch_size - td->scratch_used)
+    {
+        uint64_t start = td->scratch_used;
+        volatile scratch_trailer_t* trailer =
+            (scratch_trailer_t*)(td->scratch_base + start + frame_size -
+                                 sizeof(scratch_trailer_t));
+
+        trailer->start = start;
+        trailer->freed = 0;
+        td->scratch_used += frame_size;
+
+        return (void*)(td->scratch_base + start);
+    }
+
+    return oe_host_malloc(size);
+}
+
+void* oe_scratch_calloc(size_t size)
+{
+    void* ptr = oe_scratch_malloc(size);
+
+    if (ptr)
+        oe_memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/*
+**==============================================================================
+**
+** oe_scratch_free()
+**
+**     Freeing the top frame rewinds the region to its start, together with
+**     the frames below it that were already freed. A frame freed out of
+**     order is only marked, and released once the frames above it are gone.
+**
+**==============================================================================
+*/
+
+/* Get the start and trailer of the frame that ends at top. Returns false if
+ * there is none or if the trailer is invalid */
+static bool _get_frame(
+    const td_t* td,
+    uint64_t top,
+    uint64_t* start,
+    volatile scratch_trailer_t** trailer_out)
+{
+    volatile scratch_trailer_t* trailer;
+
+    if (top < sizeof(scratch_trailer_t))
+        return false;
+
+    trailer = (scratch_trailer_t*)(td->scratch_base + top -
+                                   sizeof(scratch_trailer_t));
+    *start = trailer->start;
+    *trailer_out = trailer;
+
+    return *start <= top - sizeof(scratch_trailer_t) &&
+           (*start % SCRATCH_ALIGNMENT) == 0;
+}
+
+void oe_scratch_free(void* ptr)
+{
+    td_t* td = oe_get_td();
+    uint64_t addr = (uint64_t)ptr;
+    uint64_t offset;
+    uint64_t top;
+    uint64_t start;
+    volatile scratch_trailer_t* trailer;
+    bool found = false;
+
+    if (!ptr)
+        return;
+
+    if (!td->scratch_base || addr < td->scratch_base ||
+        addr >= td->scratch_base + td->scratch_size)
+    {
+        oe_host_free(ptr);
+        return;
+    }
+
+    /* Find the frame (ignore pointers that are not live allocations) */
+    offset = addr - td->scratch_base;
+
+    for (top = td->scratch_used; _get_frame(td, top, &start, &trailer);
+         top = start)
+    {
+        if (start == offset)
+        {
+            found = true;
+            break;
+        }
+
+        if (start < offset)
+            break;
+    }
+
+    if (!found)
+        return;
+
+    if (top != td->scratch_used)
+    {
+        trailer->freed = 1;
+        return;
+    }
+
+    /* Pop this frame and the freed frames below it */
+    td->scratch_used = start;
+
+    while (_get_frame(td, td->scratch_used, &start, &trailer) &&
+           trailer->freed)
+    {
+        td->scratch_used = start;
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_deferred_call_host_function()
+**
+**     Append a call to the deferred OCALL queue of the calling thread. The
+**     host runs the queue the next time the thread exits the enclave, so an
+**     OCALL is only made here when the queue is full.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    td_t* td = oe_get_td();
+    uint64_t record_size = OE_DEFERRED_OCALL_HEADER_SIZE;
+    uint8_t* record;
+    oe_call_host_function_args_t* args;
+
+    /* Reject invalid parameters */
+    if (!input_buffer || input_buffer_size == 0 || !output_buffer)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Keep every record aligned */
+    if ((input_buffer_size % OE_DEFERRED_OCALL_ALIGNMENT) != 0 ||
+        (output_buffer_size % OE_DEFERRED_OCALL_ALIGNMENT) != 0)
+    {
+        OE_RAISE(OE_INVALID_PARAMETER);
+    }
+
+    /* Without a queue, or if the call can never fit, call the host now */
+    if (!_get_scratch_region(td) || !td->deferred_queue ||
+        oe_safe_add_u64(record_size, input_buffer_size, &record_size) !=
+            OE_OK ||
+        oe_safe_add_u64(record_size, output_buffer_size, &record_size) !=
+            OE_OK ||
+        record_size > td->deferred_size)
+    {
+        size_t output_bytes_written = 0;
+
+        OE_CHECK(oe_call_host_function(
+            function_id,
+            input_buffer,
+            input_buffer_size,
+            output_buffer,
+            output_buffer_size,
+            &output_bytes_written));
+
+        result = OE_OK;
+        goto done;
+    }
+
+    /* Exit to let the host run the queue if the call does not fit */
+    if (record_size > td->deferred_size - td->deferred_used)
+        OE_CHECK(oe_ocall(OE_OCALL_FLUSH_DEFERRED, 0, NULL));
+
+    record = (uint8_t*)td->deferred_queue + sizeof(oe_deferred_ocall_queue_t) +
+             td->deferred_used;
+
+    args = (oe_call_host_function_args_t*)record;
+    args->function_id = function_id;
+    args->input_buffer = record + OE_DEFERRED_OCALL_HEADER_SIZE;
+    args->input_buffer_size = input_buffer_size;
+    args->output_buffer =
+        record + OE_DEFERRED_OCALL_HEADER_SIZE + input_buffer_size;
+    args->output_buffer_size = output_buffer_size;
+    args->output_bytes_written = 0;
+    args->result = OE_UNEXPECTED;
+
+    oe_memcpy(
+        record + OE_DEFERRED_OCALL_HEADER_SIZE,
+        input_buffer,
+        input_buffer_size);
+
+    /* Publish the record */
+    td->deferred_used += record_size;
+    ((oe_deferred_ocall_queue_t*)td->deferred_queue)->size = td->deferred_used;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_has_deferred_ocalls()
+**
+**==============================================================================
+*/
+
+bool oe_has_deferred_ocalls(void)
+{
+    return oe_get_td()->deferred_used != 0;
+}
+
+/*
+**==============================================================================
+**
+** oe_clear_deferred_ocalls()
+**
+**     Called right before the calling thread exits the enclave. The host runs
+**     the queued calls during that exit, so the queue starts over empty.
+**
+**==============================================================================
+*/
+
+void oe_clear_deferred_ocalls(void)
+{
+    oe_get_td()->deferred_used = 0;
+}
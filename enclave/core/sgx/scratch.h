@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_SCRATCH_H
+#define _OE_CORE_SCRATCH_H
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+
+/* Register the host's table of per-TCS scratch regions (once) */
+oe_result_t oe_init_scratch_regions(
+    oe_scratch_region_t* regions,
+    uint64_t num_regions);
+
+/*
+ * Allocate untrusted memory from the calling thread's scratch region. Falls
+ * back to oe_host_malloc() when the region is missing or full. Allocations
+ * are released with oe_scratch_free(); the space of one is reused once it
+ * and all later allocations have been released.
+ */
+void* oe_scratch_malloc(size_t size);
+
+/* Like oe_scratch_malloc() but zero-fills the memory */
+void* oe_scratch_calloc(size_t size);
+
+/* Release memory obtained with oe_scratch_malloc() (NULL is ignored) */
+void oe_scratch_free(void* ptr);
+
+/* Whether the calling thread queued deferred OCALLs since it last exited */
+bool oe_has_deferred_ocalls(void);
+
+/* Empty the queue (the host runs the queued calls when the thread exits) */
+void oe_clear_deferred_ocalls(void);
+
+#endif /* _OE_CORE_SCRATCH_H */
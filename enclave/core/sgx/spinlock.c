@@ -4,25 +4,62 @@
 #ifdef OE_BUILD_ENCLAVE
 #include <openenclave/enclave.h>
 #include <openenclave/internal/thread.h>
+#include "lockprofile.h"
 #else
 #include <openenclave/host.h>
 #endif
 
-/* Set the spinlock value to 1 and return the old value */
-static unsigned int _spin_set_locked(oe_spinlock_t* spinlock)
-{
-    unsigned int value = 1;
+/*
+**==============================================================================
+**
+** Ticket spinlock
+**
+**     The low 16 bits of the lock word hold the ticket being served and the
+**     high 16 bits the next ticket to hand out. A thread takes a ticket with
+**     a single atomic add and then only reads the lock word until its ticket
+**     is served, so threads acquire the lock in arrival order. While waiting,
+**     a thread pauses in proportion to the number of threads ahead of it,
+**     which keeps the waiters from polling the line the owner releases.
+**
+**     Only the owner writes the low 16 bits, so releasing the lock is a plain
+**     16-bit store. An all-zero word is an unlocked lock.
+**
+**==============================================================================
+*/
+
+#define TICKET_SHIFT 16
+#define TICKET_MASK 0xffff
 
-    asm volatile(
-        "lock xchg %0, %1;"
-        : "=r"(value)     /* %0 */
-        : "m"(*spinlock), /* %1 */
-          "0"(value)      /* also %2 */
-        : "memory");
+/* Pause iterations per thread ahead of the caller */
+#define BACKOFF_PAUSES 32
+
+/* Add value to the spinlock and return the old value */
+static uint32_t _spin_fetch_add(oe_spinlock_t* spinlock, uint32_t value)
+{
+    asm volatile("lock xaddl %0, %1;"
+                 : "+r"(value), "+m"(*spinlock) /* %0, %1 */
+                 :
+                 : "memory");
 
     return value;
 }
 
+/* Set the spinlock to new_value if it equals old_value */
+static bool _spin_compare_and_swap(
+    oe_spinlock_t* spinlock,
+    uint32_t old_value,
+    uint32_t new_value)
+{
+    uint32_t prev = old_value;
+
+    asm volatile("lock cmpxchgl %2, %1;"
+                 : "+a"(prev), "+m"(*spinlock) /* %0, %1 */
+                 : "r"(new_value)              /* %2 */
+                 : "memory");
+
+    return prev == old_value;
+}
+
 oe_result_t oe_spin_init(oe_spinlock_t* spinlock)
 {
     if (!spinlock)
@@ -35,32 +72,70 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock)
 
 oe_result_t oe_spin_lock(oe_spinlock_t* spinlock)
 {
+    uint16_t ticket;
+    uint16_t owner;
+    OE_LOCK_WAIT(wait);
+
     if (!spinlock)
         return OE_INVALID_PARAMETER;
 
-    while (_spin_set_locked((volatile unsigned int*)spinlock) != 0)
+    ticket = (uint16_t)(
+        _spin_fetch_add(spinlock, 1U << TICKET_SHIFT) >> TICKET_SHIFT);
+
+    while ((owner = (uint16_t)(*spinlock & TICKET_MASK)) != ticket)
     {
-        /* Spin while waiting for spinlock to be released (become 1) */
-        while (*spinlock)
-        {
-            /* Yield to CPU */
+        uint32_t pauses = (uint16_t)(ticket - owner) * BACKOFF_PAUSES;
+
+        OE_LOCK_WAIT_BEGIN(wait);
+        OE_LOCK_WAIT_SPINS(wait, pauses);
+
+        /* Yield to CPU */
+        while (pauses--)
             asm volatile("pause");
-        }
     }
 
+    /* Keep the critical section after the acquisition */
+    asm volatile("" ::: "memory");
+
+    OE_LOCK_ACQUIRED(OE_LOCK_TYPE_SPINLOCK, spinlock, wait);
+
+    return OE_OK;
+}
+
+oe_result_t oe_spin_trylock(oe_spinlock_t* spinlock)
+{
+    uint32_t value;
+
+    if (!spinlock)
+        return OE_INVALID_PARAMETER;
+
+    value = *spinlock;
+
+    /* Fail if the lock is held or other threads wait for it */
+    if ((value & TICKET_MASK) != (value >> TICKET_SHIFT))
+        return OE_BUSY;
+
+    if (!_spin_compare_and_swap(
+            spinlock, value, value + (1U << TICKET_SHIFT)))
+        return OE_BUSY;
+
     return OE_OK;
 }
 
 oe_result_t oe_spin_unlock(oe_spinlock_t* spinlock)
 {
+    uint16_t owner;
+
     if (!spinlock)
         return OE_INVALID_PARAMETER;
 
-    asm volatile(
-        "movl %0, %1;"
-        :
-        : "r"(OE_SPINLOCK_INITIALIZER), "m"(*spinlock) /* %1 */
-        : "memory");
+    owner = (uint16_t)((*spinlock & TICKET_MASK) + 1);
+
+    /* Serve the next ticket (a release store on x86) */
+    asm volatile("movw %0, %1;"
+                 :
+                 : "r"(owner), "m"(*(volatile uint16_t*)spinlock)
+                 : "memory");
 
     return OE_OK;
 }
@@ -0,0 +1,284 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/switchless.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "scratch.h"
+
+/* Ring of slots serviced by the host workers (set once by the host) */
+static oe_switchless_slot_t* _slots;
+static uint64_t _num_slots;
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/*
+**==============================================================================
+**
+** oe_handle_init_switchless()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_init_switchless(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_init_switchless_args_t args;
+    size_t slots_size;
+
+    if (!oe_is_outside_enclave((void*)arg_in, sizeof(args)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Copy structure into enclave memory */
+    args = *(oe_init_switchless_args_t*)arg_in;
+
+    if (args.num_slots == 0 ||
+        args.num_slots > OE_SWITCHLESS_MAX_HOST_WORKERS)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(
+        oe_safe_mul_u64(
+            args.num_slots, sizeof(oe_switchless_slot_t), &slots_size));
+
+    if (!oe_is_outside_enclave(args.slots, slots_size))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    oe_spin_lock(&_lock);
+    {
+        /* The ring can only be registered once */
+        if (_slots)
+        {
+            oe_spin_unlock(&_lock);
+            OE_RAISE(OE_UNEXPECTED);
+        }
+
+        _num_slots = args.num_slots;
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        _slots = args.slots;
+    }
+    oe_spin_unlock(&_lock);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** _claim_slot()
+**
+**     Claim a free slot, starting the search at a position derived from the
+**     calling thread so that threads spread over the ring.
+**
+**==============================================================================
+*/
+
+static oe_switchless_slot_t* _claim_slot(
+    oe_switchless_slot_t* slots,
+    uint64_t num_slots)
+{
+    uint64_t start = ((uint64_t)oe_get_thread_data() / OE_PAGE_SIZE);
+
+    for (uint64_t i = 0; i < num_slots; i++)
+    {
+        oe_switchless_slot_t* slot = &slots[(start + i) % num_slots];
+
+        if (slot->state == OE_SWITCHLESS_SLOT_FREE &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_FREE,
+                OE_SWITCHLESS_SLOT_RESERVED))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_host_function()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_slot_t* slots = _slots;
+    oe_switchless_slot_t* slot = NULL;
+    uint64_t state;
+
+    /* Reject invalid parameters */
+    if (!input_buffer || input_buffer_size == 0)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* A regular OCALL runs the deferred OCALLs first and so keeps them in
+     * order with this call */
+    if (oe_has_deferred_ocalls())
+        goto fallback;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    /* Without host workers or a free slot, perform a regular OCALL */
+    if (!slots || !(slot = _claim_slot(slots, _num_slots)))
+        goto fallback;
+
+    /* Fill in the arguments and post the call */
+    slot->args.function_id = function_id;
+    slot->args.input_buffer = input_buffer;
+    slot->args.input_buffer_size = input_buffer_size;
+    slot->args.output_buffer = output_buffer;
+    slot->args.output_buffer_size = output_buffer_size;
+    slot->args.output_bytes_written = 0;
+    slot->args.result = OE_UNEXPECTED;
+    slot->result = OE_UNEXPECTED;
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    slot->state = OE_SWITCHLESS_SLOT_POSTED;
+
+    /* Wait for a worker to pick up the call */
+    for (size_t i = 0; i < OE_SWITCHLESS_PICKUP_SPIN_COUNT; i++)
+    {
+        if (slot->state != OE_SWITCHLESS_SLOT_POSTED)
+            break;
+
+        oe_cpu_relax();
+    }
+
+    /* If still not picked up, retract the call and fall back */
+    if (oe_atomic_compare_and_swap(
+            &slot->state,
+            OE_SWITCHLESS_SLOT_POSTED,
+            OE_SWITCHLESS_SLOT_FREE))
+    {
+        goto fallback;
+    }
+
+    /* A worker is running the call; wait for it to complete. If the host
+     * function blocks, stop spinning and sleep outside the enclave */
+    for (uint64_t i = 0; (state = slot->state) != OE_SWITCHLESS_SLOT_DONE; i++)
+    {
+        /* The host owns this memory and may have corrupted the state */
+        if (state != OE_SWITCHLESS_SLOT_RUNNING)
+            oe_abort();
+
+        if (i < OE_SWITCHLESS_COMPLETION_SPIN_COUNT)
+        {
+            oe_cpu_relax();
+        }
+        else
+        {
+            uint64_t waits = i - OE_SWITCHLESS_COMPLETION_SPIN_COUNT;
+            uint64_t milliseconds =
+                waits < OE_SWITCHLESS_COMPLETION_YIELD_COUNT ? 0 : 1;
+
+            oe_ocall(OE_OCALL_SLEEP, milliseconds, NULL);
+        }
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    /* Check the transport result, then the result of the call */
+    result = slot->result;
+
+    if (result == OE_OK)
+        result = slot->args.result;
+
+    if (result == OE_OK)
+        *output_bytes_written = slot->args.output_bytes_written;
+
+    /* Release the slot */
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    slot->state = OE_SWITCHLESS_SLOT_FREE;
+
+    OE_CHECK(result);
+
+    result = OE_OK;
+
+done:
+    return result;
+
+fallback:
+    return oe_call_host_function(
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_switchless_worker()
+**
+**     Body of an enclave worker. Polls the given slot for ECALLs posted by
+**     the host and dispatches them without leaving the enclave. A worker that
+**     stays idle for OE_SWITCHLESS_WORKER_SPIN_COUNT iterations gives up its
+**     CPU with a sleep OCALL between polls. Returns once the host moves the
+**     slot to OE_SWITCHLESS_SLOT_STOP.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_ecall_slot_t* slot = (oe_switchless_ecall_slot_t*)arg_in;
+    uint64_t idle = 0;
+    uint64_t state;
+
+    if (!oe_is_outside_enclave(slot, sizeof(oe_switchless_ecall_slot_t)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    while ((state = slot->state) != OE_SWITCHLESS_SLOT_STOP)
+    {
+        if (state == OE_SWITCHLESS_SLOT_POSTED &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_RUNNING))
+        {
+            OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+            slot->result =
+                oe_handle_call_enclave_function((uint64_t)&slot->args);
+
+            /* Publish the results before handing the slot back */
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            slot->state = OE_SWITCHLESS_SLOT_DONE;
+            idle = 0;
+        }
+        else if (++idle < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+        {
+            oe_cpu_relax();
+        }
+        else
+        {
+            oe_ocall(OE_OCALL_SLEEP, 0, NULL);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
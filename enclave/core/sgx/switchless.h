@@ -0,0 +1,18 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_SWITCHLESS_H
+#define _OE_CORE_SWITCHLESS_H
+
+#include <openenclave/enclave.h>
+
+/* Handle OE_ECALL_INIT_SWITCHLESS from the host */
+oe_result_t oe_handle_init_switchless(uint64_t arg_in);
+
+/* Handle OE_ECALL_SWITCHLESS_WORKER from the host */
+oe_result_t oe_handle_switchless_worker(uint64_t arg_in);
+
+/* Dispatch an oe_call_enclave_function_args_t (defined in calls.c) */
+oe_result_t oe_handle_call_enclave_function(uint64_t arg_in);
+
+#endif /* _OE_CORE_SWITCHLESS_H */
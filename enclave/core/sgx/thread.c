@@ -4,11 +4,15 @@
 #include "thread.h"
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/enclavelibc.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/sgxtypes.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "lockprofile.h"
+#include "scratch.h"
 #include "td.h"
 
 /*
@@ -29,6 +33,29 @@ static int _thread_wait(oe_thread_data_t* self)
     return 0;
 }
 
+/* Wait until the deadline. Return 1 on timeout, 0 if woken, -1 on error */
+static int _thread_wait_timeout(oe_thread_data_t* self, uint64_t deadline)
+{
+    int ret = -1;
+    oe_thread_wait_timeout_args_t* args = NULL;
+
+    if (!(args = oe_scratch_calloc(sizeof(oe_thread_wait_timeout_args_t))))
+        goto done;
+
+    args->tcs = td_to_tcs((td_t*)self);
+    args->deadline = deadline;
+    args->result = OE_UNEXPECTED;
+
+    if (oe_ocall(OE_OCALL_THREAD_WAIT_TIMEOUT, (uint64_t)args, NULL) != OE_OK)
+        goto done;
+
+    ret = (args->result == OE_TIMEDOUT) ? 1 : 0;
+
+done:
+    oe_scratch_free(args);
+    return ret;
+}
+
 static int _thread_wake(oe_thread_data_t* self)
 {
     const void* tcs = td_to_tcs((td_t*)self);
@@ -44,7 +71,7 @@ static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
     int ret = -1;
     oe_thread_wake_wait_args_t* args = NULL;
 
-    if (!(args = oe_host_calloc(1, sizeof(oe_thread_wake_wait_args_t))))
+    if (!(args = oe_scratch_calloc(sizeof(oe_thread_wake_wait_args_t))))
         goto done;
 
     args->waiter_tcs = td_to_tcs((td_t*)waiter);
@@ -56,7 +83,7 @@ static int _thread_wake_wait(oe_thread_data_t* waiter, oe_thread_data_t* self)
     ret = 0;
 
 done:
-    oe_host_free(args);
+    oe_scratch_free(args);
     return ret;
 }
 
@@ -114,11 +141,63 @@ static bool _queue_contains(Queue* queue, oe_thread_data_t* thread)
     return false;
 }
 
+static void _queue_remove(Queue* queue, oe_thread_data_t* thread)
+{
+    oe_thread_data_t* prev = NULL;
+    oe_thread_data_t* p;
+
+    for (p = queue->front; p; prev = p, p = p->next)
+    {
+        if (p == thread)
+        {
+            if (prev)
+                prev->next = p->next;
+            else
+                queue->front = p->next;
+
+            if (queue->back == p)
+                queue->back = prev;
+
+            return;
+        }
+    }
+}
+
 static __inline__ bool _queue_empty(Queue* queue)
 {
     return queue->front ? false : true;
 }
 
+/* Wake all threads of a queue (which is left empty) with a single OCALL */
+static void _queue_wake_all(Queue* queue)
+{
+    oe_thread_wake_multiple_args_t* args = NULL;
+    oe_thread_data_t* p;
+    size_t n = 0;
+
+    for (p = queue->front; p; p = p->next)
+        n++;
+
+    if (n > 1 &&
+        (args = oe_scratch_malloc(
+             sizeof(oe_thread_wake_multiple_args_t) + n * sizeof(void*))))
+    {
+        args->num_tcs = 0;
+
+        // A woken thread may immediately use a synchronization primitive
+        // that modifies its next field, so collect all TCSs before waking.
+        while ((p = _queue_pop_front(queue)))
+            args->tcs[args->num_tcs++] = td_to_tcs((td_t*)p);
+
+        oe_ocall(OE_OCALL_THREAD_WAKE_MULTIPLE, (uint64_t)args, NULL);
+        oe_scratch_free(args);
+        return;
+    }
+
+    while ((p = _queue_pop_front(queue)))
+        _thread_wake(p);
+}
+
 /*
 **==============================================================================
 **
@@ -142,9 +221,27 @@ bool oe_thread_equal(oe_thread_t thread1, oe_thread_t thread2)
 **
 ** oe_mutex_t
 **
+**     The owner field is claimed with a compare-and-swap, so an uncontended
+**     lock or unlock does not take the spinlock. A thread that finds the
+**     mutex held first spins on the owner field, and only if the mutex is
+**     still held after that does it join the wait queue and ask the host to
+**     park it (an OCALL). Releasing the mutex wakes the thread at the front
+**     of the queue, which then competes for the mutex again.
+**
+**     The spin limit adapts to each mutex: spin_estimate tracks how many
+**     iterations recent spinning threads needed to obtain the mutex (the
+**     enclave has no cheap clock to measure hold times with), and a thread
+**     spins for up to twice that many.
+**
 **==============================================================================
 */
 
+/* Maximum number of iterations a thread spins before it parks */
+#define MUTEX_MAX_SPINS 1000
+
+/* Minimum number of iterations a thread spins before it parks */
+#define MUTEX_MIN_SPINS 16
+
 /* Internal mutex implementation */
 typedef struct _oe_mutex_impl
 {
@@ -155,10 +252,13 @@ typedef struct _oe_mutex_impl
     unsigned int refs;
 
     /* The thread that has locked this mutex */
-    oe_thread_data_t* owner;
+    oe_thread_data_t* volatile owner;
 
-    /* Queue of waiting threads (front holds the mutex) */
+    /* Queue of waiting threads */
     Queue queue;
+
+    /* Moving average of the spins needed to obtain the mutex */
+    uint32_t spin_estimate;
 } oe_mutex_impl_t;
 
 OE_STATIC_ASSERT(sizeof(oe_mutex_impl_t) <= sizeof(oe_mutex_t));
@@ -179,75 +279,114 @@ oe_result_t oe_mutex_init(oe_mutex_t* mutex)
     return result;
 }
 
-/* Caller manages the spinlock */
-static int _mutex_lock(oe_mutex_impl_t* m, oe_thread_data_t* self)
+/* Attempt to obtain the mutex (also a full memory barrier) */
+static bool _mutex_try_lock(oe_mutex_impl_t* m, oe_thread_data_t* self)
 {
-    /* If this thread has already locked the mutex */
-    if (m->owner == self)
-    {
-        /* Increase the reference count */
-        m->refs++;
-        return 0;
-    }
+    if (!oe_atomic_compare_and_swap(
+            (volatile uint64_t*)&m->owner, 0, (uint64_t)self))
+        return false;
+
+    m->refs = 1;
+    return true;
+}
 
-    /* If no thread has locked this mutex yet */
-    if (m->owner == NULL)
+/* Spin for a while on a mutex held by another thread */
+static bool _mutex_spin(
+    oe_mutex_impl_t* m,
+    oe_thread_data_t* self,
+    uint32_t* spins_out)
+{
+    uint32_t estimate = m->spin_estimate;
+    uint32_t limit = estimate * 2 + MUTEX_MIN_SPINS;
+    uint32_t spins = 0;
+    bool locked = false;
+
+    if (limit > MUTEX_MAX_SPINS)
+        limit = MUTEX_MAX_SPINS;
+
+    while (spins < limit)
     {
-        /* If the waiters queue is empty */
-        if (m->queue.front == NULL)
-        {
-            /* Obtain the mutex */
-            m->owner = self;
-            m->refs = 1;
-            return 0;
-        }
+        spins++;
 
-        /* If this thread is at the front of the waiters queue */
-        if (m->queue.front == self)
+        if (m->owner == NULL && _mutex_try_lock(m, self))
         {
-            /* Remove this thread from front of the waiters queue */
-            _queue_pop_front(&m->queue);
-
-            /* Obtain the mutex */
-            m->owner = self;
-            m->refs = 1;
-            return 0;
+            locked = true;
+            break;
         }
+
+        oe_cpu_relax();
     }
 
-    return -1;
+    /* Move the estimate an eighth of the way towards this attempt */
+    m->spin_estimate = (uint32_t)((int32_t)estimate +
+                                  ((int32_t)spins - (int32_t)estimate) / 8);
+
+    *spins_out = spins;
+    return locked;
 }
 
 oe_result_t oe_mutex_lock(oe_mutex_t* mutex)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
     oe_thread_data_t* self = oe_get_thread_data();
+    td_t* td = (td_t*)self;
+    uint32_t spins = 0;
+    OE_LOCK_WAIT(wait);
 
     if (!m)
         return OE_INVALID_PARAMETER;
 
+    /* If this thread has already locked the mutex */
+    if (m->owner == self)
+    {
+        /* Increase the reference count */
+        m->refs++;
+        return OE_OK;
+    }
+
+    if (_mutex_try_lock(m, self))
+    {
+        OE_LOCK_ACQUIRED(OE_LOCK_TYPE_MUTEX, m, wait);
+        return OE_OK;
+    }
+
+    OE_LOCK_WAIT_BEGIN(wait);
+
+    if (_mutex_spin(m, self, &spins))
+    {
+        OE_LOCK_WAIT_SPINS(wait, spins);
+        OE_LOCK_ACQUIRED(OE_LOCK_TYPE_MUTEX, m, wait);
+        return OE_OK;
+    }
+
+    OE_LOCK_WAIT_SPINS(wait, spins);
+
     /* Loop until SELF obtains mutex */
     for (;;)
     {
         oe_spin_lock(&m->lock);
         {
-            /* Attempt to acquire lock */
-            if (_mutex_lock(m, self) == 0)
+            /* A thread woken by oe_mutex_unlock() was removed from the queue */
+            if (!td->mutex_queued)
             {
-                oe_spin_unlock(&m->lock);
-                return OE_OK;
+                _queue_push_back(&m->queue, self);
+                td->mutex_queued = 1;
             }
 
-            /* If the waiters queue does not contain this thread */
-            if (!_queue_contains(&m->queue, self))
+            /* Check again now that unlocking threads will see the queue */
+            if (_mutex_try_lock(m, self))
             {
-                /* Insert thread at back of waiters queue */
-                _queue_push_back(&m->queue, self);
+                _queue_remove(&m->queue, self);
+                td->mutex_queued = 0;
+                oe_spin_unlock(&m->lock);
+                OE_LOCK_ACQUIRED(OE_LOCK_TYPE_MUTEX, m, wait);
+                return OE_OK;
             }
         }
         oe_spin_unlock(&m->lock);
 
         /* Ask host to wait for an event on this thread */
+        OE_LOCK_WAIT_PARK(wait);
         _thread_wait(self);
     }
 
@@ -262,16 +401,16 @@ oe_result_t oe_mutex_trylock(oe_mutex_t* mutex)
     if (!m)
         return OE_INVALID_PARAMETER;
 
-    oe_spin_lock(&m->lock);
+    /* If this thread has already locked the mutex */
+    if (m->owner == self)
     {
-        /* Attempt to acquire lock */
-        if (_mutex_lock(m, self) == 0)
-        {
-            oe_spin_unlock(&m->lock);
-            return OE_OK;
-        }
+        /* Increase the reference count */
+        m->refs++;
+        return OE_OK;
     }
-    oe_spin_unlock(&m->lock);
+
+    if (_mutex_try_lock(m, self))
+        return OE_OK;
 
     return OE_BUSY;
 }
@@ -280,29 +419,32 @@ static int _mutex_unlock(oe_mutex_t* mutex, oe_thread_data_t** waiter)
 {
     oe_mutex_impl_t* m = (oe_mutex_impl_t*)mutex;
     oe_thread_data_t* self = oe_get_thread_data();
-    int ret = -1;
 
-    oe_spin_lock(&m->lock);
-    {
-        /* If this thread has the mutex locked */
-        if (m->owner == self)
-        {
-            /* If decreasing the reference count causes it to become zero */
-            if (--m->refs == 0)
-            {
-                /* Thread no longer has this mutex locked */
-                m->owner = NULL;
+    /* If this thread does not have the mutex locked */
+    if (m->owner != self)
+        return -1;
 
-                /* Set waiter to the next thread on the queue (maybe none) */
-                *waiter = m->queue.front;
-            }
+    /* If decreasing the reference count leaves it locked */
+    if (--m->refs != 0)
+        return 0;
 
-            ret = 0;
+    /* Release the mutex (also a full memory barrier) */
+    oe_atomic_compare_and_swap(
+        (volatile uint64_t*)&m->owner, (uint64_t)self, 0);
+
+    /* Waiters queue themselves before their last attempt to obtain it */
+    if (m->queue.front)
+    {
+        oe_spin_lock(&m->lock);
+        {
+            /* Set waiter to the next thread on the queue (maybe none) */
+            if ((*waiter = _queue_pop_front(&m->queue)))
+                ((td_t*)*waiter)->mutex_queued = 0;
         }
+        oe_spin_unlock(&m->lock);
     }
-    oe_spin_unlock(&m->lock);
 
-    return ret;
+    return 0;
 }
 
 oe_result_t oe_mutex_unlock(oe_mutex_t* m)
@@ -407,17 +549,23 @@ oe_result_t oe_cond_destroy(oe_cond_t* condition)
     return OE_OK;
 }
 
-oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+/* Wait on the condition (until the deadline if not NULL) */
+static oe_result_t _cond_wait(
+    oe_cond_impl_t* cond,
+    oe_mutex_t* mutex,
+    const uint64_t* deadline)
 {
-    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
     oe_thread_data_t* self = oe_get_thread_data();
+    oe_result_t result = OE_OK;
+    OE_LOCK_WAIT(wait);
 
-    if (!cond || !mutex)
-        return OE_INVALID_PARAMETER;
+    /* Every wait counts as contended; it lasts until the thread is woken */
+    OE_LOCK_WAIT_BEGIN(wait);
 
     oe_spin_lock(&cond->lock);
     {
         oe_thread_data_t* waiter = NULL;
+        int timed_out = 0;
 
         /* Add the self thread to the end of the wait queue */
         _queue_push_back((Queue*)&cond->queue, self);
@@ -425,6 +573,7 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
         /* Unlock this mutex and get the waiter at the front of the queue */
         if (_mutex_unlock(mutex, &waiter) != 0)
         {
+            _queue_remove((Queue*)&cond->queue, self);
             oe_spin_unlock(&cond->lock);
             return OE_BUSY;
         }
@@ -433,14 +582,25 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
         {
             oe_spin_unlock(&cond->lock);
             {
-                if (waiter)
+                OE_LOCK_WAIT_PARK(wait);
+
+                if (waiter && !deadline)
                 {
                     _thread_wake_wait(waiter, self);
                     waiter = NULL;
                 }
                 else
                 {
-                    _thread_wait(self);
+                    if (waiter)
+                    {
+                        _thread_wake(waiter);
+                        waiter = NULL;
+                    }
+
+                    if (deadline)
+                        timed_out = _thread_wait_timeout(self, *deadline);
+                    else
+                        _thread_wait(self);
                 }
             }
             oe_spin_lock(&cond->lock);
@@ -448,12 +608,44 @@ oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
             /* If self is no longer in the queue, then it was selected */
             if (!_queue_contains((Queue*)&cond->queue, self))
                 break;
+
+            /* Leave the queue so that no signal is spent on this thread */
+            if (timed_out)
+            {
+                _queue_remove((Queue*)&cond->queue, self);
+                result = OE_TIMEDOUT;
+                break;
+            }
         }
     }
     oe_spin_unlock(&cond->lock);
+    OE_LOCK_ACQUIRED(OE_LOCK_TYPE_COND, cond, wait);
     oe_mutex_lock(mutex);
 
-    return OE_OK;
+    return result;
+}
+
+oe_result_t oe_cond_wait(oe_cond_t* condition, oe_mutex_t* mutex)
+{
+    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
+
+    if (!cond || !mutex)
+        return OE_INVALID_PARAMETER;
+
+    return _cond_wait(cond, mutex, NULL);
+}
+
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* condition,
+    oe_mutex_t* mutex,
+    uint64_t deadline)
+{
+    oe_cond_impl_t* cond = (oe_cond_impl_t*)condition;
+
+    if (!cond || !mutex)
+        return OE_INVALID_PARAMETER;
+
+    return _cond_wait(cond, mutex, &deadline);
 }
 
 oe_result_t oe_cond_signal(oe_cond_t* condition)
@@ -492,15 +684,7 @@ oe_result_t oe_cond_broadcast(oe_cond_t* condition)
     }
     oe_spin_unlock(&cond->lock);
 
-    oe_thread_data_t* p_next = NULL;
-    for (oe_thread_data_t* p = waiters.front; p; p = p_next)
-    {
-        // p could wake up and immediately use a synchronization
-        // primitive that could modify the next field.
-        // Therefore fetch the next thread before waking up p.
-        p_next = p->next;
-        _thread_wake(p);
-    }
+    _queue_wake_all(&waiters);
 
     return OE_OK;
 }
@@ -510,16 +694,57 @@ oe_result_t oe_cond_broadcast(oe_cond_t* condition)
 **
 ** oe_rwlock_t
 **
+**     Read locks are reader-biased. While the bias of a lock is set, a reader
+**     publishes the lock in a free slot of its own cache line in the reader
+**     table instead of updating the shared reader count, so readers of
+**     read-mostly data do not contend. A writer first revokes the bias, then
+**     waits until no slot holds the lock; readers that find the bias revoked
+**     use the counter under the spinlock. The bias is restored once
+**     RWLOCK_BIAS_INHIBIT reads have gone through the slow path.
+**
+**     A writer spins for RWLOCK_WRITER_SPIN_COUNT iterations while slots
+**     hold the lock. Then it queues itself, marks the bias as having a
+**     waiting writer and sleeps; a reader that leaves its slot and finds the
+**     mark wakes it once the reader table holds no slot for the lock.
+**
+**     A thread obtains its cache line on first use. Threads beyond
+**     RWLOCK_READER_LINES share lines, which only costs scalability.
+**
 **==============================================================================
 */
 
+/* Number of cache lines in the reader table */
+#define RWLOCK_READER_LINES 64
+
+/* Number of read locks a thread can hold through its cache line */
+#define RWLOCK_READER_SLOTS 8
+
+/* Number of slow-path reads after which the reader bias is restored */
+#define RWLOCK_BIAS_INHIBIT 64
+
+/* Iterations a writer spins on the reader table before it sleeps */
+#define RWLOCK_WRITER_SPIN_COUNT 1024
+
+/* Values of reader_bias */
+#define RWLOCK_BIAS_REVOKED 0
+#define RWLOCK_BIAS_SET 1
+#define RWLOCK_BIAS_WRITER_WAITING 2 /* Revoked, and a writer sleeps */
+
+typedef struct _reader_line
+{
+    void* volatile slots[RWLOCK_READER_SLOTS];
+} OE_ALIGNED(64) reader_line_t;
+
+static reader_line_t _reader_table[RWLOCK_READER_LINES];
+static volatile uint64_t _num_reader_lines;
+
 /* Internal readers-writer lock variable implementation. */
 typedef struct _oe_rwlock_impl
 {
     /* Spinlock for synchronizing readers and writers.*/
     oe_spinlock_t lock;
 
-    /* Number of reader threads owning this lock. */
+    /* Number of reader threads owning this lock (outside the reader table) */
     uint32_t readers;
 
     /* The writer thread that currently owns this lock.*/
@@ -528,10 +753,132 @@ typedef struct _oe_rwlock_impl
     /* Queue of threads waiting on this variable. */
     Queue queue;
 
+    /* Whether readers may use the reader table (RWLOCK_BIAS_*). */
+    volatile uint64_t reader_bias;
+
+    /* Slow-path reads left before the bias is restored. */
+    uint64_t bias_inhibit;
+
 } oe_rwlock_impl_t;
 
 OE_STATIC_ASSERT(sizeof(oe_rwlock_impl_t) <= sizeof(oe_rwlock_t));
 
+static reader_line_t* _get_reader_line(void)
+{
+    td_t* td = oe_get_td();
+
+    if (!td->rwlock_reader_line)
+        td->rwlock_reader_line = oe_atomic_increment(&_num_reader_lines);
+
+    return &_reader_table[(td->rwlock_reader_line - 1) % RWLOCK_READER_LINES];
+}
+
+/* Try to obtain a read lock through the reader table */
+static bool _rwlock_fast_rdlock(oe_rwlock_impl_t* rw_lock)
+{
+    reader_line_t* line;
+
+    if (rw_lock->reader_bias != RWLOCK_BIAS_SET)
+        return false;
+
+    line = _get_reader_line();
+
+    for (size_t i = 0; i < RWLOCK_READER_SLOTS; i++)
+    {
+        // The compare-and-swap orders the slot before the second check of
+        // the bias, which pairs with the revocation in _revoke_bias().
+        if (line->slots[i] == NULL &&
+            oe_atomic_compare_and_swap(
+                (volatile uint64_t*)&line->slots[i], 0, (uint64_t)rw_lock))
+        {
+            if (rw_lock->reader_bias == RWLOCK_BIAS_SET)
+                return true;
+
+            line->slots[i] = NULL;
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// The current thread must hold the spinlock. Readers that have not published
+// themselves in the reader table by now will take the slow path.
+static void _revoke_bias(oe_rwlock_impl_t* rw_lock)
+{
+    oe_atomic_compare_and_swap(
+        &rw_lock->reader_bias, RWLOCK_BIAS_SET, RWLOCK_BIAS_REVOKED);
+    rw_lock->bias_inhibit = RWLOCK_BIAS_INHIBIT;
+}
+
+// Whether a reader holds the lock through the reader table.
+static bool _has_fast_readers(oe_rwlock_impl_t* rw_lock)
+{
+    for (size_t i = 0; i < RWLOCK_READER_LINES; i++)
+    {
+        for (size_t j = 0; j < RWLOCK_READER_SLOTS; j++)
+        {
+            if (_reader_table[i].slots[j] == rw_lock)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock);
+
+/* Release a read lock obtained through the reader table */
+static bool _rwlock_fast_rdunlock(oe_rwlock_impl_t* rw_lock)
+{
+    reader_line_t* line = _get_reader_line();
+
+    for (size_t i = 0; i < RWLOCK_READER_SLOTS; i++)
+    {
+        if (line->slots[i] == rw_lock)
+        {
+            // The compare-and-swap orders the slot before the check of the
+            // bias, which pairs with the one in oe_rwlock_wrlock().
+            oe_atomic_compare_and_swap(
+                (volatile uint64_t*)&line->slots[i], (uint64_t)rw_lock, 0);
+
+            if (rw_lock->reader_bias == RWLOCK_BIAS_WRITER_WAITING)
+            {
+                oe_spin_lock(&rw_lock->lock);
+
+                // Wake the writer once the last reader has left.
+                if (rw_lock->reader_bias == RWLOCK_BIAS_WRITER_WAITING &&
+                    !_has_fast_readers(rw_lock))
+                {
+                    rw_lock->reader_bias = RWLOCK_BIAS_REVOKED;
+                    _wake_waiters(rw_lock);
+                }
+                else
+                {
+                    oe_spin_unlock(&rw_lock->lock);
+                }
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The current thread must hold the spinlock and just obtained a read lock
+// through the slow path.
+static void _restore_bias(oe_rwlock_impl_t* rw_lock)
+{
+    if (rw_lock->reader_bias == RWLOCK_BIAS_SET)
+        return;
+
+    if (rw_lock->bias_inhibit)
+        rw_lock->bias_inhibit--;
+    else if (_queue_empty(&rw_lock->queue))
+        rw_lock->reader_bias = RWLOCK_BIAS_SET;
+}
+
 oe_result_t oe_rwlock_init(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
@@ -552,10 +899,17 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
     oe_thread_data_t* self = oe_get_thread_data();
+    OE_LOCK_WAIT(wait);
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (_rwlock_fast_rdlock(rw_lock))
+    {
+        OE_LOCK_ACQUIRED(OE_LOCK_TYPE_RWLOCK_READ, rw_lock, wait);
+        return OE_OK;
+    }
+
     oe_spin_lock(&rw_lock->lock);
 
     // Wait for writer to finish.
@@ -566,6 +920,9 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
         if (!_queue_contains(&rw_lock->queue, self))
             _queue_push_back(&rw_lock->queue, self);
 
+        OE_LOCK_WAIT_BEGIN(wait);
+        OE_LOCK_WAIT_PARK(wait);
+
         oe_spin_unlock(&rw_lock->lock);
         _thread_wait(self);
 
@@ -576,8 +933,10 @@ oe_result_t oe_rwlock_rdlock(oe_rwlock_t* read_write_lock)
 
     // Increment number of readers.
     rw_lock->readers++;
+    _restore_bias(rw_lock);
 
     oe_spin_unlock(&rw_lock->lock);
+    OE_LOCK_ACQUIRED(OE_LOCK_TYPE_RWLOCK_READ, rw_lock, wait);
 
     return OE_OK;
 }
@@ -589,6 +948,9 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (_rwlock_fast_rdlock(rw_lock))
+        return OE_OK;
+
     oe_spin_lock(&rw_lock->lock);
 
     oe_result_t result = OE_BUSY;
@@ -597,6 +959,7 @@ oe_result_t oe_rwlock_tryrdlock(oe_rwlock_t* read_write_lock)
     if (rw_lock->writer == NULL)
     {
         rw_lock->readers++;
+        _restore_bias(rw_lock);
         result = OE_OK;
     }
 
@@ -623,8 +986,7 @@ static oe_result_t _wake_waiters(oe_rwlock_impl_t* rw_lock)
 
     // Wake the waiters in FIFO order. However actual acquisition of the lock
     // will be dependent on OS scheduling of the threads.
-    while ((p = _queue_pop_front(&waiters)))
-        _thread_wake(p);
+    _queue_wake_all(&waiters);
 
     return OE_OK;
 }
@@ -636,6 +998,9 @@ static oe_result_t _rwlock_rdunlock(oe_rwlock_t* read_write_lock)
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
 
+    if (_rwlock_fast_rdunlock(rw_lock))
+        return OE_OK;
+
     oe_spin_lock(&rw_lock->lock);
 
     // There must be at least 1 reader and no writers.
@@ -660,6 +1025,8 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
 {
     oe_rwlock_impl_t* rw_lock = (oe_rwlock_impl_t*)read_write_lock;
     oe_thread_data_t* self = oe_get_thread_data();
+    uint64_t spins = 0;
+    OE_LOCK_WAIT(wait);
 
     if (!rw_lock)
         return OE_INVALID_PARAMETER;
@@ -674,23 +1041,78 @@ oe_result_t oe_rwlock_wrlock(oe_rwlock_t* read_write_lock)
     }
 
     // Wait for all readers and any other writer to finish.
-    while (rw_lock->readers > 0 || rw_lock->writer != NULL)
+    for (;;)
     {
-        // Add self to list of waiters, and go to wait state.
-        if (!_queue_contains(&rw_lock->queue, self))
-            _queue_push_back(&rw_lock->queue, self);
+        _revoke_bias(rw_lock);
 
-        oe_spin_unlock(&rw_lock->lock);
+        if (rw_lock->readers > 0 || rw_lock->writer != NULL)
+        {
+            // Add self to list of waiters, and go to wait state.
+            if (!_queue_contains(&rw_lock->queue, self))
+                _queue_push_back(&rw_lock->queue, self);
 
-        _thread_wait(self);
+            OE_LOCK_WAIT_BEGIN(wait);
+            OE_LOCK_WAIT_PARK(wait);
 
-        // Upon waking, re-acquire the lock.
-        // Just like a condition variable.
-        oe_spin_lock(&rw_lock->lock);
+            oe_spin_unlock(&rw_lock->lock);
+
+            _thread_wait(self);
+
+            // Upon waking, re-acquire the lock.
+            // Just like a condition variable.
+            oe_spin_lock(&rw_lock->lock);
+        }
+        else if (!_has_fast_readers(rw_lock))
+        {
+            break;
+        }
+        else if (spins++ < RWLOCK_WRITER_SPIN_COUNT)
+        {
+            // Readers in the reader table usually leave soon, so spin first.
+            OE_LOCK_WAIT_BEGIN(wait);
+            OE_LOCK_WAIT_SPINS(wait, 1);
+
+            oe_spin_unlock(&rw_lock->lock);
+            oe_cpu_relax();
+            oe_spin_lock(&rw_lock->lock);
+        }
+        else
+        {
+            if (!_queue_contains(&rw_lock->queue, self))
+                _queue_push_back(&rw_lock->queue, self);
+
+            // Ask the last reader in the reader table for a wakeup. The
+            // compare-and-swap orders the mark before the check of the
+            // slots, which pairs with the one in _rwlock_fast_rdunlock().
+            oe_atomic_compare_and_swap(
+                &rw_lock->reader_bias,
+                RWLOCK_BIAS_REVOKED,
+                RWLOCK_BIAS_WRITER_WAITING);
+
+            if (!_has_fast_readers(rw_lock))
+            {
+                _queue_remove(&rw_lock->queue, self);
+                continue;
+            }
+
+            OE_LOCK_WAIT_BEGIN(wait);
+            OE_LOCK_WAIT_PARK(wait);
+
+            oe_spin_unlock(&rw_lock->lock);
+            _thread_wait(self);
+            oe_spin_lock(&rw_lock->lock);
+        }
     }
 
+    // The lock is free, so no writer waits for the reader table.
+    oe_atomic_compare_and_swap(
+        &rw_lock->reader_bias,
+        RWLOCK_BIAS_WRITER_WAITING,
+        RWLOCK_BIAS_REVOKED);
+
     rw_lock->writer = self;
     oe_spin_unlock(&rw_lock->lock);
+    OE_LOCK_ACQUIRED(OE_LOCK_TYPE_RWLOCK_WRITE, rw_lock, wait);
 
     return OE_OK;
 }
@@ -709,8 +1131,13 @@ oe_result_t oe_rwlock_trywrlock(oe_rwlock_t* read_write_lock)
     // If no readers and no writers are active, then lock is successful.
     if (rw_lock->readers == 0 && rw_lock->writer == NULL)
     {
-        rw_lock->writer = self;
-        result = OE_OK;
+        _revoke_bias(rw_lock);
+
+        if (!_has_fast_readers(rw_lock))
+        {
+            rw_lock->writer = self;
+            result = OE_OK;
+        }
     }
 
     oe_spin_unlock(&rw_lock->lock);
@@ -759,7 +1186,8 @@ oe_result_t oe_rwlock_destroy(oe_rwlock_t* read_write_lock)
     oe_spin_lock(&rw_lock->lock);
 
     // There must not be any active readers or writers.
-    if (rw_lock->readers != 0 || rw_lock->writer != NULL)
+    if (rw_lock->readers != 0 || rw_lock->writer != NULL ||
+        _has_fast_readers(rw_lock))
     {
         oe_spin_unlock(&rw_lock->lock);
         return OE_BUSY;
@@ -0,0 +1,535 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#define USE_DL_PREFIX
+#include "threadcache.h"
+#include <openenclave/bits/safemath.h>
+#include <openenclave/enclave.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/globals.h>
+#include <openenclave/internal/thread.h>
+#include <openenclave/internal/utils.h>
+#include "../3rdparty/dlmalloc/dlmalloc/malloc.h"
+#include "dlmalloc/errno.h"
+#include "td.h"
+
+/*
+**==============================================================================
+**
+** Thread-caching allocator
+**
+**     Blocks of up to MAX_BLOCK_SIZE bytes are rounded up to a size class:
+**     multiples of 16 bytes up to 128 bytes, then four classes per power of
+**     two. Each class is served from spans of SPAN_SIZE bytes, aligned to
+**     their size, that are taken from the enclave heap with oe_sbrk() and
+**     never returned. A span map with one byte per span-sized window of the
+**     heap records the class of each span, so a block's class is found from
+**     its address alone, and any other address belongs to dlmalloc.
+**
+**     Each TCS keeps a free list per size class in its td_t, which serves
+**     malloc and free without a lock. An empty list is refilled and a full
+**     one is drained in batches from and to the central lists of the class,
+**     each under its own spinlock. Larger and over-aligned requests, and
+**     small ones once no span is left, go to dlmalloc.
+**
+**==============================================================================
+*/
+
+#define SPAN_SHIFT 16
+#define SPAN_SIZE ((size_t)1 << SPAN_SHIFT)
+#define NUM_CLASSES 40 /* 16 bytes .. 32 KiB */
+#define MAX_BLOCK_SIZE ((size_t)32 * 1024)
+#define MIN_ALIGNMENT 16
+#define NO_CLASS 0xff
+
+/* Number of spans obtained from oe_sbrk() at once */
+#define SPANS_PER_GROW 16
+
+/* Bytes of free blocks per size class kept in each thread cache */
+#define CACHE_BYTES (32 * 1024)
+
+/* Bounds on the number of blocks per size class in a thread cache */
+#define MIN_CACHE_BLOCKS 2
+#define MAX_CACHE_BLOCKS 128
+
+/* Maximum number of blocks moved between a cache and the central lists */
+#define MAX_BATCH 32
+
+typedef struct _size_class
+{
+    oe_spinlock_t lock;
+
+    /* List of free blocks */
+    void* free_list;
+
+    /* Part of a span not handed out yet */
+    uint8_t* bump;
+    uint8_t* bump_end;
+} OE_ALIGNED(64) size_class_t;
+
+typedef struct _oe_malloc_cache
+{
+    struct _oe_malloc_cache* next;
+
+    void* lists[NUM_CLASSES];
+    uint32_t counts[NUM_CLASSES];
+
+    /* Bytes allocated minus bytes freed by the thread */
+    volatile int64_t in_use;
+} oe_malloc_cache_t;
+
+static size_class_t _classes[NUM_CLASSES];
+
+/* Size class of each span-sized window of the heap (set once) */
+static uint8_t* volatile _span_map;
+static uintptr_t _span_map_base;
+static size_t _span_map_size;
+
+/* Protects the span pool, the span map and the list of caches */
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/* Spans obtained from oe_sbrk() that no class uses yet */
+static uint8_t* _span_next;
+static uint8_t* _span_end;
+
+/* Bytes obtained from oe_sbrk() */
+static volatile uint64_t _system_bytes;
+
+/* All thread caches, for oe_thread_cache_add_stats() */
+static oe_malloc_cache_t* volatile _caches;
+
+/* Bytes in use by threads without a cache (updated atomically) */
+static volatile uint64_t _uncached_in_use;
+
+static size_t _class_size(uint32_t c)
+{
+    uint32_t shift;
+
+    if (c < 8)
+        return (size_t)(c + 1) * 16;
+
+    shift = 7 + (c - 8) / 4;
+    return ((size_t)1 << shift) +
+           ((c - 8) % 4 + 1) * ((size_t)1 << (shift - 2));
+}
+
+static uint32_t _size_to_class(size_t size)
+{
+    size_t n;
+    uint32_t shift;
+
+    if (size <= 128)
+        return size ? (uint32_t)((size - 1) / 16) : 0;
+
+    n = size - 1;
+    shift = 63 - (uint32_t)__builtin_clzll(n);
+
+    return 8 + (shift - 7) * 4 +
+           (uint32_t)((n - ((size_t)1 << shift)) >> (shift - 2));
+}
+
+static uint32_t _cache_capacity(uint32_t c)
+{
+    size_t n = CACHE_BYTES / _class_size(c);
+
+    if (n < MIN_CACHE_BLOCKS)
+        return MIN_CACHE_BLOCKS;
+
+    return n > MAX_CACHE_BLOCKS ? MAX_CACHE_BLOCKS : (uint32_t)n;
+}
+
+static uint32_t _batch_size(uint32_t c)
+{
+    uint32_t n = (_cache_capacity(c) + 1) / 2;
+    return n < MAX_BATCH ? n : MAX_BATCH;
+}
+
+/* Return true and the size class if ptr is a block of the thread caches */
+static bool _find_class(const void* ptr, uint32_t* class_out)
+{
+    const uint8_t* map = _span_map;
+    uintptr_t index;
+    uint8_t c;
+
+    if (!map || !ptr)
+        return false;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    if ((uintptr_t)ptr < _span_map_base)
+        return false;
+
+    index = ((uintptr_t)ptr - _span_map_base) >> SPAN_SHIFT;
+
+    if (index >= _span_map_size || (c = map[index]) == NO_CLASS)
+        return false;
+
+    *class_out = c;
+    return true;
+}
+
+/*
+**==============================================================================
+**
+** Span pool
+**
+**==============================================================================
+*/
+
+/* Allocate the span map. Called with _lock held */
+static bool _init_span_map(void)
+{
+    uintptr_t base = (uintptr_t)__oe_get_heap_base() & ~(SPAN_SIZE - 1);
+    uintptr_t end = (uintptr_t)__oe_get_heap_end();
+    size_t size = (end - base + SPAN_SIZE - 1) >> SPAN_SHIFT;
+    uint8_t* map;
+
+    if (!(map = (uint8_t*)dlmalloc(size)))
+        return false;
+
+    oe_memset(map, NO_CLASS, size);
+    _span_map_base = base;
+    _span_map_size = size;
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    _span_map = map;
+
+    return true;
+}
+
+/* Obtain count aligned spans from oe_sbrk(). Called with _lock held */
+static bool _grow_spans(size_t count)
+{
+    uint8_t* brk;
+    size_t size;
+    uint8_t* p;
+
+    /* dlmalloc trims the heap by reading the break and then lowering it,
+     * so growing in between would hand out spans below the new break */
+    oe_malloc_lock_morecore();
+    {
+        brk = (uint8_t*)oe_sbrk(0);
+        size = (-(uintptr_t)brk & (SPAN_SIZE - 1)) + count * SPAN_SIZE;
+        p = (uint8_t*)oe_sbrk((ptrdiff_t)size);
+    }
+    oe_malloc_unlock_morecore();
+
+    if (p == (uint8_t*)-1)
+        return false;
+
+    _system_bytes += size;
+    _span_next = (uint8_t*)(((uintptr_t)p + SPAN_SIZE - 1) & ~(SPAN_SIZE - 1));
+    _span_end = (uint8_t*)(((uintptr_t)p + size) & ~(SPAN_SIZE - 1));
+
+    return _span_next < _span_end;
+}
+
+/* Assign a free span to size class c */
+static uint8_t* _take_span(uint32_t c)
+{
+    uint8_t* span = NULL;
+
+    oe_spin_lock(&_lock);
+    {
+        if ((_span_map || _init_span_map()) &&
+            (_span_next < _span_end || _grow_spans(SPANS_PER_GROW) ||
+             _grow_spans(1)))
+        {
+            span = _span_next;
+            _span_next += SPAN_SIZE;
+            _span_map[((uintptr_t)span - _span_map_base) >> SPAN_SHIFT] =
+                (uint8_t)c;
+        }
+    }
+    oe_spin_unlock(&_lock);
+
+    return span;
+}
+
+/*
+**==============================================================================
+**
+** Central lists
+**
+**==============================================================================
+*/
+
+/* Take up to count blocks of class c into list. Called with the class lock */
+static uint32_t _take_blocks(uint32_t c, void** list, uint32_t count)
+{
+    size_class_t* sc = &_classes[c];
+    size_t block_size = _class_size(c);
+    uint32_t n = 0;
+
+    while (n < count)
+    {
+        void* block;
+
+        if ((block = sc->free_list))
+        {
+            sc->free_list = *(void**)block;
+        }
+        else
+        {
+            if (sc->bump == sc->bump_end)
+            {
+                uint8_t* span;
+
+                if (!(span = _take_span(c)))
+                    break;
+
+                sc->bump = span;
+                sc->bump_end = span + (SPAN_SIZE / block_size) * block_size;
+            }
+
+            block = sc->bump;
+            sc->bump += block_size;
+        }
+
+        *(void**)block = *list;
+        *list = block;
+        n++;
+    }
+
+    return n;
+}
+
+/* Move up to count blocks from the front of a cache list to class c */
+static uint32_t _release_blocks(uint32_t c, void** list, uint32_t count)
+{
+    size_class_t* sc = &_classes[c];
+    void* head = *list;
+    void* tail = head;
+    uint32_t n = 1;
+
+    if (!head)
+        return 0;
+
+    while (n < count && *(void**)tail)
+    {
+        tail = *(void**)tail;
+        n++;
+    }
+
+    *list = *(void**)tail;
+
+    oe_spin_lock(&sc->lock);
+    {
+        *(void**)tail = sc->free_list;
+        sc->free_list = head;
+    }
+    oe_spin_unlock(&sc->lock);
+
+    return n;
+}
+
+static oe_malloc_cache_t* _get_cache(void)
+{
+    td_t* td = oe_get_td();
+    oe_malloc_cache_t* cache = td->malloc_cache;
+
+    if (cache)
+        return cache;
+
+    if (!(cache = (oe_malloc_cache_t*)dlcalloc(1, sizeof(oe_malloc_cache_t))))
+        return NULL;
+
+    oe_spin_lock(&_lock);
+    {
+        cache->next = _caches;
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        _caches = cache;
+    }
+    oe_spin_unlock(&_lock);
+
+    td->malloc_cache = cache;
+    return cache;
+}
+
+/*
+**==============================================================================
+**
+** Public definitions:
+**
+**==============================================================================
+*/
+
+void* oe_thread_cache_malloc(size_t size)
+{
+    oe_malloc_cache_t* cache;
+    uint32_t c;
+    void* block = NULL;
+
+    if (size > MAX_BLOCK_SIZE)
+        return dlmalloc(size);
+
+    c = _size_to_class(size);
+
+    if ((cache = _get_cache()))
+    {
+        if (!cache->lists[c])
+        {
+            oe_spin_lock(&_classes[c].lock);
+            cache->counts[c] =
+                _take_blocks(c, &cache->lists[c], _batch_size(c));
+            oe_spin_unlock(&_classes[c].lock);
+        }
+
+        if ((block = cache->lists[c]))
+        {
+            cache->lists[c] = *(void**)block;
+            cache->counts[c]--;
+            cache->in_use += (int64_t)_class_size(c);
+        }
+    }
+    else
+    {
+        /* Without a cache, take a single block from the central list */
+        oe_spin_lock(&_classes[c].lock);
+        _take_blocks(c, &block, 1);
+        oe_spin_unlock(&_classes[c].lock);
+
+        if (block)
+            oe_atomic_add(&_uncached_in_use, _class_size(c));
+    }
+
+    /* Once no span is left, dlmalloc may still have free memory */
+    return block ? block : dlmalloc(size);
+}
+
+void oe_thread_cache_free(void* ptr)
+{
+    oe_malloc_cache_t* cache;
+    uint32_t c;
+
+    if (!_find_class(ptr, &c))
+    {
+        dlfree(ptr);
+        return;
+    }
+
+    if (!(cache = _get_cache()))
+    {
+        oe_spin_lock(&_classes[c].lock);
+        *(void**)ptr = _classes[c].free_list;
+        _classes[c].free_list = ptr;
+        oe_spin_unlock(&_classes[c].lock);
+
+        oe_atomic_add(&_uncached_in_use, -(uint64_t)_class_size(c));
+        return;
+    }
+
+    *(void**)ptr = cache->lists[c];
+    cache->lists[c] = ptr;
+    cache->counts[c]++;
+    cache->in_use -= (int64_t)_class_size(c);
+
+    /* Return a batch to the central list once the cache is full */
+    if (cache->counts[c] > _cache_capacity(c))
+    {
+        cache->counts[c] -=
+            _release_blocks(c, &cache->lists[c], _batch_size(c));
+    }
+}
+
+void* oe_thread_cache_calloc(size_t nmemb, size_t size)
+{
+    size_t total;
+    void* ptr;
+
+    if (oe_safe_mul_sizet(nmemb, size, &total) != OE_OK)
+        return NULL;
+
+    if (total > MAX_BLOCK_SIZE)
+        return dlcalloc(nmemb, size);
+
+    /* Blocks are reused without being cleared */
+    if ((ptr = oe_thread_cache_malloc(total)))
+        oe_memset(ptr, 0, total);
+
+    return ptr;
+}
+
+void* oe_thread_cache_realloc(void* ptr, size_t size)
+{
+    uint32_t c;
+    size_t block_size;
+    void* new_ptr;
+
+    if (!ptr)
+        return oe_thread_cache_malloc(size);
+
+    if (!_find_class(ptr, &c))
+        return dlrealloc(ptr, size);
+
+    block_size = _class_size(c);
+
+    /* Keep the block unless it is too small or much too large */
+    if (size <= block_size &&
+        (size >= block_size / 2 || _size_to_class(size) == c))
+        return ptr;
+
+    if (!(new_ptr = oe_thread_cache_malloc(size)))
+        return NULL;
+
+    oe_memcpy(new_ptr, ptr, size < block_size ? size : block_size);
+    oe_thread_cache_free(ptr);
+
+    return new_ptr;
+}
+
+void* oe_thread_cache_memalign(size_t alignment, size_t size)
+{
+    /* Blocks are aligned to MIN_ALIGNMENT bytes only */
+    if (alignment <= MIN_ALIGNMENT)
+        return oe_thread_cache_malloc(size);
+
+    return dlmemalign(alignment, size);
+}
+
+int oe_thread_cache_posix_memalign(
+    void** memptr,
+    size_t alignment,
+    size_t size)
+{
+    void* ptr;
+
+    /* Let dlmalloc serve (or reject) every other alignment */
+    if (alignment != sizeof(void*) && alignment != MIN_ALIGNMENT)
+        return dlposix_memalign(memptr, alignment, size);
+
+    if (!(ptr = oe_thread_cache_malloc(size)))
+        return ENOMEM;
+
+    *memptr = ptr;
+    return 0;
+}
+
+/*
+**==============================================================================
+**
+** oe_thread_cache_add_stats()
+**
+**     Spans are never returned, so the system bytes of the thread caches are
+**     also their peak. Blocks held in the caches are not in use.
+**
+**==============================================================================
+*/
+
+void oe_thread_cache_add_stats(oe_malloc_stats_t* stats)
+{
+    int64_t in_use = (int64_t)_uncached_in_use;
+    const oe_malloc_cache_t* cache = _caches;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    for (; cache; cache = cache->next)
+        in_use += cache->in_use;
+
+    stats->peak_system_bytes += _system_bytes;
+    stats->system_bytes += _system_bytes;
+
+    if (in_use > 0)
+        stats->in_use_bytes += (uint64_t)in_use;
+}
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_THREADCACHE_H
+#define _OE_CORE_THREADCACHE_H
+
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/malloc.h>
+
+/*
+ * Thread-caching allocator (see threadcache.c). Small blocks are served from
+ * per-TCS caches; every other request is passed to dlmalloc, and the free
+ * functions accept blocks from either.
+ */
+
+void* oe_thread_cache_malloc(size_t size);
+
+void oe_thread_cache_free(void* ptr);
+
+void* oe_thread_cache_calloc(size_t nmemb, size_t size);
+
+void* oe_thread_cache_realloc(void* ptr, size_t size);
+
+void* oe_thread_cache_memalign(size_t alignment, size_t size);
+
+int oe_thread_cache_posix_memalign(
+    void** memptr,
+    size_t alignment,
+    size_t size);
+
+/* Serialize oe_sbrk() calls with those made by dlmalloc (see malloc.c) */
+void oe_malloc_lock_morecore(void);
+
+void oe_malloc_unlock_morecore(void);
+
+/* Add the memory of the thread caches to statistics obtained from dlmalloc */
+void oe_thread_cache_add_stats(oe_malloc_stats_t* stats);
+
+#endif /* _OE_CORE_THREADCACHE_H */
@@ -0,0 +1,178 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "threadstart.h"
+#include <openenclave/enclave.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/thread.h>
+
+/*
+**==============================================================================
+**
+** Thread start requests
+**
+**     oe_thread_start() records the function to run under a fresh identifier
+**     and asks the host to start a thread with OE_OCALL_THREAD_CREATE. The new
+**     thread enters with OE_ECALL_THREAD_START and the identifier. Each
+**     request is removed from the list by the first ECALL that names it, so
+**     the host can neither run a function the enclave did not ask for nor run
+**     a requested one twice.
+**
+**     The host gives up on a thread whose ECALL fails or that still waits for
+**     a TCS when the enclave is terminated. The host threads are stopped
+**     before the enclave destructor runs, so the requests still in the list
+**     then will never be taken: oe_cancel_thread_starts() removes them and
+**     calls their cancel function instead.
+**
+**==============================================================================
+*/
+
+typedef struct _start_request
+{
+    struct _start_request* next;
+    uint64_t id;
+    void (*start)(void* arg);
+    void (*cancel)(void* arg);
+    void* arg;
+} start_request_t;
+
+static start_request_t* _requests;
+static uint64_t _next_id = 1;
+static oe_spinlock_t _lock = OE_SPINLOCK_INITIALIZER;
+
+/* Remove the request with the given identifier from the list */
+static start_request_t* _take_request(uint64_t id)
+{
+    start_request_t* request = NULL;
+
+    oe_spin_lock(&_lock);
+    {
+        start_request_t** p = &_requests;
+
+        while (*p && (*p)->id != id)
+            p = &(*p)->next;
+
+        if ((request = *p))
+            *p = request->next;
+    }
+    oe_spin_unlock(&_lock);
+
+    return request;
+}
+
+/*
+**==============================================================================
+**
+** oe_thread_start()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_thread_start(
+    void (*start)(void* arg),
+    void (*cancel)(void* arg),
+    void* arg)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    start_request_t* request = NULL;
+    uint64_t id;
+    uint64_t arg_out = 0;
+
+    if (!start)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!(request = (start_request_t*)oe_malloc(sizeof(start_request_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    request->start = start;
+    request->cancel = cancel;
+    request->arg = arg;
+
+    oe_spin_lock(&_lock);
+    {
+        id = _next_id++;
+        request->id = id;
+        request->next = _requests;
+        _requests = request;
+    }
+    oe_spin_unlock(&_lock);
+
+    if (oe_ocall(OE_OCALL_THREAD_CREATE, id, &arg_out) != OE_OK ||
+        (oe_result_t)arg_out != OE_OK)
+    {
+        /* The thread may not exist, so it must not find the request */
+        if ((request = _take_request(id)))
+            oe_free(request);
+
+        OE_RAISE(OE_FAILURE);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_thread_start()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_handle_thread_start(uint64_t arg_in)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    start_request_t* request;
+    void (*start)(void* arg);
+    void* arg;
+
+    if (!(request = _take_request(arg_in)))
+        OE_RAISE(OE_NOT_FOUND);
+
+    start = request->start;
+    arg = request->arg;
+    oe_free(request);
+
+    start(arg);
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_cancel_thread_starts()
+**
+**==============================================================================
+*/
+
+void oe_cancel_thread_starts(void)
+{
+    start_request_t* requests;
+
+    oe_spin_lock(&_lock);
+    {
+        requests = _requests;
+        _requests = NULL;
+    }
+    oe_spin_unlock(&_lock);
+
+    while (requests)
+    {
+        start_request_t* request = requests;
+
+        requests = request->next;
+
+        if (request->cancel)
+            request->cancel(request->arg);
+
+        oe_free(request);
+    }
+}
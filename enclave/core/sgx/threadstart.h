@@ -0,0 +1,15 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_CORE_THREADSTART_H
+#define _OE_CORE_THREADSTART_H
+
+#include <openenclave/enclave.h>
+
+/* Handle OE_ECALL_THREAD_START from the host */
+oe_result_t oe_handle_thread_start(uint64_t arg_in);
+
+/* Cancel the thread start requests that no thread took (by the destructor) */
+void oe_cancel_thread_starts(void);
+
+#endif /* _OE_CORE_THREADSTART_H */
@@ -0,0 +1,90 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/host.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*
+**==============================================================================
+**
+** Per-thread ECALL marshaling buffer
+**
+**     Each host thread keeps one buffer for the ECALL wrappers generated by
+**     oeedger8r. It grows as needed; a buffer that grew beyond HIGH_WATER is
+**     kept while large calls continue, and released after SHRINK_CALLS calls
+**     in a row have needed no more than HIGH_WATER bytes. The buffer of a
+**     thread is not released when the thread exits, so a thread whose last
+**     calls were large leaks its buffer, and any other thread at most
+**     HIGH_WATER bytes.
+**
+**==============================================================================
+*/
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define HIGH_WATER (64 * 1024)
+#define SHRINK_CALLS 64
+
+static THREAD_LOCAL void* _buffer;
+static THREAD_LOCAL size_t _buffer_size;
+static THREAD_LOCAL bool _buffer_busy;
+
+/* Size requested by the current call and number of small calls in a row */
+static THREAD_LOCAL size_t _request_size;
+static THREAD_LOCAL size_t _small_calls;
+
+void* oe_acquire_ecall_buffer(size_t size)
+{
+    /* ECALLs made while handling an OCALL need their own buffer */
+    if (_buffer_busy)
+        return malloc(size);
+
+    if (size > _buffer_size)
+    {
+        free(_buffer);
+        _buffer_size = 0;
+
+        if (!(_buffer = malloc(size)))
+            return NULL;
+
+        _buffer_size = size;
+    }
+
+    _buffer_busy = true;
+    _request_size = size;
+    return _buffer;
+}
+
+void oe_release_ecall_buffer(void* buffer)
+{
+    if (!buffer)
+        return;
+
+    if (buffer != _buffer || !_buffer_busy)
+    {
+        free(buffer);
+        return;
+    }
+
+    _buffer_busy = false;
+
+    if (_buffer_size <= HIGH_WATER)
+        return;
+
+    if (_request_size > HIGH_WATER)
+    {
+        _small_calls = 0;
+    }
+    else if (++_small_calls == SHRINK_CALLS)
+    {
+        free(_buffer);
+        _buffer = NULL;
+        _buffer_size = 0;
+        _small_calls = 0;
+    }
+}
@@ -15,6 +15,7 @@
 
 #if __GNUC__
 #include <pthread.h>
+#include <semaphore.h>
 #elif _MSC_VER
 #include <Windows.h>
 #else
@@ -35,6 +36,10 @@ typedef pthread_mutex_t oe_mutex;
 
 typedef pthread_key_t oe_thread_key;
 
+typedef pthread_t oe_thread_handle;
+
+typedef sem_t oe_semaphore;
+
 #elif _MSC_VER
 
 typedef INIT_ONCE oe_once_type;
@@ -47,6 +52,10 @@ typedef HANDLE oe_mutex;
 
 typedef DWORD oe_thread_key;
 
+typedef HANDLE oe_thread_handle;
+
+typedef HANDLE oe_semaphore;
+
 #endif
 
 /**
@@ -213,6 +222,72 @@ int oe_thread_setspecific(oe_thread_key key, void* value);
  */
 void* oe_thread_getspecific(oe_thread_key key);
 
+/**
+ * Creates a new thread.
+ *
+ * This function starts a new host thread that runs **func** with the given
+ * argument. The thread must eventually be joined with oe_thread_join().
+ *
+ * @param thread Set to the handle of the new thread on success.
+ * @param func The function run by the new thread.
+ * @param arg The argument passed to **func**.
+ *
+ * @return Returns zero on success.
+ */
+int oe_thread_create(
+    oe_thread_handle* thread,
+    void (*func)(void* arg),
+    void* arg);
+
+/**
+ * Waits for a thread to exit.
+ *
+ * This function blocks until the thread created by oe_thread_create() has
+ * returned from its thread function and releases the thread's resources.
+ *
+ * @param thread The handle of the thread to wait for.
+ *
+ * @return Returns zero on success.
+ */
+int oe_thread_join(oe_thread_handle thread);
+
+/**
+ * Initialize a counting semaphore.
+ *
+ * @param sem The semaphore to initialize.
+ * @param value The initial count of the semaphore.
+ *
+ * @return Returns zero on success.
+ */
+int oe_semaphore_init(oe_semaphore* sem, uint32_t value);
+
+/**
+ * Wait until the count of a semaphore is positive and decrement it.
+ *
+ * @param sem The semaphore to wait for.
+ *
+ * @return Returns zero on success.
+ */
+int oe_semaphore_wait(oe_semaphore* sem);
+
+/**
+ * Increment the count of a semaphore, waking up one waiter if any.
+ *
+ * @param sem The semaphore to post.
+ *
+ * @return Returns zero on success.
+ */
+int oe_semaphore_post(oe_semaphore* sem);
+
+/**
+ * Destroy a semaphore that no thread waits for.
+ *
+ * @param sem The semaphore to destroy.
+ *
+ * @return Returns zero on success.
+ */
+int oe_semaphore_destroy(oe_semaphore* sem);
+
 OE_EXTERNC_END
 
 #endif /* _HOSTTHREAD_H */
@@ -3,8 +3,10 @@
 
 #include "../hostthread.h"
 #include <assert.h>
+#include <errno.h>
 #include <openenclave/host.h>
 #include <pthread.h>
+#include <stdlib.h>
 
 /*
 **==============================================================================
@@ -101,3 +103,89 @@ void* oe_thread_getspecific(oe_thread_key key)
 {
     return pthread_getspecific(key);
 }
+
+/*
+**==============================================================================
+**
+** oe_thread_handle
+**
+**==============================================================================
+*/
+
+typedef struct _thread_start_args
+{
+    void (*func)(void* arg);
+    void* arg;
+} thread_start_args_t;
+
+static void* _thread_start(void* arg)
+{
+    thread_start_args_t args = *(thread_start_args_t*)arg;
+
+    free(arg);
+    args.func(args.arg);
+
+    return NULL;
+}
+
+int oe_thread_create(
+    oe_thread_handle* thread,
+    void (*func)(void* arg),
+    void* arg)
+{
+    thread_start_args_t* args;
+    int err;
+
+    if (!thread || !func)
+        return EINVAL;
+
+    if (!(args = (thread_start_args_t*)malloc(sizeof(thread_start_args_t))))
+        return ENOMEM;
+
+    args->func = func;
+    args->arg = arg;
+
+    if ((err = pthread_create(thread, NULL, _thread_start, args)) != 0)
+        free(args);
+
+    return err;
+}
+
+int oe_thread_join(oe_thread_handle thread)
+{
+    return pthread_join(thread, NULL);
+}
+
+/*
+**==============================================================================
+**
+** oe_semaphore
+**
+**==============================================================================
+*/
+
+int oe_semaphore_init(oe_semaphore* sem, uint32_t value)
+{
+    return sem_init(sem, 0, value) == 0 ? 0 : errno;
+}
+
+int oe_semaphore_wait(oe_semaphore* sem)
+{
+    while (sem_wait(sem) != 0)
+    {
+        if (errno != EINTR)
+            return errno;
+    }
+
+    return 0;
+}
+
+int oe_semaphore_post(oe_semaphore* sem)
+{
+    return sem_post(sem) == 0 ? 0 : errno;
+}
+
+int oe_semaphore_destroy(oe_semaphore* sem)
+{
+    return sem_destroy(sem) == 0 ? 0 : errno;
+}
@@ -47,6 +47,64 @@ oe_result_t oe_call_enclave_function(
     return OE_UNSUPPORTED;
 }
 
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(function_id);
+    OE_UNUSED(input_buffer);
+    OE_UNUSED(input_buffer_size);
+    OE_UNUSED(output_buffer);
+    OE_UNUSED(output_buffer_size);
+    OE_UNUSED(output_bytes_written);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(calls);
+    OE_UNUSED(num_calls);
+
+    return OE_UNSUPPORTED;
+}
+
+oe_result_t oe_call_enclave_function_async(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    oe_async_call_callback_t callback,
+    void* callback_arg,
+    oe_async_call_t** call)
+{
+    OE_UNUSED(enclave);
+    OE_UNUSED(function_id);
+    OE_UNUSED(input_buffer);
+    OE_UNUSED(input_buffer_size);
+    OE_UNUSED(output_buffer);
+    OE_UNUSED(output_buffer_size);
+    OE_UNUSED(callback);
+    OE_UNUSED(callback_arg);
+
+    if (call)
+        *call = NULL;
+
+    return OE_UNSUPPORTED;
+}
+
 oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 {
     OE_UNUSED(enclave);
@@ -0,0 +1,360 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "asynccalls.h"
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <stdlib.h>
+#include "switchless.h"
+
+/*
+**==============================================================================
+**
+** Completion of a call
+**
+**     The pool thread stores the outcome, runs the callback, sets complete
+**     and finally posts the done semaphore. Posting is the last access of the
+**     pool thread, so oe_async_call_free() waits for the semaphore before
+**     releasing the call. Every waiter posts the semaphore again for the
+**     next one.
+**
+**==============================================================================
+*/
+
+static void _free_call(oe_async_call_t* call)
+{
+    oe_semaphore_destroy(&call->done);
+    free(call);
+}
+
+static void _complete_call(oe_async_call_t* call, oe_result_t result)
+{
+    call->result = result;
+
+    if (call->callback)
+        call->callback(
+            result, call->output_bytes_written, call->callback_arg);
+
+    if (call->detached)
+    {
+        _free_call(call);
+        return;
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    call->complete = 1;
+    oe_semaphore_post(&call->done);
+}
+
+bool oe_async_call_is_complete(oe_async_call_t* call)
+{
+    if (!call || !call->complete)
+        return false;
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+    return true;
+}
+
+oe_result_t oe_async_call_wait(
+    oe_async_call_t* call,
+    size_t* output_bytes_written)
+{
+    if (output_bytes_written)
+        *output_bytes_written = 0;
+
+    if (!call)
+        return OE_INVALID_PARAMETER;
+
+    oe_semaphore_wait(&call->done);
+    oe_semaphore_post(&call->done);
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    if (output_bytes_written)
+        *output_bytes_written = call->output_bytes_written;
+
+    return call->result;
+}
+
+void oe_async_call_free(oe_async_call_t* call)
+{
+    if (!call)
+        return;
+
+    oe_semaphore_wait(&call->done);
+    _free_call(call);
+}
+
+/*
+**==============================================================================
+**
+** Pool threads
+**
+**==============================================================================
+*/
+
+static void _worker(void* arg)
+{
+    oe_async_pool_t* pool = (oe_async_pool_t*)arg;
+
+    for (;;)
+    {
+        oe_async_call_t* call;
+        oe_result_t result;
+
+        oe_semaphore_wait(&pool->pending);
+
+        oe_mutex_lock(&pool->lock);
+        {
+            if ((call = pool->head))
+            {
+                if (!(pool->head = call->next))
+                    pool->tail = NULL;
+            }
+        }
+        oe_mutex_unlock(&pool->lock);
+
+        /* The queue is only empty on a wake-up to stop */
+        if (!call)
+            break;
+
+        result = oe_call_enclave_function(
+            pool->enclave,
+            call->function_id,
+            call->input_buffer,
+            call->input_buffer_size,
+            call->output_buffer,
+            call->output_buffer_size,
+            &call->output_bytes_written);
+
+        _complete_call(call, result);
+    }
+}
+
+static void _free_pool(oe_async_pool_t* pool)
+{
+    oe_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    oe_mutex_unlock(&pool->lock);
+
+    /* Workers complete the queued calls before they see an empty queue */
+    for (size_t i = 0; i < pool->num_workers; i++)
+        oe_semaphore_post(&pool->pending);
+
+    for (size_t i = 0; i < pool->num_workers; i++)
+        oe_thread_join(pool->workers[i]);
+
+    oe_semaphore_destroy(&pool->pending);
+    oe_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/* Start one worker per TCS not used by switchless enclave workers */
+static oe_result_t _start_pool(oe_enclave_t* enclave, oe_async_pool_t** out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_async_pool_t* pool = NULL;
+    size_t num_workers = enclave->num_bindings;
+    bool semaphore_created = false;
+
+    if (enclave->switchless_manager)
+        num_workers -= enclave->switchless_manager->num_enclave_workers;
+
+    if (num_workers > OE_ASYNC_MAX_WORKERS)
+        num_workers = OE_ASYNC_MAX_WORKERS;
+
+    if (num_workers == 0)
+        num_workers = 1;
+
+    if (!(pool = (oe_async_pool_t*)calloc(1, sizeof(oe_async_pool_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    pool->enclave = enclave;
+
+    if (oe_mutex_init(&pool->lock) != 0)
+    {
+        free(pool);
+        pool = NULL;
+        OE_RAISE(OE_FAILURE);
+    }
+
+    if (oe_semaphore_init(&pool->pending, 0) != 0)
+        OE_RAISE(OE_FAILURE);
+
+    semaphore_created = true;
+
+    for (; pool->num_workers < num_workers; pool->num_workers++)
+    {
+        if (oe_thread_create(
+                &pool->workers[pool->num_workers], _worker, pool) != 0)
+            OE_RAISE(OE_FAILURE);
+    }
+
+    *out = pool;
+    pool = NULL;
+    result = OE_OK;
+
+done:
+
+    if (pool)
+    {
+        if (semaphore_created)
+        {
+            _free_pool(pool);
+        }
+        else
+        {
+            oe_mutex_destroy(&pool->lock);
+            free(pool);
+        }
+    }
+
+    return result;
+}
+
+static oe_result_t _get_pool(oe_enclave_t* enclave, oe_async_pool_t** out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_async_pool_t* pool;
+
+    if ((pool = enclave->async_pool))
+    {
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+        *out = pool;
+        return OE_OK;
+    }
+
+    oe_mutex_lock(&enclave->lock);
+    {
+        if (!(pool = enclave->async_pool))
+        {
+            if ((result = _start_pool(enclave, &pool)) != OE_OK)
+            {
+                oe_mutex_unlock(&enclave->lock);
+                OE_RAISE(result);
+            }
+
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            enclave->async_pool = pool;
+        }
+    }
+    oe_mutex_unlock(&enclave->lock);
+
+    *out = pool;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_function_async()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_function_async(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    oe_async_call_callback_t callback,
+    void* callback_arg,
+    oe_async_call_t** call_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_async_pool_t* pool;
+    oe_async_call_t* call = NULL;
+    bool queued = false;
+
+    if (call_out)
+        *call_out = NULL;
+
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_get_pool(enclave, &pool));
+
+    if (!(call = (oe_async_call_t*)calloc(1, sizeof(oe_async_call_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (oe_semaphore_init(&call->done, 0) != 0)
+    {
+        free(call);
+        call = NULL;
+        OE_RAISE(OE_FAILURE);
+    }
+
+    call->function_id = function_id;
+    call->input_buffer = input_buffer;
+    call->input_buffer_size = input_buffer_size;
+    call->output_buffer = output_buffer;
+    call->output_buffer_size = output_buffer_size;
+    call->callback = callback;
+    call->callback_arg = callback_arg;
+    call->result = OE_UNEXPECTED;
+    call->detached = !call_out;
+
+    /* Hand out the handle before a worker can complete the call */
+    if (call_out)
+        *call_out = call;
+
+    oe_mutex_lock(&pool->lock);
+    {
+        if (!pool->stopping)
+        {
+            if (pool->tail)
+                pool->tail->next = call;
+            else
+                pool->head = call;
+
+            pool->tail = call;
+            queued = true;
+        }
+    }
+    oe_mutex_unlock(&pool->lock);
+
+    if (!queued)
+    {
+        if (call_out)
+            *call_out = NULL;
+
+        OE_RAISE(OE_FAILURE);
+    }
+
+    oe_semaphore_post(&pool->pending);
+    call = NULL;
+
+    result = OE_OK;
+
+done:
+
+    if (call)
+        _free_call(call);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_async_pool()
+**
+**==============================================================================
+*/
+
+void oe_stop_async_pool(oe_enclave_t* enclave)
+{
+    oe_async_pool_t* pool = enclave->async_pool;
+
+    if (!pool)
+        return;
+
+    _free_pool(pool);
+    enclave->async_pool = NULL;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_ASYNCCALLS_H
+#define _OE_HOST_SGX_ASYNCCALLS_H
+
+#include "../hostthread.h"
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** oe_async_pool_t
+**
+**     Host threads that perform the asynchronous ECALLs of one enclave (see
+**     oe_call_enclave_function_async()). Calls are queued in FIFO order;
+**     the pending semaphore counts the queued calls plus one wake-up per
+**     worker when the pool is stopping.
+**
+**==============================================================================
+*/
+
+/* Maximum number of threads of a pool */
+#define OE_ASYNC_MAX_WORKERS 8
+
+struct _oe_async_call
+{
+    struct _oe_async_call* next;
+
+    uint32_t function_id;
+    const void* input_buffer;
+    size_t input_buffer_size;
+    void* output_buffer;
+    size_t output_buffer_size;
+    oe_async_call_callback_t callback;
+    void* callback_arg;
+
+    /* The outcome of the call (valid once complete is set) */
+    size_t output_bytes_written;
+    oe_result_t result;
+    volatile uint64_t complete;
+
+    /* Released by the pool thread once the call is complete */
+    oe_semaphore done;
+
+    /* The pool releases the call itself if the caller has no handle */
+    bool detached;
+};
+
+typedef struct _oe_async_pool
+{
+    oe_enclave_t* enclave;
+
+    /* Queue of pending calls (protected by lock) */
+    oe_mutex lock;
+    oe_async_call_t* head;
+    oe_async_call_t* tail;
+    bool stopping;
+
+    oe_semaphore pending;
+
+    oe_thread_handle workers[OE_ASYNC_MAX_WORKERS];
+    size_t num_workers;
+} oe_async_pool_t;
+
+/* Complete the queued calls, stop the threads and release the pool */
+void oe_stop_async_pool(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SGX_ASYNCCALLS_H */
@@ -21,6 +21,7 @@
 #include <openenclave/bits/safecrt.h>
 #include <openenclave/bits/safemath.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/calls.h>
 #include <openenclave/internal/raise.h>
 #include <openenclave/internal/registers.h>
@@ -28,45 +29,61 @@
 #include <openenclave/internal/utils.h>
 #include "../ocalls.h"
 #include "asmdefs.h"
+#include "callstats.h"
 #include "enclave.h"
+#include "enclavethreads.h"
+#include "hostheap.h"
 #include "ocalls.h"
 
 /*
 **==============================================================================
 **
-** _set_thread_binding()
-**
-**     Store the thread data in the GS segment register. Note that the GS
-**     register is unused on X86-64 on Linux, unlike the FS register that is
-**     used by the pthread implementation.
+** Per-thread binding state
 **
-**     The OE_AEP() function (aep.S) uses the GS segment register to retrieve
-**     the ThreadBinding.tcs field.
+**     _thread_binding: the binding of the ECALL the thread is currently in.
+**     _cached_binding: the binding this thread released most recently. The
+**         next ECALL from the thread first tries to claim it again, which
+**         takes a single atomic operation when no other thread claimed it.
+**     _ecall_depth: the number of ECALLs the thread is currently in (across
+**         all enclaves). Only a thread inside an ECALL can nest.
 **
 **==============================================================================
 */
 
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 #define USE_TLS_FOR_THREADING_BINDING
 
 #if defined(USE_TLS_FOR_THREADING_BINDING)
-static oe_once_type _thread_binding_once;
-static oe_thread_key _thread_binding_key;
+static THREAD_LOCAL ThreadBinding* _thread_binding;
 #endif
 
-#if defined(USE_TLS_FOR_THREADING_BINDING)
-static void _create_thread_binding_key(void)
-{
-    oe_thread_key_create(&_thread_binding_key);
-}
-#endif
+static THREAD_LOCAL ThreadBinding* _cached_binding;
+static THREAD_LOCAL uint64_t _ecall_depth;
+
+/*
+**==============================================================================
+**
+** _set_thread_binding()
+**
+**     Store the thread binding in thread-local storage. Alternatively, store
+**     it in the GS segment register. Note that the GS register is unused on
+**     X86-64 on Linux, unlike the FS register that is used by the pthread
+**     implementation.
+**
+**==============================================================================
+*/
 
 static void _set_thread_binding(ThreadBinding* binding)
 {
 #if defined(USE_TLS_FOR_THREADING_BINDING)
-    oe_once(&_thread_binding_once, _create_thread_binding_key);
-    oe_thread_setspecific(_thread_binding_key, binding);
+    _thread_binding = binding;
 #else
-    return oe_set_gs_register_base(binding);
+    oe_set_gs_register_base(binding);
 #endif
 }
 
@@ -75,7 +92,7 @@ static void _set_thread_binding(ThreadBinding* binding)
 **
 ** GetThreadBinding()
 **
-**     Retrieve the a pointer to the ThreadBinding from the GS segment register.
+**     Retrieve the pointer to the ThreadBinding of the calling thread.
 **
 **==============================================================================
 */
@@ -83,8 +100,7 @@ static void _set_thread_binding(ThreadBinding* binding)
 ThreadBinding* GetThreadBinding()
 {
 #if defined(USE_TLS_FOR_THREADING_BINDING)
-    oe_once(&_thread_binding_once, _create_thread_binding_key);
-    return (ThreadBinding*)oe_thread_getspecific(_thread_binding_key);
+    return _thread_binding;
 #else
     return (ThreadBinding*)oe_get_gs_register_base();
 #endif
@@ -244,24 +260,29 @@ done:
 **
 ** _find_host_func()
 **
-**     Find the function in the host with the given name.
+**     Find the function in the host with the given name. Resolving a symbol
+**     takes the loader lock and searches every loaded module, so functions
+**     that are found are cached in the enclave.
 **
 **==============================================================================
 */
 
-static oe_host_func_t _find_host_func(const char* name)
+static oe_host_func_t _find_host_func(oe_enclave_t* enclave, const char* name)
 {
+    oe_host_func_t func;
+
+    if ((func = oe_get_cached_host_func(enclave, name)))
+        return func;
+
 #if defined(__linux__)
 
     void* handle = dlopen(NULL, RTLD_NOW | RTLD_GLOBAL);
     if (!handle)
         return NULL;
 
-    oe_host_func_t func = (oe_host_func_t)dlsym(handle, name);
+    func = (oe_host_func_t)dlsym(handle, name);
     dlclose(handle);
 
-    return func;
-
 #elif defined(_WIN32)
 
     HANDLE handle = GetModuleHandle(NULL);
@@ -269,9 +290,14 @@ static oe_host_func_t _find_host_func(const char* name)
     if (!handle)
         return NULL;
 
-    return (oe_host_func_t)GetProcAddress(handle, name);
+    func = (oe_host_func_t)GetProcAddress(handle, name);
 
 #endif
+
+    if (func)
+        oe_cache_host_func(enclave, name, func);
+
+    return func;
 }
 
 /*
@@ -295,7 +321,7 @@ static void _handle_call_host(uint64_t arg, oe_enclave_t* enclave)
     args->result = OE_UNEXPECTED;
 
     /* Find the host function with this name */
-    if (!(func = _find_host_func(args->func)))
+    if (!(func = _find_host_func(enclave, args->func)))
     {
         args->result = OE_NOT_FOUND;
         return;
@@ -307,6 +333,32 @@ static void _handle_call_host(uint64_t arg, oe_enclave_t* enclave)
     args->result = OE_OK;
 }
 
+/*
+**==============================================================================
+**
+** _handle_get_host_func()
+**
+**     Handle requests from the enclave for the address of a host function
+**
+**==============================================================================
+*/
+
+static void _handle_get_host_func(uint64_t arg, oe_enclave_t* enclave)
+{
+    oe_get_host_func_args_t* args = (oe_get_host_func_args_t*)arg;
+
+    if (!args)
+        return;
+
+    if (!(args->func = _find_host_func(enclave, args->name)))
+    {
+        args->result = OE_NOT_FOUND;
+        return;
+    }
+
+    args->result = OE_OK;
+}
+
 /*
 **==============================================================================
 **
@@ -342,14 +394,14 @@ done:
 /*
 **==============================================================================
 **
-** _handle_call_host_function()
+** oe_handle_call_host_function()
 **
-** Handle calls from the enclave.
+** Handle calls from the enclave. Also used by the switchless host workers.
 **
 **==============================================================================
 */
 
-static oe_result_t _handle_call_host_function(
+oe_result_t oe_handle_call_host_function(
     uint64_t arg,
     oe_enclave_t* enclave)
 {
@@ -357,6 +409,7 @@ static oe_result_t _handle_call_host_function(
     oe_result_t result = OE_OK;
     oe_ocall_func_t func = NULL;
     size_t buffer_size = 0;
+    uint64_t start = 0;
 
     args_ptr = (oe_call_host_function_args_t*)arg;
     if (args_ptr == NULL)
@@ -390,6 +443,9 @@ static oe_result_t _handle_call_host_function(
     if ((args_ptr->output_buffer_size % OE_EDGER8R_BUFFER_ALIGNMENT) != 0)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    if (enclave->call_stats)
+        start = oe_call_stats_now();
+
     // Call the function.
     func(
         args_ptr->input_buffer,
@@ -398,6 +454,10 @@ static oe_result_t _handle_call_host_function(
         args_ptr->output_buffer_size,
         &args_ptr->output_bytes_written);
 
+    if (start)
+        oe_record_call(
+            enclave, OE_CALL_STATS_OCALL, args_ptr->function_id, start);
+
     // The ocall succeeded.
     args_ptr->result = OE_OK;
     result = OE_OK;
@@ -406,6 +466,68 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _flush_deferred_ocalls()
+**
+**     Run the calls that the given TCS queued since it last exited the
+**     enclave, in order, and empty its queue. Called on every exit of the
+**     TCS before the OCALL or ERET is handled. The results of the calls are
+**     discarded.
+**
+**==============================================================================
+*/
+
+static void _flush_deferred_ocalls(oe_enclave_t* enclave, void* tcs)
+{
+    ThreadBinding* binding;
+    oe_scratch_region_t* region;
+    oe_deferred_ocall_queue_t* queue;
+    uint8_t* p;
+    uint64_t size;
+
+    if (!enclave->scratch_regions ||
+        !(binding = oe_get_tcs_binding(enclave, (uint64_t)tcs)))
+    {
+        return;
+    }
+
+    region = &enclave->scratch_regions[binding - enclave->bindings];
+
+    if (!(queue = region->deferred_queue) || !(size = queue->size))
+        return;
+
+    if (size > region->deferred_queue_size - sizeof(*queue))
+        size = region->deferred_queue_size - sizeof(*queue);
+
+    p = (uint8_t*)(queue + 1);
+
+    while (size >= OE_DEFERRED_OCALL_HEADER_SIZE)
+    {
+        oe_call_host_function_args_t* args = (oe_call_host_function_args_t*)p;
+        uint64_t buffers_size = size - OE_DEFERRED_OCALL_HEADER_SIZE;
+        uint64_t record_size;
+
+        if (args->input_buffer_size > buffers_size ||
+            args->output_buffer_size >
+                buffers_size - args->input_buffer_size)
+        {
+            break;
+        }
+
+        record_size = OE_DEFERRED_OCALL_HEADER_SIZE +
+                      args->input_buffer_size + args->output_buffer_size;
+
+        oe_handle_call_host_function((uint64_t)args, enclave);
+
+        p += record_size;
+        size -= record_size;
+    }
+
+    queue->size = 0;
+}
+
 /*
 **==============================================================================
 **
@@ -424,6 +546,7 @@ static oe_result_t _handle_ocall(
     uint64_t* arg_out)
 {
     oe_result_t result = OE_UNEXPECTED;
+    uint64_t start = 0;
 
     if (!enclave || !tcs)
         OE_RAISE(OE_INVALID_PARAMETER);
@@ -431,6 +554,10 @@ static oe_result_t _handle_ocall(
     if (arg_out)
         *arg_out = 0;
 
+    /* Calls by function id are timed by oe_handle_call_host_function() */
+    if (enclave->call_stats && func != OE_OCALL_CALL_HOST_FUNCTION)
+        start = oe_call_stats_now();
+
     switch ((oe_func_t)func)
     {
         case OE_OCALL_CALL_HOST:
@@ -441,8 +568,12 @@ static oe_result_t _handle_ocall(
             _handle_call_host_by_address(arg_in, enclave);
             break;
 
+        case OE_OCALL_GET_HOST_FUNC:
+            _handle_get_host_func(arg_in, enclave);
+            break;
+
         case OE_OCALL_CALL_HOST_FUNCTION:
-            _handle_call_host_function(arg_in, enclave);
+            oe_handle_call_host_function(arg_in, enclave);
             break;
 
         case OE_OCALL_MALLOC:
@@ -465,6 +596,10 @@ static oe_result_t _handle_ocall(
             HandleThreadWait(enclave, arg_in);
             break;
 
+        case OE_OCALL_THREAD_WAIT_TIMEOUT:
+            HandleThreadWaitTimeout(enclave, arg_in);
+            break;
+
         case OE_OCALL_THREAD_WAKE:
             HandleThreadWake(enclave, arg_in);
             break;
@@ -473,6 +608,14 @@ static oe_result_t _handle_ocall(
             HandleThreadWakeWait(enclave, arg_in);
             break;
 
+        case OE_OCALL_THREAD_WAKE_MULTIPLE:
+            HandleThreadWakeMultiple(enclave, arg_in);
+            break;
+
+        case OE_OCALL_THREAD_CREATE:
+            oe_handle_thread_create(enclave, arg_in, arg_out);
+            break;
+
         case OE_OCALL_GET_QUOTE:
             HandleGetQuote(arg_in);
             break;
@@ -507,6 +650,14 @@ static oe_result_t _handle_ocall(
             oe_handle_log(enclave, arg_in);
             break;
 
+        case OE_OCALL_GROW_HOST_HEAP:
+            oe_handle_grow_host_heap(enclave, arg_in, arg_out);
+            break;
+
+        case OE_OCALL_FLUSH_DEFERRED:
+            /* The queue was flushed when the enclave exited */
+            break;
+
         default:
         {
             /* No function found with the number */
@@ -518,6 +669,9 @@ static oe_result_t _handle_ocall(
 
 done:
 
+    if (start)
+        oe_record_call(enclave, OE_CALL_STATS_BUILTIN_OCALL, func, start);
+
     return result;
 }
 
@@ -570,17 +724,10 @@ int __oe_dispatch_ocall(
             /**
              * GetThreadBinding may not work since it uses pthread APIs.
              * pthread depends on FS register being set correctly, which
-             * is what we are trying to do. So loop through the bindings
-             * to figure out the correct one for the given tcs.
+             * is what we are trying to do. So look up the binding
+             * from the given tcs.
              */
-            for (size_t i = 0; i < OE_COUNTOF(enclave->bindings); ++i)
-            {
-                if (enclave->bindings[i].tcs == (uint64_t)tcs)
-                {
-                    binding = &enclave->bindings[i];
-                    break;
-                }
-            }
+            binding = oe_get_tcs_binding(enclave, (uint64_t)tcs);
 
             /**
              * Restore FS and GS registers when making an OCALL.
@@ -595,6 +742,8 @@ int __oe_dispatch_ocall(
             binding = GetThreadBinding();
         }
 
+        _flush_deferred_ocalls(enclave, tcs);
+
         oe_result_t result = _handle_ocall(enclave, tcs, func, arg, &arg_out);
         *arg1_out = oe_make_call_arg1(OE_CODE_ORET, func, 0, result);
         *arg2_out = arg_out;
@@ -616,6 +765,53 @@ int __oe_dispatch_ocall(
     return 1;
 }
 
+/* Whether the binding belongs to the given enclave */
+static bool _is_enclave_binding(
+    const oe_enclave_t* enclave,
+    const ThreadBinding* binding)
+{
+    return binding >= enclave->bindings &&
+           binding < enclave->bindings + enclave->num_bindings;
+}
+
+/* Atomically set _OE_THREAD_BUSY if the binding is not busy */
+static bool _try_claim_binding(ThreadBinding* binding)
+{
+    uint64_t flags = binding->flags;
+
+    return !(flags & _OE_THREAD_BUSY) &&
+           oe_atomic_compare_and_swap(
+               &binding->flags, flags, flags | _OE_THREAD_BUSY);
+}
+
+/* Find a busy binding of the enclave owned by the calling thread */
+static ThreadBinding* _find_owned_binding(
+    oe_enclave_t* enclave,
+    oe_thread thread)
+{
+    ThreadBinding* binding = GetThreadBinding();
+
+    /* The binding is usually the current one */
+    if (binding && _is_enclave_binding(enclave, binding) &&
+        (binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
+    {
+        return binding;
+    }
+
+    /* ECALLs into other enclaves may have replaced the current binding. The
+     * thread field of a binding is cleared before the binding is released,
+     * so a stale value never matches the calling thread */
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        binding = &enclave->bindings[i];
+
+        if ((binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
+            return binding;
+    }
+
+    return NULL;
+}
+
 /*
 **==============================================================================
 **
@@ -626,61 +822,66 @@ int __oe_dispatch_ocall(
 **         - an enclave thread context
 **
 **     If such a binding already exists, the binding's count in incremented.
-**     Else, the calling host thread is bound to the first available enclave
-**     thread context.
+**     Else, the calling host thread is bound to the enclave thread context it
+**     used last (if available) or else to the first available one.
 **
-**     Returns the address of the thread control structure (TCS) corresponding
-**     to the enclave thread context.
+**     Returns the binding, whose tcs field is the address of the thread
+**     control structure (TCS) corresponding to the enclave thread context.
 **
 **==============================================================================
 */
 
-static void* _assign_tcs(oe_enclave_t* enclave)
+static ThreadBinding* _assign_tcs(oe_enclave_t* enclave)
 {
-    void* tcs = NULL;
-    size_t i;
+    ThreadBinding* binding = NULL;
     oe_thread thread = oe_thread_self();
 
-    oe_mutex_lock(&enclave->lock);
+    /* A thread that is in an ECALL may already be bound to the enclave */
+    if (_ecall_depth &&
+        (binding = _find_owned_binding(enclave, thread)) != NULL)
     {
-        /* First attempt to find a busy td_t owned by this thread */
-        for (i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
+        binding->count++;
+        goto done;
+    }
 
-            if ((binding->flags & _OE_THREAD_BUSY) && binding->thread == thread)
-            {
-                binding->count++;
-                tcs = (void*)binding->tcs;
-                break;
-            }
-        }
+    /* Attempt to reclaim the binding this thread used last */
+    binding = _cached_binding;
 
-        /* If binding not found above, look for an available ThreadBinding */
-        if (!tcs)
+    if (!binding || !_is_enclave_binding(enclave, binding) ||
+        !_try_claim_binding(binding))
+    {
+        binding = NULL;
+
+        /* Look for an available ThreadBinding */
+        for (size_t i = 0; i < enclave->num_bindings; i++)
         {
-            for (i = 0; i < enclave->num_bindings; i++)
+            if (_try_claim_binding(&enclave->bindings[i]))
             {
-                ThreadBinding* binding = &enclave->bindings[i];
-
-                if (!(binding->flags & _OE_THREAD_BUSY))
-                {
-                    binding->flags |= _OE_THREAD_BUSY;
-                    binding->thread = thread;
-                    binding->count = 1;
-                    tcs = (void*)binding->tcs;
-
-                    /* Set into TSD so asynchronous exceptions can get it */
-                    _set_thread_binding(binding);
-                    assert(GetThreadBinding() == binding);
-                    break;
-                }
+                binding = &enclave->bindings[i];
+                break;
             }
         }
+
+        if (!binding)
+            goto done;
     }
-    oe_mutex_unlock(&enclave->lock);
 
-    return tcs;
+    binding->thread = thread;
+    binding->count = 1;
+    _cached_binding = binding;
+
+done:
+
+    if (binding)
+    {
+        _ecall_depth++;
+
+        /* Set into TLS so asynchronous exceptions can get it */
+        _set_thread_binding(binding);
+        assert(GetThreadBinding() == binding);
+    }
+
+    return binding;
 }
 
 /*
@@ -688,40 +889,27 @@ static void* _assign_tcs(oe_enclave_t* enclave)
 **
 ** _release_tcs()
 **
-**     Decrement the ThreadBinding.count field of the binding associated with
-**     the given TCS. If the field becomes zero, the binding is dissolved.
+**     Decrement the ThreadBinding.count field of the given binding. If the
+**     field becomes zero, the binding is dissolved.
 **
 **==============================================================================
 */
 
-static void _release_tcs(oe_enclave_t* enclave, void* tcs)
+static void _release_tcs(ThreadBinding* binding)
 {
-    size_t i;
+    _ecall_depth--;
 
-    oe_mutex_lock(&enclave->lock);
+    if (--binding->count == 0)
     {
-        for (i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
-
-            if ((binding->flags & _OE_THREAD_BUSY) &&
-                (void*)binding->tcs == tcs)
-            {
-                binding->count--;
-
-                if (binding->count == 0)
-                {
-                    binding->flags &= (~_OE_THREAD_BUSY);
-                    binding->thread = 0;
-                    memset(&binding->event, 0, sizeof(binding->event));
-                    _set_thread_binding(NULL);
-                    assert(GetThreadBinding() == NULL);
-                }
-                break;
-            }
-        }
+        binding->thread = 0;
+        memset(&binding->event, 0, sizeof(binding->event));
+        _set_thread_binding(NULL);
+        assert(GetThreadBinding() == NULL);
+
+        /* Only the owner modifies the flags of a busy binding */
+        OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+        binding->flags &= ~_OE_THREAD_BUSY;
     }
-    oe_mutex_unlock(&enclave->lock);
 }
 
 /*
@@ -741,6 +929,7 @@ oe_result_t oe_ecall(
     uint64_t* arg_out_ptr)
 {
     oe_result_t result = OE_UNEXPECTED;
+    ThreadBinding* binding = NULL;
     void* tcs = NULL;
     oe_code_t code = OE_CODE_ECALL;
     oe_code_t code_out = 0;
@@ -752,9 +941,11 @@ oe_result_t oe_ecall(
         OE_RAISE(OE_INVALID_PARAMETER);
 
     /* Assign a td_t for this operation */
-    if (!(tcs = _assign_tcs(enclave)))
+    if (!(binding = _assign_tcs(enclave)))
         OE_RAISE(OE_OUT_OF_THREADS);
 
+    tcs = (void*)binding->tcs;
+
     /* Perform ECALL or ORET */
     OE_CHECK(
         _do_eenter(
@@ -769,6 +960,11 @@ oe_result_t oe_ecall(
             &result_out,
             &arg_out));
 
+    /* Run the calls the enclave queued before returning. The exception
+     * handler leaves the queue to the code it interrupted. */
+    if (func != OE_ECALL_VIRTUAL_EXCEPTION_HANDLER)
+        _flush_deferred_ocalls(enclave, tcs);
+
     /* Process OCALLS */
     if (code_out != OE_CODE_ERET)
         OE_RAISE(OE_UNEXPECTED);
@@ -780,8 +976,8 @@ oe_result_t oe_ecall(
 
 done:
 
-    if (enclave && tcs)
-        _release_tcs(enclave, tcs);
+    if (binding)
+        _release_tcs(binding);
 
     /* ATTN: this causes an assertion with call nesting. */
     /* ATTN: make enclave argument a cookie. */
@@ -794,43 +990,55 @@ done:
 /*
 **==============================================================================
 **
-** _find_enclave_func()
+** _call_enclave()
 **
-**     Find the enclave function with the given name
+**     Call the enclave function with the given index in enclave->ecalls.
 **
 **==============================================================================
 */
 
-static uint64_t _find_enclave_func(
+static oe_result_t _call_enclave(
     oe_enclave_t* enclave,
-    const char* func,
-    uint64_t* index)
+    uint64_t index,
+    void* args)
 {
-    size_t i;
-
-    if (index)
-        *index = 0;
-
-    /* Reject null parameters and empty string funcs (checked by !*func). */
-    if (!enclave || !func || !*func || !index)
-        return 0;
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_args_t call_enclave_args;
+    uint64_t start = oe_call_stats_start(enclave);
 
-    size_t len = strlen(func);
-    uint64_t code = StrCode(func, len);
+    /* Initialize the call_enclave_args structure */
+    {
+        call_enclave_args.func = index;
+        call_enclave_args.vaddr = enclave->ecalls[index].vaddr;
+        call_enclave_args.args = args;
+        call_enclave_args.result = OE_UNEXPECTED;
+    }
 
-    for (i = 0; i < enclave->num_ecalls; i++)
+    /* Perform the ECALL */
     {
-        const ECallNameAddr* p = &enclave->ecalls[i];
+        uint64_t arg_out = 0;
 
-        if (p->code == code && memcmp(p->name, func, len) == 0)
-        {
-            *index = i;
-            return enclave->ecalls[i].vaddr;
-        }
+        OE_CHECK(
+            oe_ecall(
+                enclave,
+                OE_ECALL_CALL_ENCLAVE,
+                (uint64_t)&call_enclave_args,
+                &arg_out));
+
+        OE_CHECK((oe_result_t)arg_out);
     }
 
-    /* Not found! */
-    return 0;
+    /* Check the result */
+    OE_CHECK(call_enclave_args.result);
+
+    result = OE_OK;
+
+done:
+
+    if (start)
+        oe_record_call(enclave, OE_CALL_STATS_LEGACY_ECALL, index, start);
+
+    return result;
 }
 
 /*
@@ -846,40 +1054,81 @@ static uint64_t _find_enclave_func(
 oe_result_t oe_call_enclave(oe_enclave_t* enclave, const char* func, void* args)
 {
     oe_result_t result = OE_UNEXPECTED;
-    oe_call_enclave_args_t call_enclave_args;
+    uint64_t index;
 
     /* Reject invalid parameters */
     if (!enclave || !func)
         OE_RAISE(OE_INVALID_PARAMETER);
 
-    /* Initialize the call_enclave_args structure */
-    {
-        if (!(call_enclave_args.vaddr =
-                  _find_enclave_func(enclave, func, &call_enclave_args.func)))
-        {
-            OE_RAISE(OE_NOT_FOUND);
-        }
+    if (!oe_find_ecall(enclave, func, &index))
+        OE_RAISE(OE_NOT_FOUND);
 
-        call_enclave_args.args = args;
-        call_enclave_args.result = OE_UNEXPECTED;
-    }
+    OE_CHECK(_call_enclave(enclave, index, args));
 
-    /* Perform the ECALL */
-    {
-        uint64_t arg_out = 0;
+    result = OE_OK;
 
-        OE_CHECK(
-            oe_ecall(
-                enclave,
-                OE_ECALL_CALL_ENCLAVE,
-                (uint64_t)&call_enclave_args,
-                &arg_out));
+done:
+    return result;
+}
 
-        OE_CHECK((oe_result_t)arg_out);
-    }
+/*
+**==============================================================================
+**
+** oe_get_enclave_function_handle()
+**
+**     Resolve the named enclave function to a handle for
+**     oe_call_enclave_by_handle(). The handle is the index of the function
+**     plus one, so that zero is never a valid handle.
+**
+**==============================================================================
+*/
 
-    /* Check the result */
-    OE_CHECK(call_enclave_args.result);
+oe_result_t oe_get_enclave_function_handle(
+    oe_enclave_t* enclave,
+    const char* func,
+    oe_enclave_function_handle_t* handle)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    uint64_t index;
+
+    if (handle)
+        *handle = 0;
+
+    if (!enclave || !func || !handle)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!oe_find_ecall(enclave, func, &index))
+        OE_RAISE(OE_NOT_FOUND);
+
+    *handle = index + 1;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_by_handle()
+**
+**     Call the enclave function with the given handle.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    oe_enclave_function_handle_t handle,
+    void* args)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!enclave || handle == 0 || handle > enclave->num_ecalls)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    OE_CHECK(_call_enclave(enclave, handle - 1, args));
 
     result = OE_OK;
 
@@ -910,6 +1159,7 @@ oe_result_t oe_call_enclave_function(
 {
     oe_result_t result = OE_UNEXPECTED;
     oe_call_enclave_function_args_t args;
+    uint64_t start = 0;
 
     /* Reject invalid parameters */
     if (!enclave)
@@ -926,6 +1176,8 @@ oe_result_t oe_call_enclave_function(
         args.result = OE_UNEXPECTED;
     }
 
+    start = oe_call_stats_start(enclave);
+
     /* Perform the ECALL */
     {
         uint64_t arg_out = 0;
@@ -946,6 +1198,82 @@ oe_result_t oe_call_enclave_function(
     result = OE_OK;
 
 done:
+
+    if (start)
+        oe_record_call(enclave, OE_CALL_STATS_ECALL, function_id, start);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_call_enclave_function_batch()
+**
+**     Perform several enclave function calls with a single ECALL. The
+**     enclave reads the calls directly from the caller's array and stores
+**     the outcome of each call in its entry.
+**
+**==============================================================================
+*/
+
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_enclave_function_batch_args_t args;
+    uint64_t start = 0;
+
+    /* Reject invalid parameters */
+    if (!enclave || (!calls && num_calls))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (num_calls == 0)
+    {
+        result = OE_OK;
+        goto done;
+    }
+
+    for (size_t i = 0; i < num_calls; i++)
+    {
+        calls[i].output_bytes_written = 0;
+        calls[i].result = OE_UNEXPECTED;
+    }
+
+    args.calls = calls;
+    args.num_calls = num_calls;
+
+    start = oe_call_stats_start(enclave);
+
+    /* Perform the ECALL */
+    {
+        uint64_t arg_out = 0;
+
+        OE_CHECK(
+            oe_ecall(
+                enclave,
+                OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH,
+                (uint64_t)&args,
+                &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+    }
+
+    result = OE_OK;
+
+done:
+
+    /* The calls share one transition, so each gets an equal share of it */
+    if (start)
+    {
+        uint64_t time = (oe_call_stats_now() - start) / num_calls;
+
+        for (size_t i = 0; i < num_calls; i++)
+            oe_record_call_time(
+                enclave, OE_CALL_STATS_ECALL, calls[i].function_id, time);
+    }
+
     return result;
 }
 
@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "callstats.h"
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <time.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/*
+**==============================================================================
+**
+** oe_call_stats_now()
+**
+**==============================================================================
+*/
+
+uint64_t oe_call_stats_now(void)
+{
+#if defined(__linux__)
+
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+        return 0;
+
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+
+#elif defined(_WIN32)
+
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (!frequency.QuadPart)
+        QueryPerformanceFrequency(&frequency);
+
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)(
+        (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+
+#endif
+}
+
+/*
+**==============================================================================
+**
+** oe_start_call_stats()
+** oe_stop_call_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_start_call_stats(oe_enclave_t* enclave, bool dump_on_terminate)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_call_stats_manager_t* manager = NULL;
+
+    if (!(manager = (oe_call_stats_manager_t*)calloc(1, sizeof(*manager))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    if (enclave->num_ocalls)
+    {
+        if (!(manager->ocalls = (oe_call_stats_t*)calloc(
+                  enclave->num_ocalls, sizeof(oe_call_stats_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        manager->num_ocalls = enclave->num_ocalls;
+    }
+
+    manager->dump_on_terminate = dump_on_terminate;
+    enclave->call_stats = manager;
+    manager = NULL;
+
+    result = OE_OK;
+
+done:
+
+    if (manager)
+    {
+        free(manager->ocalls);
+        free(manager);
+    }
+
+    return result;
+}
+
+static void _dump_stats(
+    const char* type,
+    const oe_call_stats_t* stats,
+    size_t num_stats,
+    size_t base)
+{
+    for (size_t i = 0; i < num_stats; i++)
+    {
+        const oe_call_stats_t* s = &stats[i];
+
+        if (!s->count)
+            continue;
+
+        fprintf(
+            stderr,
+            "%-12s %6zu count=%llu total=%lluns avg=%lluns max=%lluns\n",
+            type,
+            base + i,
+            (unsigned long long)s->count,
+            (unsigned long long)s->total_time,
+            (unsigned long long)(s->total_time / s->count),
+            (unsigned long long)s->max_time);
+    }
+}
+
+void oe_stop_call_stats(oe_enclave_t* enclave)
+{
+    oe_call_stats_manager_t* manager = enclave->call_stats;
+
+    if (!manager)
+        return;
+
+    if (manager->dump_on_terminate)
+    {
+        fprintf(stderr, "=== call statistics of %s\n", enclave->path);
+        _dump_stats("ECALL", manager->ecalls, OE_CALL_STATS_MAX_ECALLS, 0);
+        _dump_stats(
+            "LEGACY_ECALL",
+            manager->legacy_ecalls,
+            OE_CALL_STATS_MAX_ECALLS,
+            0);
+        _dump_stats("OCALL", manager->ocalls, manager->num_ocalls, 0);
+        _dump_stats(
+            "OE_OCALL",
+            manager->builtin_ocalls,
+            OE_CALL_STATS_MAX_BUILTIN_OCALLS,
+            OE_OCALL_BASE);
+    }
+
+    enclave->call_stats = NULL;
+    free(manager->ocalls);
+    free(manager);
+}
+
+/*
+**==============================================================================
+**
+** oe_record_call()
+** oe_record_call_time()
+**
+**     Update the statistics of a call. Calls of the same function may be
+**     recorded by several threads at once, so every field is updated with an
+**     atomic operation. A reader may see the fields of a call partially
+**     updated.
+**
+**==============================================================================
+*/
+
+static oe_call_stats_t* _get_stats(
+    oe_call_stats_manager_t* manager,
+    oe_call_stats_type_t type,
+    uint64_t function_id)
+{
+    switch (type)
+    {
+        case OE_CALL_STATS_ECALL:
+            if (function_id < OE_CALL_STATS_MAX_ECALLS)
+                return &manager->ecalls[function_id];
+            break;
+
+        case OE_CALL_STATS_LEGACY_ECALL:
+            if (function_id < OE_CALL_STATS_MAX_ECALLS)
+                return &manager->legacy_ecalls[function_id];
+            break;
+
+        case OE_CALL_STATS_OCALL:
+            if (function_id < manager->num_ocalls)
+                return &manager->ocalls[function_id];
+            break;
+
+        case OE_CALL_STATS_BUILTIN_OCALL:
+            if (function_id >= OE_OCALL_BASE &&
+                function_id - OE_OCALL_BASE < OE_CALL_STATS_MAX_BUILTIN_OCALLS)
+                return &manager->builtin_ocalls[function_id - OE_OCALL_BASE];
+            break;
+
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+void oe_record_call(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint64_t function_id,
+    uint64_t start)
+{
+    oe_record_call_time(
+        enclave, type, function_id, oe_call_stats_now() - start);
+}
+
+void oe_record_call_time(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint64_t function_id,
+    uint64_t time)
+{
+    oe_call_stats_t* stats;
+    uint64_t max;
+    uint32_t bucket = 0;
+
+    if (!(stats = _get_stats(enclave->call_stats, type, function_id)))
+        return;
+
+    while (bucket < OE_CALL_STATS_NUM_BUCKETS - 1 && (time >> (bucket + 1)))
+        bucket++;
+
+    oe_atomic_increment(&stats->count);
+    oe_atomic_add(&stats->total_time, time);
+    oe_atomic_increment(&stats->histogram[bucket]);
+
+    while (time > (max = stats->max_time) &&
+           !oe_atomic_compare_and_swap(&stats->max_time, max, time))
+        ;
+}
+
+/*
+**==============================================================================
+**
+** oe_get_enclave_call_stats()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_enclave_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint32_t function_id,
+    oe_call_stats_t* stats)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_call_stats_t* entry;
+
+    if (stats)
+        memset(stats, 0, sizeof(*stats));
+
+    if (!enclave || !stats)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (!enclave->call_stats)
+        OE_RAISE(OE_UNSUPPORTED);
+
+    if (!(entry = _get_stats(enclave->call_stats, type, function_id)))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    *stats = *entry;
+
+    result = OE_OK;
+
+done:
+    return result;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_CALLSTATS_H
+#define _OE_HOST_SGX_CALLSTATS_H
+
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** Call statistics (see OE_ENCLAVE_SETTING_CALL_STATS). When the setting is
+** not given, enclave->call_stats is null and callers skip the timing
+** altogether, so each call only pays for a single pointer test.
+**
+**==============================================================================
+*/
+
+/* Number of built-in OCALL numbers (starting at OE_OCALL_BASE) kept */
+#define OE_CALL_STATS_MAX_BUILTIN_OCALLS 64
+
+typedef struct _oe_call_stats_manager
+{
+    bool dump_on_terminate;
+    oe_call_stats_t ecalls[OE_CALL_STATS_MAX_ECALLS];
+    oe_call_stats_t legacy_ecalls[OE_CALL_STATS_MAX_ECALLS];
+    oe_call_stats_t builtin_ocalls[OE_CALL_STATS_MAX_BUILTIN_OCALLS];
+
+    /* One entry per function of enclave->ocalls */
+    oe_call_stats_t* ocalls;
+    size_t num_ocalls;
+} oe_call_stats_manager_t;
+
+/* Start collecting statistics (called once enclave->ocalls is set) */
+oe_result_t oe_start_call_stats(oe_enclave_t* enclave, bool dump_on_terminate);
+
+/* Print the statistics if requested and stop collecting them */
+void oe_stop_call_stats(oe_enclave_t* enclave);
+
+/* Return a timestamp in nanoseconds for oe_record_call() */
+uint64_t oe_call_stats_now(void);
+
+/* Return the start time of a call to pass to oe_record_call(), or zero when
+ * calls of the enclave are not timed. Every ECALL entry point uses this */
+OE_INLINE uint64_t oe_call_stats_start(oe_enclave_t* enclave)
+{
+    return enclave->call_stats ? oe_call_stats_now() : 0;
+}
+
+/* Record a call of the given type and function that started at start */
+void oe_record_call(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint64_t function_id,
+    uint64_t start);
+
+/* Record a call of the given type and function that took the given time */
+void oe_record_call_time(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint64_t function_id,
+    uint64_t time);
+
+#endif /* _OE_HOST_SGX_CALLSTATS_H */
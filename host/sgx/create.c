@@ -49,10 +49,15 @@ static const char* get_fullpath(const char* path)
 #include <openenclave/internal/utils.h>
 #include <string.h>
 #include "../memalign.h"
+#include "asynccalls.h"
+#include "callstats.h"
 #include "cpuid.h"
 #include "enclave.h"
+#include "enclavethreads.h"
 #include "exception.h"
+#include "hostheap.h"
 #include "sgxload.h"
+#include "switchless.h"
 
 static oe_once_type _enclave_init_once;
 
@@ -168,9 +173,11 @@ static oe_result_t _add_control_pages(
 
     /* Save the address of new TCS page into enclave object */
     {
-        if (enclave->num_bindings == OE_SGX_MAX_TCS)
+        if (enclave->num_bindings == enclave->bindings_capacity)
             OE_RAISE_MSG(
-                OE_FAILURE, "OE_SGX_MAX_TCS (%d) hit\n", OE_SGX_MAX_TCS);
+                OE_FAILURE,
+                "bindings_capacity (%zu) hit\n",
+                enclave->bindings_capacity);
 
         enclave->bindings[enclave->num_bindings++].tcs = enclave_addr + *vaddr;
     }
@@ -406,6 +413,21 @@ static oe_result_t _oe_add_data_pages(
         _add_heap_pages(
             context, enclave->addr, vaddr, size_settings->num_heap_pages));
 
+    /* Allocate one thread binding per TCS (they are cache-line aligned) */
+    if (!(enclave->bindings = (ThreadBinding*)oe_memalign(
+              THREAD_BINDING_ALIGNMENT,
+              size_settings->num_tcs * sizeof(ThreadBinding))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(
+        enclave->bindings, 0, size_settings->num_tcs * sizeof(ThreadBinding));
+    enclave->bindings_capacity = size_settings->num_tcs;
+
+    /* Each thread section below consists of two guard pages, the stack and
+     * the control pages. GetEnclaveEvent() relies on this fixed layout */
+    enclave->thread_section_size =
+        (2 + size_settings->num_stack_pages + 6) * OE_PAGE_SIZE;
+
     for (i = 0; i < size_settings->num_tcs; i++)
     {
         /* Add guard page */
@@ -431,6 +453,140 @@ done:
     return result;
 }
 
+/*
+**==============================================================================
+**
+** _create_thread_events()
+**
+**     Create the events of the thread bindings. Enclaves use these events
+**     when calling into the host to handle waits/wakes as part of the enclave
+**     mutex and condition variable implementation.
+**
+**==============================================================================
+*/
+
+static oe_result_t _create_thread_events(oe_enclave_t* enclave)
+{
+#if defined(_WIN32)
+
+    oe_result_t result = OE_UNEXPECTED;
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        ThreadBinding* binding = &enclave->bindings[i];
+
+        if (!(binding->event.handle = CreateEvent(
+                  0,     /* No security attributes */
+                  FALSE, /* Event is reset automatically */
+                  FALSE, /* Event is not put in a signaled state
+                            upon creation */
+                  0)))   /* No name */
+        {
+            OE_RAISE_MSG(OE_FAILURE, "CreateEvent failed", NULL);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+
+#else
+
+    OE_UNUSED(enclave);
+    return OE_OK;
+
+#endif
+}
+
+/* Release the thread bindings and their events */
+static void _free_thread_bindings(oe_enclave_t* enclave)
+{
+    if (!enclave->bindings)
+        return;
+
+#if defined(_WIN32)
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        ThreadBinding* binding = &enclave->bindings[i];
+
+        if (binding->event.handle)
+            CloseHandle(binding->event.handle);
+    }
+
+#endif
+
+    oe_memalign_free(enclave->bindings);
+    enclave->bindings = NULL;
+    enclave->num_bindings = 0;
+    enclave->bindings_capacity = 0;
+}
+
+/*
+**==============================================================================
+**
+** _create_scratch_regions()
+**
+**     Allocate an untrusted scratch region for each TCS. The enclave uses
+**     these for OCALL argument frames and marshaling buffers instead of
+**     allocating host memory with extra OCALLs. Each region is followed by
+**     the deferred OCALL queue of the TCS.
+**
+**==============================================================================
+*/
+
+static void _free_scratch_regions(oe_enclave_t* enclave)
+{
+    if (enclave->scratch_regions)
+    {
+        for (size_t i = 0; i < enclave->num_bindings; i++)
+            oe_memalign_free(enclave->scratch_regions[i].base);
+
+        free(enclave->scratch_regions);
+        enclave->scratch_regions = NULL;
+    }
+}
+
+static oe_result_t _create_scratch_regions(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+
+    if (!(enclave->scratch_regions = (oe_scratch_region_t*)calloc(
+              enclave->num_bindings, sizeof(oe_scratch_region_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < enclave->num_bindings; i++)
+    {
+        oe_scratch_region_t* region = &enclave->scratch_regions[i];
+
+        /* The deferred OCALL queue follows the scratch region */
+        region->base = oe_memalign(
+            OE_PAGE_SIZE,
+            OE_SCRATCH_REGION_SIZE + OE_DEFERRED_OCALL_QUEUE_SIZE);
+
+        if (!region->base)
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        region->tcs = enclave->bindings[i].tcs;
+        region->size = OE_SCRATCH_REGION_SIZE;
+        region->deferred_queue =
+            (oe_deferred_ocall_queue_t*)((uint8_t*)region->base +
+                                         OE_SCRATCH_REGION_SIZE);
+        region->deferred_queue_size = OE_DEFERRED_OCALL_QUEUE_SIZE;
+        region->deferred_queue->size = 0;
+    }
+
+    result = OE_OK;
+
+done:
+
+    if (result != OE_OK)
+        _free_scratch_regions(enclave);
+
+    return result;
+}
+
 /*
 **==============================================================================
 **
@@ -463,6 +619,23 @@ static oe_result_t _initialize_enclave(oe_enclave_t* enclave)
     // Pass the enclave handle to the enclave.
     args.enclave = enclave;
 
+    // Pass the per-TCS scratch regions to the enclave.
+    OE_CHECK(_create_scratch_regions(enclave));
+    args.scratch_regions = enclave->scratch_regions;
+    args.num_scratch_regions = enclave->num_bindings;
+
+    // Pass the first region of the untrusted heap (if any) to the enclave.
+    args.host_heap = NULL;
+    args.host_heap_size = 0;
+
+    if (enclave->host_heap_region_size)
+    {
+        if (!(args.host_heap = oe_add_host_heap_region(enclave)))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+
+        args.host_heap_size = enclave->host_heap_region_size;
+    }
+
     {
         uint64_t arg_out = 0;
         OE_CHECK(
@@ -654,6 +827,7 @@ oe_result_t oe_sgx_build_enclave(
 
     /* Build an array of all the ECALL functions in the .ecalls section */
     OE_CHECK(oeimage.build_ecall_array(&oeimage, enclave));
+    OE_CHECK(oe_build_ecall_table(enclave));
 
     /* Build ECALL pages for enclave (list of addresses) */
     OE_CHECK(_build_ecall_data(enclave, &ecall_data, &ecall_size));
@@ -723,6 +897,105 @@ void oe_free_enclave_ecalls(oe_enclave_t* enclave)
 
         free(enclave->ecalls);
     }
+
+    free(enclave->ecall_table);
+    enclave->ecall_table = NULL;
+    enclave->ecall_table_size = 0;
+}
+
+/*
+**==============================================================================
+**
+** _parse_enclave_settings()
+**
+**     Validate the array of oe_enclave_setting_t passed to oe_create_enclave()
+**     and extract the requested switchless workers, untrusted heap size and
+**     call statistics options.
+**
+**==============================================================================
+*/
+
+typedef struct _enclave_settings
+{
+    size_t num_host_workers;
+    size_t num_enclave_workers;
+    size_t host_heap_region_size;
+    bool call_stats;
+    bool dump_call_stats;
+} enclave_settings_t;
+
+static oe_result_t _parse_enclave_settings(
+    const void* config,
+    uint32_t config_size,
+    enclave_settings_t* out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    const oe_enclave_setting_t* settings = (const oe_enclave_setting_t*)config;
+    size_t num_settings = config_size / sizeof(oe_enclave_setting_t);
+
+    memset(out, 0, sizeof(*out));
+
+    if (!config != !config_size)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    if (config_size % sizeof(oe_enclave_setting_t))
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    for (size_t i = 0; i < num_settings; i++)
+    {
+        switch (settings[i].setting_type)
+        {
+            case OE_ENCLAVE_SETTING_SWITCHLESS:
+            {
+                const oe_enclave_setting_switchless_t* switchless =
+                    settings[i].u.switchless;
+
+                if (!switchless || switchless->num_host_workers >
+                                       OE_SWITCHLESS_MAX_HOST_WORKERS)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                out->num_host_workers = switchless->num_host_workers;
+                out->num_enclave_workers = switchless->num_enclave_workers;
+                break;
+            }
+            case OE_ENCLAVE_SETTING_HOST_HEAP:
+            {
+                const oe_enclave_setting_host_heap_t* host_heap =
+                    settings[i].u.host_heap;
+
+                if (!host_heap)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                /* Regions are carved into spans; reject sizes that overflow */
+                if (host_heap->region_size >
+                    OE_SIZE_MAX - OE_HOST_HEAP_SPAN_SIZE)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                out->host_heap_region_size = oe_round_up_to_multiple(
+                    host_heap->region_size, OE_HOST_HEAP_SPAN_SIZE);
+                break;
+            }
+            case OE_ENCLAVE_SETTING_CALL_STATS:
+            {
+                const oe_enclave_setting_call_stats_t* call_stats =
+                    settings[i].u.call_stats;
+
+                if (!call_stats)
+                    OE_RAISE(OE_INVALID_PARAMETER);
+
+                out->call_stats = true;
+                out->dump_call_stats = call_stats->dump_on_terminate;
+                break;
+            }
+            default:
+                OE_RAISE(OE_INVALID_PARAMETER);
+        }
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
 }
 
 /*
@@ -753,6 +1026,9 @@ oe_result_t oe_create_enclave(
     oe_result_t result = OE_UNEXPECTED;
     oe_enclave_t* enclave = NULL;
     oe_sgx_load_context_t context;
+    enclave_settings_t settings;
+    bool pushed = false;
+    bool initialized = false;
 
     _initialize_enclave_host();
 
@@ -761,36 +1037,16 @@ oe_result_t oe_create_enclave(
 
     /* Check parameters */
     if (!enclave_path || !enclave_out || enclave_type != OE_ENCLAVE_TYPE_SGX ||
-        (flags & OE_ENCLAVE_FLAG_RESERVED) || config || config_size > 0)
+        (flags & OE_ENCLAVE_FLAG_RESERVED))
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    OE_CHECK(_parse_enclave_settings(config, config_size, &settings));
+
     /* Allocate and zero-fill the enclave structure */
     if (!(enclave = (oe_enclave_t*)calloc(1, sizeof(oe_enclave_t))))
         OE_RAISE(OE_OUT_OF_MEMORY);
 
-#if defined(_WIN32)
-
-    /* Create Windows events for each TCS binding. Enclaves use
-     * this event when calling into the host to handle waits/wakes
-     * as part of the enclave mutex and condition variable
-     * implementation.
-     */
-    for (size_t i = 0; i < enclave->num_bindings; i++)
-    {
-        ThreadBinding* binding = &enclave->bindings[i];
-
-        if (!(binding->event.handle = CreateEvent(
-                  0,     /* No security attributes */
-                  FALSE, /* Event is reset automatically */
-                  FALSE, /* Event is not put in a signaled state
-                            upon creation */
-                  0)))   /* No name */
-        {
-            OE_RAISE_MSG(OE_FAILURE, "CreateEvent failed", NULL);
-        }
-    }
-
-#endif
+    enclave->host_heap_region_size = settings.host_heap_region_size;
 
     /* Initialize the context parameter and any driver handles */
     OE_CHECK(
@@ -800,11 +1056,15 @@ oe_result_t oe_create_enclave(
     /* Build the enclave */
     OE_CHECK(oe_sgx_build_enclave(&context, enclave_path, NULL, enclave));
 
+    /* The thread bindings exist once the TCS pages are added */
+    OE_CHECK(_create_thread_events(enclave));
+
     /* Push the new created enclave to the global list. */
     if (oe_push_enclave_instance(enclave) != 0)
     {
         OE_RAISE(OE_FAILURE);
     }
+    pushed = true;
 #if defined(__linux__)
 
     /* Notify GDB that a new enclave is created */
@@ -818,12 +1078,25 @@ oe_result_t oe_create_enclave(
     enclave->ocalls = (const oe_ocall_func_t*)ocall_table;
     enclave->num_ocalls = ocall_table_size;
 
+    /* Collect call statistics from the first OCALL on */
+    if (settings.call_stats)
+        OE_CHECK(oe_start_call_stats(enclave, settings.dump_call_stats));
+
     /* Invoke enclave initialization. */
     OE_CHECK(_initialize_enclave(enclave));
+    initialized = true;
 
     /* Setup logging configuration */
     oe_log_enclave_init(enclave);
 
+    /* Start the workers for switchless OCALLs and ECALLs */
+    if (settings.num_host_workers || settings.num_enclave_workers)
+        OE_CHECK(
+            oe_start_switchless_manager(
+                enclave,
+                settings.num_host_workers,
+                settings.num_enclave_workers));
+
     *enclave_out = enclave;
     result = OE_OK;
 
@@ -831,7 +1104,36 @@ done:
 
     if (result != OE_OK && enclave)
     {
+        /* Run the destructor of an enclave whose constructors have run */
+        if (initialized)
+        {
+            oe_stop_async_pool(enclave);
+            oe_stop_enclave_threads(enclave);
+            oe_stop_switchless_enclave_workers(enclave);
+            oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL);
+        }
+
+        oe_stop_switchless_manager(enclave);
+        oe_stop_call_stats(enclave);
+
+        /* The exception handler must not find the enclave once it is freed */
+        if (pushed)
+        {
+#if defined(__linux__)
+            oe_notify_gdb_enclave_termination(
+                enclave, enclave->path, (uint32_t)strlen(enclave->path));
+#endif /* defined(__linux__) */
+
+            oe_remove_enclave_instance(enclave);
+            oe_sgx_delete_enclave(enclave);
+            free(enclave->path);
+        }
+
+        _free_scratch_regions(enclave);
+        oe_free_host_heap_regions(enclave);
         oe_free_enclave_ecalls(enclave);
+        oe_free_host_func_cache(enclave);
+        _free_thread_bindings(enclave);
         free(enclave);
     }
 
@@ -848,9 +1150,25 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
     if (!enclave || enclave->magic != ENCLAVE_MAGIC)
         OE_RAISE(OE_INVALID_PARAMETER);
 
+    /* Complete the pending asynchronous calls */
+    oe_stop_async_pool(enclave);
+
+    /* Wait for the threads started by the enclave */
+    oe_stop_enclave_threads(enclave);
+
+    /* The enclave workers run inside the enclave, so stop them first */
+    oe_stop_switchless_enclave_workers(enclave);
+
     /* Call the enclave destructor */
     OE_CHECK(oe_ecall(enclave, OE_ECALL_DESTRUCTOR, 0, NULL));
 
+    /* The destructor may have made switchless OCALLs, so stop the host
+     * workers only after it returns */
+    oe_stop_switchless_manager(enclave);
+
+    /* No calls can be made from here on */
+    oe_stop_call_stats(enclave);
+
 #if defined(__linux__)
 
     /* Notify GDB that this enclave is terminated */
@@ -876,17 +1194,15 @@ oe_result_t oe_terminate_enclave(oe_enclave_t* enclave)
 
         /* Release the enclave->ecalls[] array */
         oe_free_enclave_ecalls(enclave);
+        oe_free_host_func_cache(enclave);
 
-#if defined(_WIN32)
-
-        /* Release Windows events created during enclave creation */
-        for (size_t i = 0; i < enclave->num_bindings; i++)
-        {
-            ThreadBinding* binding = &enclave->bindings[i];
-            CloseHandle(binding->event.handle);
-        }
+        /* Release the scratch regions and the untrusted heap (no enclave
+         * thread can run now) */
+        _free_scratch_regions(enclave);
+        oe_free_host_heap_regions(enclave);
 
-#endif
+        /* Release the thread bindings and their events */
+        _free_thread_bindings(enclave);
 
         /* Free the path name of the enclave image file */
         free(enclave->path);
@@ -4,31 +4,285 @@
 #include "enclave.h"
 #include <assert.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../strings.h"
+
+/*
+**==============================================================================
+**
+** oe_get_tcs_binding()
+**
+**     Get the binding of the given TCS. The TCS pages of the thread sections
+**     are thread_section_size bytes apart (see _oe_add_data_pages()), so the
+**     index of the binding is computed from the address. The bindings array
+**     does not change after the enclave is created, so no lock is needed.
+**
+**==============================================================================
+*/
+
+ThreadBinding* oe_get_tcs_binding(oe_enclave_t* enclave, uint64_t tcs)
+{
+    uint64_t offset;
+    uint64_t index;
+
+    if (!enclave || !enclave->num_bindings || !enclave->thread_section_size)
+        return NULL;
+
+    if (tcs < enclave->bindings[0].tcs)
+        return NULL;
+
+    offset = tcs - enclave->bindings[0].tcs;
+
+    if (offset % enclave->thread_section_size)
+        return NULL;
+
+    index = offset / enclave->thread_section_size;
+
+    if (index >= enclave->num_bindings)
+        return NULL;
+
+    assert(enclave->bindings[index].tcs == tcs);
+    return &enclave->bindings[index];
+}
 
 /* Get the event object from the enclave for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs)
 {
-    EnclaveEvent* event = NULL;
+    ThreadBinding* binding = oe_get_tcs_binding(enclave, tcs);
+
+    return binding ? &binding->event : NULL;
+}
+
+/*
+**==============================================================================
+**
+** ECALL name hash table
+**
+**     Maps the names in enclave->ecalls to their indices. The table size is
+**     a power of two of at least twice the number of ECALLs. Starting from
+**     that size, the table is doubled up to MAX_ECALL_TABLE_DOUBLINGS times
+**     looking for a size where no two names share a slot, in which case every
+**     lookup touches exactly one slot. Otherwise the smallest table is used
+**     with linear probing.
+**
+**==============================================================================
+*/
+
+#define MAX_ECALL_TABLE_DOUBLINGS 4
+
+/* FNV-1a */
+static uint64_t _hash_name(const char* name)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+/* Fill the table, returning false on a collision if perfect is true */
+static bool _fill_ecall_table(
+    const oe_enclave_t* enclave,
+    ECallTableEntry* table,
+    size_t size,
+    bool perfect)
+{
+    memset(table, 0, size * sizeof(ECallTableEntry));
+
+    for (uint64_t i = 0; i < enclave->num_ecalls; i++)
+    {
+        uint64_t hash = _hash_name(enclave->ecalls[i].name);
+        size_t slot = hash & (size - 1);
+
+        while (table[slot].index)
+        {
+            if (perfect)
+                return false;
+
+            slot = (slot + 1) & (size - 1);
+        }
+
+        table[slot].hash = hash;
+        table[slot].index = i + 1;
+    }
+
+    return true;
+}
+
+oe_result_t oe_build_ecall_table(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    ECallTableEntry* table = NULL;
+    size_t min_size = 1;
+    size_t size;
 
     if (!enclave)
-        return NULL;
+        OE_RAISE(OE_INVALID_PARAMETER);
 
-    oe_mutex_lock(&enclave->lock);
+    while (min_size < 2 * enclave->num_ecalls)
+        min_size <<= 1;
+
+    size = min_size << MAX_ECALL_TABLE_DOUBLINGS;
+
+    if (!(table = (ECallTableEntry*)malloc(size * sizeof(ECallTableEntry))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    /* Look for the smallest table without collisions */
+    for (size = min_size; size <= (min_size << MAX_ECALL_TABLE_DOUBLINGS);
+         size <<= 1)
+    {
+        if (_fill_ecall_table(enclave, table, size, true))
+            break;
+    }
+
+    /* Otherwise fall back to linear probing */
+    if (size > (min_size << MAX_ECALL_TABLE_DOUBLINGS))
     {
-        size_t i;
+        size = min_size;
+        _fill_ecall_table(enclave, table, size, false);
+    }
+
+    free(enclave->ecall_table);
+    enclave->ecall_table = table;
+    enclave->ecall_table_size = size;
+    table = NULL;
+
+    result = OE_OK;
+
+done:
+    free(table);
+    return result;
+}
+
+bool oe_find_ecall(oe_enclave_t* enclave, const char* name, uint64_t* index)
+{
+    uint64_t hash;
+    size_t size;
+    size_t slot;
+
+    if (!enclave || !name || !enclave->ecall_table)
+        return false;
+
+    hash = _hash_name(name);
+    size = enclave->ecall_table_size;
+    slot = hash & (size - 1);
 
-        for (i = 0; i < enclave->num_bindings; i++)
+    /* The table is never full, so an empty slot ends the probe sequence */
+    while (enclave->ecall_table[slot].index)
+    {
+        const ECallTableEntry* entry = &enclave->ecall_table[slot];
+        uint64_t i = entry->index - 1;
+
+        if (entry->hash == hash && strcmp(enclave->ecalls[i].name, name) == 0)
         {
-            ThreadBinding* binding = &enclave->bindings[i];
+            if (index)
+                *index = i;
 
-            if (binding->tcs == tcs)
-            {
-                event = &binding->event;
-                break;
-            }
+            return true;
         }
+
+        slot = (slot + 1) & (size - 1);
+    }
+
+    return false;
+}
+
+/*
+**==============================================================================
+**
+** Host function cache
+**
+**     Maps the names passed to oe_call_host() to the addresses found by the
+**     dynamic loader. Entries are inserted with linear probing under
+**     enclave->lock and published with a release barrier; lookups take no
+**     lock. Entries are never removed before the enclave is terminated. Once
+**     the cache is three quarters full, further functions are not cached.
+**
+**==============================================================================
+*/
+
+oe_host_func_t oe_get_cached_host_func(oe_enclave_t* enclave, const char* name)
+{
+    uint64_t hash = _hash_name(name);
+    size_t slot = hash & (OE_HOST_FUNC_CACHE_SIZE - 1);
+    HostFuncCacheEntry* entry;
+
+    while ((entry = enclave->host_func_cache[slot]))
+    {
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+        if (entry->hash == hash && strcmp(entry->name, name) == 0)
+            return entry->func;
+
+        slot = (slot + 1) & (OE_HOST_FUNC_CACHE_SIZE - 1);
+    }
+
+    return NULL;
+}
+
+void oe_cache_host_func(
+    oe_enclave_t* enclave,
+    const char* name,
+    oe_host_func_t func)
+{
+    uint64_t hash = _hash_name(name);
+    size_t slot = hash & (OE_HOST_FUNC_CACHE_SIZE - 1);
+    HostFuncCacheEntry* entry;
+
+    oe_mutex_lock(&enclave->lock);
+
+    if (enclave->host_func_cache_count >= OE_HOST_FUNC_CACHE_SIZE / 4 * 3)
+        goto done;
+
+    /* Another thread may have cached the function meanwhile */
+    while ((entry = enclave->host_func_cache[slot]))
+    {
+        if (entry->hash == hash && strcmp(entry->name, name) == 0)
+            goto done;
+
+        slot = (slot + 1) & (OE_HOST_FUNC_CACHE_SIZE - 1);
+    }
+
+    if (!(entry = (HostFuncCacheEntry*)malloc(sizeof(HostFuncCacheEntry))))
+        goto done;
+
+    if (!(entry->name = oe_strdup(name)))
+    {
+        free(entry);
+        goto done;
     }
+
+    entry->hash = hash;
+    entry->func = func;
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    enclave->host_func_cache[slot] = entry;
+    enclave->host_func_cache_count++;
+
+done:
     oe_mutex_unlock(&enclave->lock);
+}
+
+void oe_free_host_func_cache(oe_enclave_t* enclave)
+{
+    for (size_t i = 0; i < OE_HOST_FUNC_CACHE_SIZE; i++)
+    {
+        HostFuncCacheEntry* entry = enclave->host_func_cache[i];
+
+        if (entry)
+        {
+            free(entry->name);
+            free(entry);
+            enclave->host_func_cache[i] = NULL;
+        }
+    }
 
-    return event;
+    enclave->host_func_cache_count = 0;
 }
@@ -7,6 +7,7 @@
 #include <openenclave/bits/properties.h>
 #include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
+#include <openenclave/internal/calls.h>
 #include <openenclave/internal/load.h>
 #include <openenclave/internal/sgxcreate.h>
 #include <stdbool.h>
@@ -40,6 +41,27 @@ typedef struct _ecall_name_addr
     uint64_t vaddr;
 } ECallNameAddr;
 
+/* Slot of the ECALL name hash table (see oe_build_ecall_table()) */
+typedef struct _ecall_table_entry
+{
+    /* Hash of the ECALL name */
+    uint64_t hash;
+
+    /* Index of the ECALL plus one (zero for an empty slot) */
+    uint64_t index;
+} ECallTableEntry;
+
+/* Entry of the cache of host functions called by name (see oe_call_host()) */
+typedef struct _host_func_cache_entry
+{
+    uint64_t hash;
+    char* name;
+    oe_host_func_t func;
+} HostFuncCacheEntry;
+
+/* Number of slots of the host function cache (a power of two) */
+#define OE_HOST_FUNC_CACHE_SIZE 256
+
 /*
 **==============================================================================
 **
@@ -52,15 +74,24 @@ typedef struct _ecall_name_addr
 **
 **     An active binding is indicated by the following condition:
 **
-**         ThreadBinding.busy == true
+**         ThreadBinding.flags & _OE_THREAD_BUSY
+**
+**     A host thread claims a binding by atomically setting _OE_THREAD_BUSY.
+**     While the flag is set, the remaining fields are only modified by the
+**     owning thread, so no lock is needed.
 **
 **     Due to nesting, the same thread may bind to the same enclave thread
 **     context more than once. The ThreadBinding.count field indicates how
 **     many bindings are in effect.
 **
+**     Bindings are cache-line aligned so that threads bound to neighboring
+**     thread contexts do not share cache lines.
+**
 **==============================================================================
 */
 
+#define THREAD_BINDING_ALIGNMENT 64
+
 typedef struct _thread_binding
 {
     /* Address of the enclave's thread control structure */
@@ -69,8 +100,8 @@ typedef struct _thread_binding
     /* The thread this slot is assigned to */
     oe_thread thread;
 
-    /* Flags */
-    uint64_t flags;
+    /* Flags (_OE_THREAD_BUSY is set and cleared atomically) */
+    volatile uint64_t flags;
 
     /* The number of bindings in effect */
     uint64_t count;
@@ -81,9 +112,10 @@ typedef struct _thread_binding
     /* The host GS and FS values saved before making an ecall */
     void* host_gs;
     void* host_fs;
-} ThreadBinding;
+} OE_ALIGNED(THREAD_BINDING_ALIGNMENT) ThreadBinding;
 
 OE_STATIC_ASSERT(OE_OFFSETOF(ThreadBinding, tcs) == ThreadBinding_tcs);
+OE_STATIC_ASSERT(sizeof(ThreadBinding) == THREAD_BINDING_ALIGNMENT);
 
 /* Whether this binding is busy */
 #define _OE_THREAD_BUSY 0X1UL
@@ -115,9 +147,11 @@ struct _oe_enclave
     /* Size of enclave in bytes */
     uint64_t size;
 
-    /* Array of thread bindings */
-    ThreadBinding bindings[OE_SGX_MAX_TCS];
+    /* Array of thread bindings (one per TCS, allocated when the enclave is
+     * built) */
+    ThreadBinding* bindings;
     size_t num_bindings;
+    size_t bindings_capacity;
     oe_mutex lock;
 
     /* Hash of enclave (MRENCLAVE) */
@@ -136,6 +170,40 @@ struct _oe_enclave
 
     /* Simulation mode */
     bool simulate;
+
+    /* Host workers servicing switchless OCALLs (may be null) */
+    struct _oe_switchless_manager* switchless_manager;
+
+    /* Untrusted scratch regions for OCALL marshaling (one per binding) */
+    oe_scratch_region_t* scratch_regions;
+
+    /* Regions of the untrusted heap (see OE_ENCLAVE_SETTING_HOST_HEAP) */
+    void** host_heap_regions;
+    size_t num_host_heap_regions;
+    size_t host_heap_regions_capacity;
+    size_t host_heap_region_size;
+
+    /* Distance between the TCS pages of consecutive bindings (the guard
+     * pages, stack and control pages of one thread) */
+    uint64_t thread_section_size;
+
+    /* Hash table of the ECALL names (size is a power of two) */
+    ECallTableEntry* ecall_table;
+    size_t ecall_table_size;
+
+    /* Cache of host functions called by name. Entries are only added (under
+     * the lock) and are read without locking */
+    HostFuncCacheEntry* volatile host_func_cache[OE_HOST_FUNC_CACHE_SIZE];
+    size_t host_func_cache_count;
+
+    /* Call statistics (null unless OE_ENCLAVE_SETTING_CALL_STATS is given) */
+    struct _oe_call_stats_manager* call_stats;
+
+    /* Threads performing asynchronous ECALLs (started by the first one) */
+    struct _oe_async_pool* volatile async_pool;
+
+    /* Threads started by the enclave (created by the first one) */
+    struct _oe_enclave_threads* volatile enclave_threads;
 };
 
 // Static asserts for consistency with
@@ -146,18 +214,41 @@ OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, magic) == 0);
 // Python plugin only needs the field number which is 2
 OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, addr) == 2 * sizeof(void*));
 
-// The fields up to binding correspond to 'ENCLAVE_HEADER'
-OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, bindings) == 0x28);
+// The fields up to num_bindings correspond to 'ENCLAVE_HEADER'. The plugin
+// walks num_bindings entries of the bindings array.
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, bindings) == 5 * sizeof(void*));
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, num_bindings) == 6 * sizeof(void*));
 
-OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0x798);
+OE_STATIC_ASSERT(OE_OFFSETOF(oe_enclave_t, debug) == 0xa8);
 OE_STATIC_ASSERT(
     OE_OFFSETOF(oe_enclave_t, debug) + 1 ==
     OE_OFFSETOF(oe_enclave_t, simulate));
 #endif
 
+/* Get the binding for the given TCS (without locking) */
+ThreadBinding* oe_get_tcs_binding(oe_enclave_t* enclave, uint64_t tcs);
+
 /* Get the event for the given TCS */
 EnclaveEvent* GetEnclaveEvent(oe_enclave_t* enclave, uint64_t tcs);
 
+/* Build the hash table of the ECALL names from enclave->ecalls */
+oe_result_t oe_build_ecall_table(oe_enclave_t* enclave);
+
+/* Find the index of the ECALL with the given name */
+bool oe_find_ecall(oe_enclave_t* enclave, const char* name, uint64_t* index);
+
+/* Find a host function in the cache (returns null if not cached) */
+oe_host_func_t oe_get_cached_host_func(oe_enclave_t* enclave, const char* name);
+
+/* Add a host function to the cache (ignored if the cache is full) */
+void oe_cache_host_func(
+    oe_enclave_t* enclave,
+    const char* name,
+    oe_host_func_t func);
+
+/* Free the entries of the host function cache */
+void oe_free_host_func_cache(oe_enclave_t* enclave);
+
 /* Free enclave ecall allocation */
 void oe_free_enclave_ecalls(oe_enclave_t* enclave);
 
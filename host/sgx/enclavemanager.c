@@ -4,24 +4,120 @@
 #include "enclave.h"
 #include <assert.h>
 #include <openenclave/host.h>
-#include <openenclave/internal/queue.h>
+#include <openenclave/internal/atomic.h>
 #include <openenclave/internal/trace.h>
+#include <openenclave/internal/utils.h>
 
-static OE_LIST_HEAD(EnclaveListHead, _enclave_entry) oe_enclave_list_head;
-static oe_mutex oe_enclave_list_lock = OE_H_MUTEX_INITIALIZER;
+/*
+**==============================================================================
+**
+** Enclave index
+**
+**     The index is an array of the address ranges of all enclaves, sorted
+**     by base address. It is never modified in place: writers (serialized
+**     by oe_enclave_list_lock) build a new copy and publish it with a single
+**     pointer store. Readers, such as the exception handler, load the
+**     pointer and binary search the array without taking any lock.
+**
+**     Readers announce themselves in the counter selected by the parity of
+**     _generation. After publishing a new array, a writer advances the
+**     generation and waits only until the counter of the previous one drops
+**     to zero, so readers that arrive later (and can only load the new
+**     array) never delay it. This is similar to an RCU grace period.
+**
+**==============================================================================
+*/
 
-typedef struct _enclave_entry
+typedef struct _enclave_range
 {
-    OE_LIST_ENTRY(_enclave_entry) next_entry;
+    uint64_t base;
+    uint64_t end;
     oe_enclave_t* enclave;
-} EnclaveEntry;
+} EnclaveRange;
+
+typedef struct _enclave_index
+{
+    size_t count;
+    EnclaveRange* ranges;
+} EnclaveIndex;
+
+typedef struct _reader_count
+{
+    volatile uint64_t count;
+} OE_ALIGNED(64) ReaderCount;
+
+static EnclaveIndex* volatile _enclave_index;
+static volatile uint64_t _generation;
+static ReaderCount _readers[2];
+static oe_mutex oe_enclave_list_lock = OE_H_MUTEX_INITIALIZER;
+
+/* Allocate an index with room for count ranges */
+static EnclaveIndex* _new_index(size_t count)
+{
+    EnclaveIndex* index;
+
+    if (!(index = (EnclaveIndex*)calloc(
+              1, sizeof(EnclaveIndex) + count * sizeof(EnclaveRange))))
+    {
+        return NULL;
+    }
+
+    index->count = count;
+    index->ranges = (EnclaveRange*)(index + 1);
+    return index;
+}
+
+/* Publish a new index and free the old one. Called with the lock held */
+static void _publish_index(EnclaveIndex* index)
+{
+    EnclaveIndex* old = _enclave_index;
+    uint64_t generation = _generation;
+    volatile uint64_t* count = &_readers[generation & 1].count;
+
+    /* Both swaps are full barriers: readers that see the new generation are
+     * guaranteed to load the new index */
+    oe_atomic_compare_and_swap(
+        (volatile uint64_t*)&_enclave_index, (uint64_t)old, (uint64_t)index);
+    oe_atomic_compare_and_swap(&_generation, generation, generation + 1);
+
+    /* Wait for readers of the previous generation, which may have loaded the
+     * old index */
+    while (old && *count)
+        oe_cpu_relax();
+
+    free(old);
+}
+
+/* Enter a read-side section and return the counter to pass to _end_read() */
+static volatile uint64_t* _begin_read(void)
+{
+    for (;;)
+    {
+        uint64_t generation = _generation;
+        volatile uint64_t* count = &_readers[generation & 1].count;
+
+        oe_atomic_increment(count);
+
+        /* Retry if a writer advanced the generation in between, as it may
+         * already have stopped waiting for this counter */
+        if (_generation == generation)
+            return count;
+
+        oe_atomic_decrement(count);
+    }
+}
+
+static void _end_read(volatile uint64_t* count)
+{
+    oe_atomic_decrement(count);
+}
 
 /*
 **==============================================================================
 **
 ** oe_push_enclave_instance()
 **
-**     Push the enclave to the head of the global enclave list.
+**     Add the enclave to the global enclave index.
 **     Return 0 if success.
 **
 **==============================================================================
@@ -31,7 +127,11 @@ uint32_t oe_push_enclave_instance(oe_enclave_t* enclave)
 {
     uint32_t ret = 1;
     bool locked = false;
-    EnclaveEntry* new_entry = NULL;
+    EnclaveIndex* old;
+    EnclaveIndex* index = NULL;
+    size_t count;
+    size_t i;
+    size_t j;
 
     // Take the lock.
     if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
@@ -41,31 +141,42 @@ uint32_t oe_push_enclave_instance(oe_enclave_t* enclave)
 
     locked = true;
 
-    // Return error if the enclave is already in global list.
+    old = _enclave_index;
+    count = old ? old->count : 0;
+
+    // Return error if the enclave is already in the index.
+    for (i = 0; i < count; i++)
     {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        if (old->ranges[i].enclave == enclave)
         {
-            if (tmp->enclave == enclave)
-            {
-                OE_TRACE_ERROR("The enclave is already in global list\n");
-                goto cleanup;
-            }
+            OE_TRACE_ERROR("The enclave is already in global list\n");
+            goto cleanup;
         }
     }
 
-    // Allocate new entry.
-    new_entry = (EnclaveEntry*)calloc(1, sizeof(EnclaveEntry));
-    if (new_entry == NULL)
+    // Allocate the new index.
+    if (!(index = _new_index(count + 1)))
     {
-        OE_TRACE_ERROR("calloc for EnclaveEntry failed\n");
+        OE_TRACE_ERROR("calloc for EnclaveIndex failed\n");
         goto cleanup;
     }
 
-    new_entry->enclave = enclave;
+    // Copy the ranges, inserting the new one in order of base address.
+    for (i = 0, j = 0; i < count + 1; i++)
+    {
+        if (j == i && (i == count || old->ranges[i].base > enclave->addr))
+        {
+            index->ranges[i].base = enclave->addr;
+            index->ranges[i].end = enclave->addr + enclave->size;
+            index->ranges[i].enclave = enclave;
+        }
+        else
+        {
+            index->ranges[i] = old->ranges[j++];
+        }
+    }
 
-    // Insert to the beginning of the list.
-    OE_LIST_INSERT_HEAD(&oe_enclave_list_head, new_entry, next_entry);
+    _publish_index(index);
 
     // Return success.
     ret = 0;
@@ -90,7 +201,7 @@ cleanup:
 **
 ** oe_remove_enclave_instance()
 **
-**     Remove the enclave from the global enclave list.
+**     Remove the enclave from the global enclave index.
 **     Return 0 if success.
 **
 **==============================================================================
@@ -100,6 +211,11 @@ uint32_t oe_remove_enclave_instance(oe_enclave_t* enclave)
 {
     uint32_t ret = 1;
     bool locked = false;
+    EnclaveIndex* old;
+    EnclaveIndex* index = NULL;
+    size_t i;
+    size_t j;
+    size_t k;
 
     // Take the lock.
     if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
@@ -110,21 +226,38 @@ uint32_t oe_remove_enclave_instance(oe_enclave_t* enclave)
 
     locked = true;
 
-    // Enumerate the enclave list, remove the target entry if find it.
+    // Find the target entry.
+    if (!(old = _enclave_index))
+        goto cleanup;
+
+    for (k = 0; k < old->count; k++)
+    {
+        if (old->ranges[k].enclave == enclave)
+            break;
+    }
+
+    if (k == old->count)
+        goto cleanup;
+
+    // Copy all other ranges (an empty index is represented by NULL).
+    if (old->count > 1)
     {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        if (!(index = _new_index(old->count - 1)))
         {
-            if (tmp->enclave == enclave)
-            {
-                OE_LIST_REMOVE(tmp, next_entry);
-                free(tmp);
-                ret = 0;
-                break;
-            }
+            OE_TRACE_ERROR("calloc for EnclaveIndex failed\n");
+            goto cleanup;
+        }
+
+        for (i = 0, j = 0; i < old->count; i++)
+        {
+            if (i != k)
+                index->ranges[j++] = old->ranges[i];
         }
     }
 
+    _publish_index(index);
+    ret = 0;
+
 cleanup:
     if (locked)
     {
@@ -150,50 +283,51 @@ cleanup:
 **     Query the owner enclave for the given TCS.
 **     Return the owner enclave if success, otherwise return NULL.
 **
+**     This function is called by the exception handler, so it takes no
+**     locks: it binary searches the enclave index by address and then
+**     checks that the address is a TCS of the enclave found.
+**
 **==============================================================================
 */
 
 oe_enclave_t* oe_query_enclave_instance(void* tcs)
 {
     oe_enclave_t* ret = NULL;
-    bool locked = false;
+    const EnclaveIndex* index;
+    uint64_t addr = (uint64_t)tcs;
+    volatile uint64_t* count = _begin_read();
 
-    // Take the lock.
-    if (oe_mutex_lock(&oe_enclave_list_lock) != 0)
+    if ((index = _enclave_index))
     {
-        OE_TRACE_ERROR("oe_mutex_lock failed\n");
-        goto cleanup;
-    }
+        size_t lo = 0;
+        size_t hi;
 
-    locked = true;
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+        hi = index->count;
 
-    // Enumerate the enclave list, find which enclave owns the TCS.
-    {
-        EnclaveEntry* tmp;
-        OE_LIST_FOREACH(tmp, &oe_enclave_list_head, next_entry)
+        while (lo < hi)
         {
-            oe_enclave_t* enclave = tmp->enclave;
-            for (uint32_t i = 0; i < OE_COUNTOF(enclave->bindings); i++)
+            size_t mid = lo + (hi - lo) / 2;
+            const EnclaveRange* range = &index->ranges[mid];
+
+            if (addr < range->base)
+            {
+                hi = mid;
+            }
+            else if (addr >= range->end)
             {
-                if (enclave->bindings[i].tcs == (uint64_t)tcs)
-                {
-                    ret = enclave;
-                    goto cleanup;
-                }
+                lo = mid + 1;
+            }
+            else
+            {
+                if (oe_get_tcs_binding(range->enclave, addr))
+                    ret = range->enclave;
+                break;
             }
         }
     }
 
-cleanup:
-    if (locked)
-    {
-        // Release the lock if it is taken.
-        if (oe_mutex_unlock(&oe_enclave_list_lock) != 0)
-        {
-            OE_TRACE_ERROR("oe_mutex_unlock failed\n");
-            abort();
-        }
-    }
+    _end_read(count);
 
     if (!ret)
         OE_TRACE_ERROR("tcs=0x%x\n", tcs);
@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "enclavethreads.h"
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/utils.h>
+#include <stdlib.h>
+#include "../ocalls.h"
+
+/* Milliseconds a thread sleeps before it retries to obtain a TCS */
+#define RETRY_SLEEP_MS 1
+
+/*
+**==============================================================================
+**
+** _thread()
+**
+**     Thread function of a thread started by the enclave. Enters the enclave
+**     once; while all TCSs are busy, the ECALL is retried until one of them
+**     is released or the enclave is being terminated.
+**
+**     If the thread gives up or the ECALL fails, the enclave still holds the
+**     start request. The threads are stopped before the enclave destructor
+**     runs, and the destructor cancels the requests left over, which
+**     finishes the enclave threads waiting for them.
+**
+**==============================================================================
+*/
+
+static void _thread(void* arg)
+{
+    oe_enclave_thread_t* thread = (oe_enclave_thread_t*)arg;
+    oe_enclave_threads_t* threads = thread->threads;
+    uint64_t arg_out = 0;
+    oe_result_t result;
+
+    while ((result = oe_ecall(
+                threads->enclave,
+                OE_ECALL_THREAD_START,
+                thread->id,
+                &arg_out)) == OE_OUT_OF_THREADS &&
+           !threads->stopping)
+    {
+        oe_handle_sleep(RETRY_SLEEP_MS);
+    }
+
+    if (result != OE_OK)
+        OE_TRACE_ERROR(
+            "enclave thread %llu not started: %s\n",
+            (unsigned long long)thread->id,
+            oe_result_str(result));
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    thread->done = 1;
+}
+
+/* Join the threads that returned. Called with threads->lock held */
+static void _reap_threads(oe_enclave_threads_t* threads)
+{
+    oe_enclave_thread_t** p = &threads->head;
+
+    while (*p)
+    {
+        oe_enclave_thread_t* thread = *p;
+
+        if (thread->done)
+        {
+            *p = thread->next;
+            oe_thread_join(thread->handle);
+            free(thread);
+        }
+        else
+        {
+            p = &thread->next;
+        }
+    }
+}
+
+static oe_result_t _get_threads(
+    oe_enclave_t* enclave,
+    oe_enclave_threads_t** out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_enclave_threads_t* threads;
+
+    if ((threads = enclave->enclave_threads))
+    {
+        OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+        *out = threads;
+        return OE_OK;
+    }
+
+    oe_mutex_lock(&enclave->lock);
+    {
+        if (!(threads = enclave->enclave_threads))
+        {
+            threads = (oe_enclave_threads_t*)calloc(
+                1, sizeof(oe_enclave_threads_t));
+
+            if (!threads)
+            {
+                oe_mutex_unlock(&enclave->lock);
+                OE_RAISE(OE_OUT_OF_MEMORY);
+            }
+
+            if (oe_mutex_init(&threads->lock) != 0)
+            {
+                free(threads);
+                oe_mutex_unlock(&enclave->lock);
+                OE_RAISE(OE_FAILURE);
+            }
+
+            threads->enclave = enclave;
+
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            enclave->enclave_threads = threads;
+        }
+    }
+    oe_mutex_unlock(&enclave->lock);
+
+    *out = threads;
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_thread_create()
+**
+**==============================================================================
+*/
+
+void oe_handle_thread_create(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_enclave_threads_t* threads = NULL;
+    oe_enclave_thread_t* thread = NULL;
+
+    OE_CHECK(_get_threads(enclave, &threads));
+
+    oe_mutex_lock(&threads->lock);
+    {
+        _reap_threads(threads);
+
+        if (threads->stopping)
+        {
+            oe_mutex_unlock(&threads->lock);
+            OE_RAISE(OE_FAILURE);
+        }
+
+        thread = (oe_enclave_thread_t*)calloc(1, sizeof(oe_enclave_thread_t));
+
+        if (!thread)
+        {
+            oe_mutex_unlock(&threads->lock);
+            OE_RAISE(OE_OUT_OF_MEMORY);
+        }
+
+        thread->threads = threads;
+        thread->id = arg_in;
+
+        if (oe_thread_create(&thread->handle, _thread, thread) != 0)
+        {
+            oe_mutex_unlock(&threads->lock);
+            OE_RAISE(OE_FAILURE);
+        }
+
+        thread->next = threads->head;
+        threads->head = thread;
+        thread = NULL;
+    }
+    oe_mutex_unlock(&threads->lock);
+
+    result = OE_OK;
+
+done:
+
+    free(thread);
+
+    if (arg_out)
+        *arg_out = (uint64_t)result;
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_enclave_threads()
+**
+**==============================================================================
+*/
+
+void oe_stop_enclave_threads(oe_enclave_t* enclave)
+{
+    oe_enclave_threads_t* threads = enclave->enclave_threads;
+    oe_enclave_thread_t* head;
+
+    if (!threads)
+        return;
+
+    /* No more threads are started; waiting ones give up on their TCS */
+    oe_mutex_lock(&threads->lock);
+    {
+        threads->stopping = true;
+        head = threads->head;
+        threads->head = NULL;
+    }
+    oe_mutex_unlock(&threads->lock);
+
+    while (head)
+    {
+        oe_enclave_thread_t* thread = head;
+
+        head = thread->next;
+        oe_thread_join(thread->handle);
+        free(thread);
+    }
+
+    oe_mutex_destroy(&threads->lock);
+    free(threads);
+    enclave->enclave_threads = NULL;
+}
@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_ENCLAVETHREADS_H
+#define _OE_HOST_SGX_ENCLAVETHREADS_H
+
+#include "../hostthread.h"
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** oe_enclave_threads_t
+**
+**     Host threads started on behalf of an enclave with OE_OCALL_THREAD_CREATE.
+**     Each one performs a single OE_ECALL_THREAD_START. Threads that returned
+**     are joined when the next one is started or when the enclave is
+**     terminated.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_enclave_thread
+{
+    struct _oe_enclave_thread* next;
+    struct _oe_enclave_threads* threads;
+
+    /* The start identifier passed to OE_ECALL_THREAD_START */
+    uint64_t id;
+
+    oe_thread_handle handle;
+
+    /* Set once the thread is about to exit */
+    volatile uint64_t done;
+} oe_enclave_thread_t;
+
+typedef struct _oe_enclave_threads
+{
+    oe_enclave_t* enclave;
+
+    /* List of started threads (protected by lock) */
+    oe_mutex lock;
+    oe_enclave_thread_t* head;
+    volatile bool stopping;
+} oe_enclave_threads_t;
+
+/* Handle OE_OCALL_THREAD_CREATE from the enclave */
+void oe_handle_thread_create(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out);
+
+/* Wait for the threads started by the enclave to exit and release them */
+void oe_stop_enclave_threads(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SGX_ENCLAVETHREADS_H */
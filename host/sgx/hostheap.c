@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "hostheap.h"
+#include <openenclave/internal/calls.h>
+#include <stdlib.h>
+#include "../memalign.h"
+
+/*
+**==============================================================================
+**
+** oe_add_host_heap_region()
+**
+**==============================================================================
+*/
+
+void* oe_add_host_heap_region(oe_enclave_t* enclave)
+{
+    void* region = NULL;
+
+    if (!enclave->host_heap_region_size)
+        return NULL;
+
+    oe_mutex_lock(&enclave->lock);
+    {
+        size_t n = enclave->num_host_heap_regions;
+        void** regions;
+
+        /* Grow the array of regions (by doubling) if it is full */
+        if (n == enclave->host_heap_regions_capacity)
+        {
+            size_t capacity = n ? n * 2 : 4;
+
+            if (!(regions = (void**)realloc(
+                      enclave->host_heap_regions, capacity * sizeof(void*))))
+                goto done;
+
+            enclave->host_heap_regions = regions;
+            enclave->host_heap_regions_capacity = capacity;
+        }
+
+        if (!(region = oe_memalign(
+                  OE_HOST_HEAP_SPAN_SIZE, enclave->host_heap_region_size)))
+            goto done;
+
+        enclave->host_heap_regions[n] = region;
+        enclave->num_host_heap_regions++;
+    }
+done:
+    oe_mutex_unlock(&enclave->lock);
+
+    return region;
+}
+
+/*
+**==============================================================================
+**
+** oe_free_host_heap_regions()
+**
+**==============================================================================
+*/
+
+void oe_free_host_heap_regions(oe_enclave_t* enclave)
+{
+    for (size_t i = 0; i < enclave->num_host_heap_regions; i++)
+        oe_memalign_free(enclave->host_heap_regions[i]);
+
+    free(enclave->host_heap_regions);
+    enclave->host_heap_regions = NULL;
+    enclave->num_host_heap_regions = 0;
+    enclave->host_heap_regions_capacity = 0;
+}
+
+/*
+**==============================================================================
+**
+** oe_handle_grow_host_heap()
+**
+**     The enclave asks for another region once its reserved memory is
+**     exhausted. Regions always have the size configured at creation.
+**
+**==============================================================================
+*/
+
+void oe_handle_grow_host_heap(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out)
+{
+    void* region = NULL;
+
+    if (arg_in == enclave->host_heap_region_size)
+        region = oe_add_host_heap_region(enclave);
+
+    if (arg_out)
+        *arg_out = (uint64_t)region;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_HOSTHEAP_H
+#define _OE_HOST_SGX_HOSTHEAP_H
+
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** Regions of host memory sub-allocated by the enclave (untrusted heap). The
+** host only reserves and finally releases them; the enclave owns their
+** contents while it runs.
+**
+**==============================================================================
+*/
+
+/* Reserve another region of enclave->host_heap_region_size bytes */
+void* oe_add_host_heap_region(oe_enclave_t* enclave);
+
+/* Release all regions (once no enclave thread can use them) */
+void oe_free_host_heap_regions(oe_enclave_t* enclave);
+
+/* Handle OE_OCALL_GROW_HOST_HEAP */
+void oe_handle_grow_host_heap(
+    oe_enclave_t* enclave,
+    uint64_t arg_in,
+    uint64_t* arg_out);
+
+#endif /* _OE_HOST_SGX_HOSTHEAP_H */
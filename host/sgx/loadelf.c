@@ -709,7 +709,10 @@ static oe_result_t _patch(
     if (aligned_size > OE_THREAD_LOCAL_SPACE)
     {
         OE_TRACE_ERROR(
-            "Thread-local variables exceed available thread-local space.\n");
+            "Thread-local variables (%zu bytes) exceed available "
+            "thread-local space (%d bytes).\n",
+            (size_t)aligned_size,
+            OE_THREAD_LOCAL_SPACE);
         OE_RAISE(OE_FAILURE);
     }
 
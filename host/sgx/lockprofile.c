@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/lockprofile.h>
+#include <openenclave/internal/raise.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "enclave.h"
+#include "ocalls.h"
+
+/*
+**==============================================================================
+**
+** oe_get_lock_profile()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_get_lock_profile(
+    oe_enclave_t* enclave,
+    oe_lock_profile_entry_t* entries,
+    size_t* num_entries)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_get_lock_profile_args_t args;
+
+    if (!enclave || !num_entries)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    memset(&args, 0, sizeof(args));
+    args.result = OE_UNEXPECTED;
+    args.entries = entries;
+    args.num_entries = entries ? *num_entries : 0;
+
+    OE_CHECK(
+        oe_ecall(enclave, OE_ECALL_GET_LOCK_PROFILE, (uint64_t)&args, NULL));
+
+    if (args.result == OE_OK || args.result == OE_BUFFER_TOO_SMALL)
+        *num_entries = (size_t)args.num_entries;
+
+    result = args.result;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_print_lock_profile()
+**
+**==============================================================================
+*/
+
+static const char* _type_name(uint32_t type)
+{
+    switch (type)
+    {
+        case OE_LOCK_TYPE_MUTEX:
+            return "mutex";
+        case OE_LOCK_TYPE_COND:
+            return "cond";
+        case OE_LOCK_TYPE_RWLOCK_READ:
+            return "rwlock-rd";
+        case OE_LOCK_TYPE_RWLOCK_WRITE:
+            return "rwlock-wr";
+        case OE_LOCK_TYPE_SPINLOCK:
+            return "spinlock";
+        default:
+            return "unknown";
+    }
+}
+
+/* Order entries by decreasing wait time */
+static int _compare_entries(const void* a, const void* b)
+{
+    const oe_lock_profile_entry_t* x = (const oe_lock_profile_entry_t*)a;
+    const oe_lock_profile_entry_t* y = (const oe_lock_profile_entry_t*)b;
+
+    if (x->wait_cycles != y->wait_cycles)
+        return x->wait_cycles < y->wait_cycles ? 1 : -1;
+
+    if (x->acquisitions != y->acquisitions)
+        return x->acquisitions < y->acquisitions ? 1 : -1;
+
+    return 0;
+}
+
+static void _print_entry(
+    oe_enclave_t* enclave,
+    const oe_lock_profile_entry_t* entry)
+{
+    void* frames[OE_LOCK_PROFILE_FRAMES];
+    int num_frames = (int)entry->num_frames;
+    char** symbols = NULL;
+
+    fprintf(
+        stderr,
+        "%-9s 0x%016llx acquired=%llu contended=%llu spins=%llu parks=%llu "
+        "wait=%llu cycles\n",
+        _type_name(entry->type),
+        (unsigned long long)entry->lock,
+        (unsigned long long)entry->acquisitions,
+        (unsigned long long)entry->contended,
+        (unsigned long long)entry->spins,
+        (unsigned long long)entry->parks,
+        (unsigned long long)entry->wait_cycles);
+
+    if (num_frames > OE_LOCK_PROFILE_FRAMES)
+        num_frames = OE_LOCK_PROFILE_FRAMES;
+
+    for (int i = 0; i < num_frames; i++)
+        frames[i] = (void*)entry->frames[i];
+
+    if (num_frames)
+        symbols = oe_get_backtrace_symbols(enclave, frames, num_frames);
+
+    for (int i = 0; i < num_frames; i++)
+    {
+        fprintf(
+            stderr,
+            "    0x%016llx %s\n",
+            (unsigned long long)entry->frames[i],
+            symbols ? symbols[i] : "");
+    }
+
+    free(symbols);
+}
+
+oe_result_t oe_print_lock_profile(oe_enclave_t* enclave)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_lock_profile_entry_t* entries = NULL;
+    size_t num_entries = 0;
+
+    /* Entries may be added between the calls, so retry with the new size */
+    for (;;)
+    {
+        result = oe_get_lock_profile(enclave, entries, &num_entries);
+
+        if (result == OE_OK)
+            break;
+
+        if (result != OE_BUFFER_TOO_SMALL)
+            OE_RAISE(result);
+
+        free(entries);
+
+        if (!(entries = (oe_lock_profile_entry_t*)calloc(
+                  num_entries, sizeof(oe_lock_profile_entry_t))))
+            OE_RAISE(OE_OUT_OF_MEMORY);
+    }
+
+    if (num_entries)
+        qsort(entries, num_entries, sizeof(*entries), _compare_entries);
+
+    fprintf(stderr, "=== lock profile of %s\n", enclave->path);
+
+    for (size_t i = 0; i < num_entries; i++)
+        _print_entry(enclave, &entries[i]);
+
+    result = OE_OK;
+
+done:
+    free(entries);
+    return result;
+}
@@ -5,6 +5,7 @@
 #include <stdio.h>
 
 #if defined(__linux__)
+#include <errno.h>
 #include <linux/futex.h>
 #include <stdlib.h>
 #include <sys/syscall.h>
@@ -52,26 +53,51 @@ void HandleFree(uint64_t arg)
     free((void*)arg);
 }
 
-void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
+/* Wait for the event until the deadline (if any). Return false on timeout */
+static bool _wait_event(EnclaveEvent* event, const uint64_t* deadline)
 {
-    const uint64_t tcs = arg_in;
-    EnclaveEvent* event = GetEnclaveEvent(enclave, tcs);
-    assert(event);
-
 #if defined(__linux__)
 
+    struct timespec ts;
+
+    if (deadline)
+    {
+        ts.tv_sec = (time_t)(*deadline / 1000000000);
+        ts.tv_nsec = (long)(*deadline % 1000000000);
+    }
+
     if (__sync_fetch_and_add(&event->value, (uint32_t)-1) == 0)
     {
         do
         {
-            syscall(
-                __NR_futex,
-                &event->value,
-                FUTEX_WAIT_PRIVATE,
-                -1,
-                NULL,
-                NULL,
-                0);
+            if (!deadline)
+            {
+                syscall(
+                    __NR_futex,
+                    &event->value,
+                    FUTEX_WAIT_PRIVATE,
+                    -1,
+                    NULL,
+                    NULL,
+                    0);
+            }
+            else if (
+                syscall(
+                    __NR_futex,
+                    &event->value,
+                    FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME,
+                    -1,
+                    &ts,
+                    NULL,
+                    FUTEX_BITSET_MATCH_ANY) != 0 &&
+                errno == ETIMEDOUT)
+            {
+                // Take back the decrement, unless a wake raced with the
+                // timeout (in which case the wake is consumed).
+                if (__sync_bool_compare_and_swap(
+                        &event->value, (uint32_t)-1, 0))
+                    return false;
+            }
             // If event->value is still -1, then this is a spurious-wake.
             // Spurious-wakes are ignored by going back to FUTEX_WAIT.
             // Since FUTEX_WAIT uses atomic instructions to load event->value,
@@ -79,13 +105,65 @@ void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
         } while (event->value == (uint32_t)-1);
     }
 
+    return true;
+
 #elif defined(_WIN32)
 
-    WaitForSingleObject(event->handle, INFINITE);
+    DWORD milliseconds = INFINITE;
+
+    if (deadline)
+    {
+        FILETIME ft;
+        ULARGE_INTEGER now;
+
+        // Convert the deadline to ticks of 100ns since 1601-01-01 (see
+        // POSIX_TO_WINDOWS_EPOCH_TICKS in host/windows/time.c).
+        const uint64_t ticks = *deadline / 100 + 0x19DB1DED53E8000;
+
+        GetSystemTimeAsFileTime(&ft);
+        now.u.LowPart = ft.dwLowDateTime;
+        now.u.HighPart = ft.dwHighDateTime;
+
+        milliseconds = 0;
+
+        if (ticks > now.QuadPart)
+        {
+            const uint64_t ms = (ticks - now.QuadPart + 9999) / 10000;
+            milliseconds = ms < INFINITE ? (DWORD)ms : INFINITE - 1;
+        }
+    }
+
+    return WaitForSingleObject(event->handle, milliseconds) != WAIT_TIMEOUT;
 
 #endif
 }
 
+void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg_in)
+{
+    const uint64_t tcs = arg_in;
+    EnclaveEvent* event = GetEnclaveEvent(enclave, tcs);
+    assert(event);
+
+    _wait_event(event, NULL);
+}
+
+void HandleThreadWaitTimeout(oe_enclave_t* enclave, uint64_t arg_in)
+{
+    oe_thread_wait_timeout_args_t* args =
+        (oe_thread_wait_timeout_args_t*)arg_in;
+    EnclaveEvent* event;
+    uint64_t deadline;
+
+    if (!args)
+        return;
+
+    event = GetEnclaveEvent(enclave, (uint64_t)args->tcs);
+    assert(event);
+
+    deadline = args->deadline;
+    args->result = _wait_event(event, &deadline) ? OE_OK : OE_TIMEDOUT;
+}
+
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg_in)
 {
     const uint64_t tcs = arg_in;
@@ -125,6 +203,18 @@ void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in)
 #endif
 }
 
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in)
+{
+    oe_thread_wake_multiple_args_t* args =
+        (oe_thread_wake_multiple_args_t*)arg_in;
+
+    if (!args)
+        return;
+
+    for (uint64_t i = 0, n = args->num_tcs; i < n; i++)
+        HandleThreadWake(enclave, (uint64_t)args->tcs[i]);
+}
+
 void HandleGetQuote(uint64_t arg_in)
 {
     oe_get_quote_args_t* args = (oe_get_quote_args_t*)arg_in;
@@ -168,7 +258,7 @@ void HandleGetQETargetInfo(uint64_t arg_in)
     args->result = sgx_get_qetarget_info(&args->target_info);
 }
 
-static char** _backtrace_symbols(
+char** oe_get_backtrace_symbols(
     oe_enclave_t* enclave,
     void* const* buffer,
     int size)
@@ -261,7 +351,8 @@ void oe_handle_backtrace_symbols(oe_enclave_t* enclave, uint64_t arg)
 
     if (args)
     {
-        args->ret = _backtrace_symbols(enclave, args->buffer, args->size);
+        args->ret =
+            oe_get_backtrace_symbols(enclave, args->buffer, args->size);
     }
 }
 
@@ -6,19 +6,29 @@
 
 #include "enclave.h"
 
+oe_result_t oe_handle_call_host_function(uint64_t arg, oe_enclave_t* enclave);
+
 void HandleMalloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleRealloc(uint64_t arg_in, uint64_t* arg_out);
 void HandleFree(uint64_t arg);
 
 void HandleThreadWait(oe_enclave_t* enclave, uint64_t arg);
+void HandleThreadWaitTimeout(oe_enclave_t* enclave, uint64_t arg_in);
 void HandleThreadWake(oe_enclave_t* enclave, uint64_t arg);
 void HandleThreadWakeWait(oe_enclave_t* enclave, uint64_t arg_in);
+void HandleThreadWakeMultiple(oe_enclave_t* enclave, uint64_t arg_in);
 
 void HandleGetQuote(uint64_t arg_in);
 void HandleGetQETargetInfo(uint64_t arg_in);
 void HandleGetQuoteRevocationInfo(uint64_t arg_in);
 void HandleGetQuoteEnclaveIdentityInfo(uint64_t arg_in);
 
+/* Map enclave return addresses to function names (see backtrace_symbols) */
+char** oe_get_backtrace_symbols(
+    oe_enclave_t* enclave,
+    void* const* buffer,
+    int size);
+
 void oe_handle_backtrace_symbols(oe_enclave_t* enclave, uint64_t arg);
 void oe_handle_log(oe_enclave_t* enclave, uint64_t arg);
 
@@ -0,0 +1,462 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "switchless.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+#include <openenclave/edger8r/host.h>
+#include <openenclave/host.h>
+#include <openenclave/internal/atomic.h>
+#include <openenclave/internal/calls.h>
+#include <openenclave/internal/raise.h>
+#include <openenclave/internal/types.h>
+#include <openenclave/internal/utils.h>
+#include <string.h>
+#include "../memalign.h"
+#include "callstats.h"
+#include "ocalls.h"
+
+static void _yield(void)
+{
+#if defined(__linux__)
+    sched_yield();
+#elif defined(_WIN32)
+    SwitchToThread();
+#endif
+}
+
+/*
+**==============================================================================
+**
+** _host_worker()
+**
+**     Thread function of a host worker. Polls the worker's slot for posted
+**     calls and dispatches them to the enclave's ocall table. A worker that
+**     stays idle for OE_SWITCHLESS_WORKER_SPIN_COUNT iterations yields its CPU
+**     between polls.
+**
+**==============================================================================
+*/
+
+static void _host_worker(void* arg)
+{
+    oe_host_worker_t* worker = (oe_host_worker_t*)arg;
+    oe_switchless_manager_t* manager = worker->manager;
+    oe_switchless_slot_t* slot = worker->slot;
+    uint64_t idle = 0;
+
+    while (!manager->stopping)
+    {
+        if (slot->state == OE_SWITCHLESS_SLOT_POSTED &&
+            oe_atomic_compare_and_swap(
+                &slot->state,
+                OE_SWITCHLESS_SLOT_POSTED,
+                OE_SWITCHLESS_SLOT_RUNNING))
+        {
+            slot->result = oe_handle_call_host_function(
+                (uint64_t)&slot->args, manager->enclave);
+
+            /* Publish the results before handing the slot back */
+            OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+            slot->state = OE_SWITCHLESS_SLOT_DONE;
+            idle = 0;
+        }
+        else if (++idle < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+        {
+            oe_cpu_relax();
+        }
+        else
+        {
+            _yield();
+        }
+    }
+}
+
+/*
+**==============================================================================
+**
+** _enclave_worker()
+**
+**     Thread function of an enclave worker. Enters the enclave once and
+**     services switchless ECALLs from inside it until its slot is stopped.
+**
+**==============================================================================
+*/
+
+static void _enclave_worker(void* arg)
+{
+    oe_enclave_worker_t* worker = (oe_enclave_worker_t*)arg;
+    uint64_t arg_out = 0;
+
+    /* A failure leaves the slot unserviced, so posted calls fall back */
+    oe_ecall(
+        worker->manager->enclave,
+        OE_ECALL_SWITCHLESS_WORKER,
+        (uint64_t)worker->slot,
+        &arg_out);
+}
+
+static void _stop_enclave_workers(oe_switchless_manager_t* manager)
+{
+    for (size_t i = 0; i < manager->num_enclave_workers; i++)
+    {
+        oe_switchless_ecall_slot_t* slot = &manager->enclave_slots[i];
+
+        /* Wait for any call in progress to be released */
+        while (slot->state != OE_SWITCHLESS_SLOT_STOP &&
+               !oe_atomic_compare_and_swap(
+                   &slot->state,
+                   OE_SWITCHLESS_SLOT_FREE,
+                   OE_SWITCHLESS_SLOT_STOP))
+        {
+            _yield();
+        }
+    }
+
+    for (size_t i = 0; i < manager->num_enclave_started; i++)
+        oe_thread_join(manager->enclave_workers[i].thread);
+
+    manager->num_enclave_started = 0;
+}
+
+static void _free_manager(oe_switchless_manager_t* manager)
+{
+    /* Enclave workers may still make switchless OCALLs, so stop them first */
+    if (manager->enclave_slots)
+        _stop_enclave_workers(manager);
+
+    manager->stopping = true;
+
+    for (size_t i = 0; i < manager->num_host_started; i++)
+        oe_thread_join(manager->host_workers[i].thread);
+
+    free(manager->enclave_workers);
+    oe_memalign_free(manager->enclave_slots);
+    free(manager->host_workers);
+    oe_memalign_free(manager->host_slots);
+    free(manager);
+}
+
+static oe_result_t _start_host_workers(
+    oe_switchless_manager_t* manager,
+    size_t num_host_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_init_switchless_args_t args;
+    size_t slots_size = num_host_workers * sizeof(oe_switchless_slot_t);
+
+    if (!(manager->host_slots = (oe_switchless_slot_t*)oe_memalign(
+              sizeof(oe_switchless_slot_t), slots_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(manager->host_slots, 0, slots_size);
+
+    if (!(manager->host_workers = (oe_host_worker_t*)calloc(
+              num_host_workers, sizeof(oe_host_worker_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    manager->num_host_workers = num_host_workers;
+
+    for (size_t i = 0; i < num_host_workers; i++)
+    {
+        oe_host_worker_t* worker = &manager->host_workers[i];
+
+        worker->manager = manager;
+        worker->slot = &manager->host_slots[i];
+
+        if (oe_thread_create(&worker->thread, _host_worker, worker) != 0)
+            OE_RAISE_MSG(OE_FAILURE, "failed to start switchless worker\n");
+
+        manager->num_host_started++;
+    }
+
+    /* Tell the enclave where to post switchless OCALLs */
+    args.slots = manager->host_slots;
+    args.num_slots = num_host_workers;
+
+    {
+        uint64_t arg_out = 0;
+
+        OE_CHECK(
+            oe_ecall(
+                manager->enclave,
+                OE_ECALL_INIT_SWITCHLESS,
+                (uint64_t)&args,
+                &arg_out));
+        OE_CHECK((oe_result_t)arg_out);
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+static oe_result_t _start_enclave_workers(
+    oe_switchless_manager_t* manager,
+    size_t num_enclave_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    size_t slots_size =
+        num_enclave_workers * sizeof(oe_switchless_ecall_slot_t);
+
+    if (!(manager->enclave_slots = (oe_switchless_ecall_slot_t*)oe_memalign(
+              sizeof(oe_switchless_ecall_slot_t), slots_size)))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    memset(manager->enclave_slots, 0, slots_size);
+    manager->num_enclave_workers = num_enclave_workers;
+
+    if (!(manager->enclave_workers = (oe_enclave_worker_t*)calloc(
+              num_enclave_workers, sizeof(oe_enclave_worker_t))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    for (size_t i = 0; i < num_enclave_workers; i++)
+    {
+        oe_enclave_worker_t* worker = &manager->enclave_workers[i];
+
+        worker->manager = manager;
+        worker->slot = &manager->enclave_slots[i];
+
+        if (oe_thread_create(&worker->thread, _enclave_worker, worker) != 0)
+            OE_RAISE_MSG(OE_FAILURE, "failed to start switchless worker\n");
+
+        manager->num_enclave_started++;
+    }
+
+    result = OE_OK;
+
+done:
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_start_switchless_manager()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    size_t num_host_workers,
+    size_t num_enclave_workers)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager = NULL;
+
+    if (!enclave || enclave->switchless_manager ||
+        num_host_workers > OE_SWITCHLESS_MAX_HOST_WORKERS)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Leave at least one TCS for regular ECALLs */
+    if (num_enclave_workers >= enclave->num_bindings)
+        OE_RAISE_MSG(
+            OE_INVALID_PARAMETER,
+            "enclave has too few TCSs for %llu switchless workers\n",
+            OE_LLU(num_enclave_workers));
+
+    if (!(manager = (oe_switchless_manager_t*)calloc(1, sizeof(*manager))))
+        OE_RAISE(OE_OUT_OF_MEMORY);
+
+    manager->enclave = enclave;
+
+    if (num_host_workers)
+        OE_CHECK(_start_host_workers(manager, num_host_workers));
+
+    if (num_enclave_workers)
+        OE_CHECK(_start_enclave_workers(manager, num_enclave_workers));
+
+    enclave->switchless_manager = manager;
+    manager = NULL;
+    result = OE_OK;
+
+done:
+
+    if (manager)
+        _free_manager(manager);
+
+    return result;
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_switchless_enclave_workers()
+**
+**     Must be called before the enclave destructor runs, since the enclave
+**     workers execute inside the enclave.
+**
+**==============================================================================
+*/
+
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave)
+{
+    oe_switchless_manager_t* manager;
+
+    if (enclave && (manager = enclave->switchless_manager) &&
+        manager->enclave_slots)
+    {
+        _stop_enclave_workers(manager);
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_stop_switchless_manager()
+**
+**     Must not be called while enclave threads may still post calls (i.e.
+**     after the enclave destructor has run).
+**
+**==============================================================================
+*/
+
+void oe_stop_switchless_manager(oe_enclave_t* enclave)
+{
+    if (enclave && enclave->switchless_manager)
+    {
+        _free_manager(enclave->switchless_manager);
+        enclave->switchless_manager = NULL;
+    }
+}
+
+/*
+**==============================================================================
+**
+** oe_switchless_call_enclave_function()
+**
+**==============================================================================
+*/
+
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written)
+{
+    oe_result_t result = OE_UNEXPECTED;
+    oe_switchless_manager_t* manager;
+    oe_switchless_ecall_slot_t* slot = NULL;
+    size_t num_slots;
+    uint64_t start;
+    uint64_t spins = 0;
+    uint64_t call_start = 0;
+
+    /* Reject invalid parameters */
+    if (!enclave)
+        OE_RAISE(OE_INVALID_PARAMETER);
+
+    /* Without enclave workers, perform a regular ECALL */
+    manager = enclave->switchless_manager;
+
+    if (!manager || !manager->enclave_slots)
+        goto fallback;
+
+    /* Claim a free slot, starting at a different slot for each call */
+    num_slots = manager->num_enclave_workers;
+    start = oe_atomic_increment(&manager->next_enclave_slot);
+
+    for (size_t i = 0; i < num_slots; i++)
+    {
+        oe_switchless_ecall_slot_t* p =
+            &manager->enclave_slots[(start + i) % num_slots];
+
+        if (p->state == OE_SWITCHLESS_SLOT_FREE &&
+            oe_atomic_compare_and_swap(
+                &p->state,
+                OE_SWITCHLESS_SLOT_FREE,
+                OE_SWITCHLESS_SLOT_RESERVED))
+        {
+            slot = p;
+            break;
+        }
+    }
+
+    if (!slot)
+        goto fallback;
+
+    /* Fill in the arguments and post the call */
+    slot->args.function_id = function_id;
+    slot->args.input_buffer = input_buffer;
+    slot->args.input_buffer_size = input_buffer_size;
+    slot->args.output_buffer = output_buffer;
+    slot->args.output_buffer_size = output_buffer_size;
+    slot->args.output_bytes_written = 0;
+    slot->args.result = OE_UNEXPECTED;
+    slot->result = OE_UNEXPECTED;
+    call_start = oe_call_stats_start(enclave);
+
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    slot->state = OE_SWITCHLESS_SLOT_POSTED;
+
+    /* Wait for a worker to pick up the call */
+    for (size_t i = 0; i < OE_SWITCHLESS_PICKUP_SPIN_COUNT; i++)
+    {
+        if (slot->state != OE_SWITCHLESS_SLOT_POSTED)
+            break;
+
+        oe_cpu_relax();
+    }
+
+    /* If still not picked up, retract the call and fall back */
+    if (oe_atomic_compare_and_swap(
+            &slot->state, OE_SWITCHLESS_SLOT_POSTED, OE_SWITCHLESS_SLOT_FREE))
+    {
+        goto fallback;
+    }
+
+    /* A worker is running the call; spin, then yield, until it completes */
+    while (slot->state != OE_SWITCHLESS_SLOT_DONE)
+    {
+        if (++spins < OE_SWITCHLESS_WORKER_SPIN_COUNT)
+            oe_cpu_relax();
+        else
+            _yield();
+    }
+
+    OE_ATOMIC_MEMORY_BARRIER_ACQUIRE();
+
+    /* A retracted call is timed by the regular ECALL it falls back to */
+    if (call_start)
+        oe_record_call(enclave, OE_CALL_STATS_ECALL, function_id, call_start);
+
+    /* Check the transport result, then the result of the call */
+    result = slot->result;
+
+    if (result == OE_OK)
+        result = slot->args.result;
+
+    if (result == OE_OK)
+        *output_bytes_written = slot->args.output_bytes_written;
+
+    /* Release the slot */
+    OE_ATOMIC_MEMORY_BARRIER_RELEASE();
+    slot->state = OE_SWITCHLESS_SLOT_FREE;
+
+    OE_CHECK(result);
+
+    result = OE_OK;
+
+done:
+    return result;
+
+fallback:
+    return oe_call_enclave_function(
+        enclave,
+        function_id,
+        input_buffer,
+        input_buffer_size,
+        output_buffer,
+        output_buffer_size,
+        output_bytes_written);
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_HOST_SGX_SWITCHLESS_H
+#define _OE_HOST_SGX_SWITCHLESS_H
+
+#include <openenclave/internal/switchless.h>
+#include "enclave.h"
+
+/*
+**==============================================================================
+**
+** oe_switchless_manager_t
+**
+**     Host worker threads servicing switchless OCALLs and enclave worker
+**     threads servicing switchless ECALLs for one enclave, together with the
+**     slots they poll.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_host_worker
+{
+    struct _oe_switchless_manager* manager;
+
+    /* The slot polled by this worker */
+    oe_switchless_slot_t* slot;
+
+    oe_thread_handle thread;
+} oe_host_worker_t;
+
+typedef struct _oe_enclave_worker
+{
+    struct _oe_switchless_manager* manager;
+
+    /* The slot polled by this worker (from inside the enclave) */
+    oe_switchless_ecall_slot_t* slot;
+
+    oe_thread_handle thread;
+} oe_enclave_worker_t;
+
+typedef struct _oe_switchless_manager
+{
+    oe_enclave_t* enclave;
+
+    /* Array of OCALL slots shared with the enclave (one per host worker) */
+    oe_switchless_slot_t* host_slots;
+
+    /* Array of host workers */
+    oe_host_worker_t* host_workers;
+    size_t num_host_workers;
+
+    /* Number of host workers whose thread is running */
+    size_t num_host_started;
+
+    /* Set to ask all host workers to exit */
+    volatile bool stopping;
+
+    /* Array of ECALL slots shared with the enclave (one per enclave worker) */
+    oe_switchless_ecall_slot_t* enclave_slots;
+
+    /* Array of enclave workers */
+    oe_enclave_worker_t* enclave_workers;
+    size_t num_enclave_workers;
+
+    /* Number of enclave workers whose thread is running */
+    size_t num_enclave_started;
+
+    /* Used to spread host threads over the ECALL slots */
+    volatile uint64_t next_enclave_slot;
+} oe_switchless_manager_t;
+
+/* Start the workers and register the OCALL slots with the enclave */
+oe_result_t oe_start_switchless_manager(
+    oe_enclave_t* enclave,
+    size_t num_host_workers,
+    size_t num_enclave_workers);
+
+/* Stop the enclave workers (if any), releasing their TCSs */
+void oe_stop_switchless_enclave_workers(oe_enclave_t* enclave);
+
+/* Stop all workers and release the manager (if any) */
+void oe_stop_switchless_manager(oe_enclave_t* enclave);
+
+#endif /* _OE_HOST_SGX_SWITCHLESS_H */
@@ -128,3 +128,96 @@ void* oe_thread_getspecific(oe_thread_key key)
 {
     return TlsGetValue(key);
 }
+
+/*
+**==============================================================================
+**
+** oe_thread_handle
+**
+**==============================================================================
+*/
+
+typedef struct _thread_start_args
+{
+    void (*func)(void* arg);
+    void* arg;
+} thread_start_args_t;
+
+static DWORD WINAPI _thread_start(LPVOID arg)
+{
+    thread_start_args_t args = *(thread_start_args_t*)arg;
+
+    free(arg);
+    args.func(args.arg);
+
+    return 0;
+}
+
+int oe_thread_create(
+    oe_thread_handle* thread,
+    void (*func)(void* arg),
+    void* arg)
+{
+    thread_start_args_t* args;
+    HANDLE h;
+
+    if (!thread || !func)
+        return 1;
+
+    if (!(args = (thread_start_args_t*)malloc(sizeof(thread_start_args_t))))
+        return 1;
+
+    args->func = func;
+    args->arg = arg;
+
+    if (!(h = CreateThread(NULL, 0, _thread_start, args, 0, NULL)))
+    {
+        free(args);
+        return 1;
+    }
+
+    *thread = h;
+    return 0;
+}
+
+int oe_thread_join(oe_thread_handle thread)
+{
+    if (WaitForSingleObject(thread, INFINITE) != WAIT_OBJECT_0)
+        return 1;
+
+    return !CloseHandle(thread);
+}
+
+/*
+**==============================================================================
+**
+** oe_semaphore
+**
+**==============================================================================
+*/
+
+int oe_semaphore_init(oe_semaphore* sem, uint32_t value)
+{
+    HANDLE h = CreateSemaphore(NULL, (LONG)value, MAXLONG, NULL);
+
+    if (!h)
+        return 1;
+
+    *sem = h;
+    return 0;
+}
+
+int oe_semaphore_wait(oe_semaphore* sem)
+{
+    return WaitForSingleObject(*sem, INFINITE) != WAIT_OBJECT_0;
+}
+
+int oe_semaphore_post(oe_semaphore* sem)
+{
+    return !ReleaseSemaphore(*sem, 1, NULL);
+}
+
+int oe_semaphore_destroy(oe_semaphore* sem)
+{
+    return !CloseHandle(*sem);
+}
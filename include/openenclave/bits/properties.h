@@ -27,8 +27,9 @@ OE_EXTERNC_BEGIN
 #define OE_INFO_SECTION_NAME ".oeinfo"
 #define OE_ECALL_SECTION_NAME ".ecall"
 
-/* Max number of threads in an enclave supported */
-#define OE_SGX_MAX_TCS 32
+/* Max number of threads in an enclave supported. SGX itself does not limit
+ * the number of TCSs; the host allocates one thread binding per TCS. */
+#define OE_SGX_MAX_TCS 4096
 
 typedef struct _oe_enclave_size_settings
 {
@@ -263,6 +263,12 @@ typedef enum _oe_result {
      */
     OE_UNSUPPORTED_ENCLAVE_IMAGE,
 
+    /**
+     * An operation did not complete before its deadline. For example, a
+     * timed wait on a condition variable was not signaled in time.
+     */
+    OE_TIMEDOUT,
+
     __OE_RESULT_MAX = OE_ENUM_MAX,
 } oe_result_t;
 /**< typedef enum _oe_result oe_result_t*/
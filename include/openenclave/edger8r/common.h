@@ -34,6 +34,14 @@ OE_EXTERNC_BEGIN
 
 #define OE_EDGER8R_BUFFER_ALIGNMENT (2 * sizeof(void*))
 
+/**
+ * Round a size up to OE_EDGER8R_BUFFER_ALIGNMENT (as a constant expression).
+ */
+#define OE_EDGER8R_ALIGN_SIZE(size)                        \
+    ((((size_t)(size) + OE_EDGER8R_BUFFER_ALIGNMENT - 1) / \
+      OE_EDGER8R_BUFFER_ALIGNMENT) *                       \
+     OE_EDGER8R_BUFFER_ALIGNMENT)
+
 /**
  * Add a size value, rounding to sizeof(void*).
  */
@@ -158,6 +166,22 @@ done:
 
 #define OE_READ_IN_OUT_PARAM OE_READ_OUT_PARAM
 
+/**
+ * One call of a batch of enclave function calls (see
+ * oe_call_enclave_function_batch()). The caller fills in the function id and
+ * the buffers; output_bytes_written and result are set by the call.
+ */
+typedef struct _oe_enclave_function_call
+{
+    uint64_t function_id;
+    const void* input_buffer;
+    size_t input_buffer_size;
+    void* output_buffer;
+    size_t output_buffer_size;
+    size_t output_bytes_written;
+    oe_result_t result;
+} oe_enclave_function_call_t;
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_COMMON_H
@@ -73,6 +73,53 @@ oe_result_t oe_call_host_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Perform a high-level enclave function call (OCALL) without exiting the
+ * enclave.
+ *
+ * The call is posted to a host worker thread that polls for requests. If the
+ * enclave was created without host workers, if all workers are busy, or if no
+ * worker picks up the call in time, a regular OCALL is performed instead.
+ *
+ * The parameters and return values are the same as oe_call_host_function().
+ */
+oe_result_t oe_switchless_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * Queue a high-level enclave function call (OCALL) without exiting the
+ * enclave.
+ *
+ * The call is appended to an untrusted queue owned by the calling thread and
+ * runs on the host the next time the thread exits the enclave: when the
+ * current ECALL returns, before the next synchronous OCALL, or when the queue
+ * fills up. Queued calls run in the order in which they were made. The
+ * function must not produce outputs, since they are discarded.
+ *
+ * If the call does not fit into an empty queue, a regular OCALL is performed
+ * instead.
+ *
+ * @param function_id The id of the host function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer the host function may write to.
+ * @param output_buffer_size Size of the output buffer.
+ *
+ * @return OE_OK the call was queued (or made).
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ */
+oe_result_t oe_deferred_call_host_function(
+    size_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size);
+
 /**
  * Allocate a buffer of given size for doing an ocall.
  *
@@ -66,6 +66,148 @@ oe_result_t oe_call_enclave_function(
     size_t output_buffer_size,
     size_t* output_bytes_written);
 
+/**
+ * Perform a high-level enclave function call (ECALL) without entering the
+ * enclave.
+ *
+ * The call is posted to an enclave worker thread that polls for requests. If
+ * the enclave was created without enclave workers, if all workers are busy,
+ * or if no worker picks up the call in time, a regular ECALL is performed
+ * instead.
+ *
+ * The parameters and return values are the same as oe_call_enclave_function().
+ */
+oe_result_t oe_switchless_call_enclave_function(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    size_t* output_bytes_written);
+
+/**
+ * Perform a batch of high-level enclave function calls (ECALLs) with a single
+ * enclave entry.
+ *
+ * The calls are executed in order. Each call behaves as if it were made with
+ * oe_call_enclave_function() and its outcome is stored in the result and
+ * output_bytes_written fields of its entry. A failing call does not prevent
+ * the execution of the remaining calls.
+ *
+ * @param enclave The enclave to call into.
+ * @param calls Array of calls to perform.
+ * @param num_calls Number of entries in **calls**.
+ *
+ * @return OE_OK the batch was executed (see the result of each call).
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_OUT_OF_THREADS no enclave thread is available.
+ *
+ */
+oe_result_t oe_call_enclave_function_batch(
+    oe_enclave_t* enclave,
+    oe_enclave_function_call_t* calls,
+    size_t num_calls);
+
+/**
+ * Function called when an asynchronous enclave function call completes.
+ *
+ * @param result The result of the call, as oe_call_enclave_function() would
+ * have returned it.
+ * @param output_bytes_written Number of bytes written in the output buffer.
+ * @param arg The argument given to oe_call_enclave_function_async().
+ */
+typedef void (*oe_async_call_callback_t)(
+    oe_result_t result,
+    size_t output_bytes_written,
+    void* arg);
+
+/**
+ * Perform a high-level enclave function call (ECALL) asynchronously.
+ *
+ * The call is queued to a pool of host threads owned by the enclave, which
+ * is started by the first asynchronous call. Each pool thread keeps reusing
+ * the same TCS. The buffers must remain valid until the call completes.
+ *
+ * When the call has been made, **callback** (if not NULL) is invoked on the
+ * pool thread. Afterwards the call is complete: oe_async_call_wait() returns
+ * and oe_async_call_is_complete() returns true.
+ *
+ * @param enclave The enclave to call into.
+ * @param function_id The id of the enclave function that will be called.
+ * @param input_buffer Buffer containing inputs data.
+ * @param input_buffer_size Size of the input data buffer.
+ * @param output_buffer Buffer where the outputs of the enclave function are
+ * written to.
+ * @param output_buffer_size Size of the output buffer.
+ * @param callback Function called when the call completes (may be NULL).
+ * @param callback_arg Argument passed to **callback**.
+ * @param call Set to the handle of the call, which must be released with
+ * oe_async_call_free(). If NULL, the handle is released automatically when
+ * the call completes.
+ *
+ * @return OE_OK the call was queued.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_OUT_OF_MEMORY the call could not be queued.
+ * @return OE_FAILURE the pool could not be started or is stopping.
+ */
+oe_result_t oe_call_enclave_function_async(
+    oe_enclave_t* enclave,
+    uint32_t function_id,
+    const void* input_buffer,
+    size_t input_buffer_size,
+    void* output_buffer,
+    size_t output_buffer_size,
+    oe_async_call_callback_t callback,
+    void* callback_arg,
+    oe_async_call_t** call);
+
+/**
+ * Largest marshaling buffer that generated ECALL wrappers place on the stack.
+ */
+#define OE_EDGER8R_MAX_STACK_BUFFER_SIZE 4096
+
+/**
+ * Unit of marshaling buffers placed on the stack. Gives them the alignment of
+ * heap allocations.
+ */
+typedef struct _oe_edger8r_buffer_unit
+{
+    void* words[2];
+} OE_ALIGNED(16) oe_edger8r_buffer_unit_t;
+
+/**
+ * Number of units of a stack buffer for a marshaling buffer of at most
+ * **size** bytes. Sizes above OE_EDGER8R_MAX_STACK_BUFFER_SIZE get a single
+ * unit, which forces the wrapper to use oe_acquire_ecall_buffer() instead.
+ */
+#define OE_EDGER8R_STACK_BUFFER_UNITS(size)                  \
+    ((size) <= OE_EDGER8R_MAX_STACK_BUFFER_SIZE              \
+         ? ((size) + sizeof(oe_edger8r_buffer_unit_t) - 1) / \
+               sizeof(oe_edger8r_buffer_unit_t)              \
+         : 1)
+
+/**
+ * Get a marshaling buffer of at least the given size for an ECALL.
+ *
+ * The calling thread keeps one buffer that is reused by its calls, so that
+ * most ECALLs do not allocate memory. If that buffer is in use (by an ECALL
+ * made while handling an OCALL of an outer ECALL), a new buffer is
+ * allocated.
+ *
+ * @param size The size of the buffer in bytes.
+ *
+ * @returns The buffer or NULL if out of memory.
+ */
+void* oe_acquire_ecall_buffer(size_t size);
+
+/**
+ * Release a buffer obtained with oe_acquire_ecall_buffer().
+ *
+ * @param buffer The buffer to release (may be NULL).
+ */
+void oe_release_ecall_buffer(void* buffer);
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_HOST_H
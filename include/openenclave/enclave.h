@@ -122,6 +122,46 @@ oe_result_t oe_call_host_by_address(
     void (*func)(void*, oe_enclave_t*),
     void* args);
 
+/**
+ * Opaque handle of a host function (see oe_get_host_function_handle()).
+ * Zero is never a valid handle.
+ */
+typedef uint64_t oe_host_function_handle_t;
+
+/**
+ * Resolve the name of a host function to a handle.
+ *
+ * The handle can be passed to oe_call_host_by_handle() any number of times to
+ * call the function without the host looking up its name again.
+ *
+ * @param func The name of the host function (see oe_call_host()).
+ * @param handle The handle of the function on return.
+ *
+ * @return OE_OK the function was found.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_NOT_FOUND the host does not define the function.
+ */
+oe_result_t oe_get_host_function_handle(
+    const char* func,
+    oe_host_function_handle_t* handle);
+
+/**
+ * Perform a high-level host function call (OCALL) by handle.
+ *
+ * This function behaves like oe_call_host() but identifies the function by a
+ * handle obtained from oe_get_host_function_handle().
+ *
+ * @param handle The handle of the host function that will be called.
+ * @param args The arguments to be passed to the host function.
+ *
+ * @return OE_OK the call was successful.
+ * @return OE_INVALID_PARAMETER a parameter is invalid.
+ * @return OE_FAILURE the call failed.
+ */
+oe_result_t oe_call_host_by_handle(
+    oe_host_function_handle_t handle,
+    void* args);
+
 /**
  * Check whether the given buffer is strictly within the enclave.
  *
@@ -166,6 +206,10 @@ bool oe_is_outside_enclave(const void* ptr, size_t size);
  * the host, which calls malloc(). To free the memory, it must be passed to
  * oe_host_free().
  *
+ * If the enclave was created with the OE_ENCLAVE_SETTING_HOST_HEAP setting,
+ * the memory is sub-allocated inside the enclave from host memory reserved
+ * up front, without an OCALL. Such memory must not be released by the host.
+ *
  * @param size The number of bytes to be allocated.
  *
  * @returns The allocated memory or NULL if unable to allocate the memory.
@@ -218,7 +262,9 @@ void* oe_host_calloc(size_t nmemb, size_t size);
  * Release allocated memory.
  *
  * This function releases memory allocated with oe_host_malloc() or
- * oe_host_calloc() by performing an OCALL where the host calls free().
+ * oe_host_calloc() by performing an OCALL where the host calls free(). Memory
+ * from the untrusted heap (see OE_ENCLAVE_SETTING_HOST_HEAP) is released
+ * without an OCALL.
  *
  * @param ptr Pointer to memory to be released or null.
  *
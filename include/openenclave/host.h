@@ -53,6 +53,96 @@ OE_EXTERNC_BEGIN
  * @endcond
  */
 
+/**
+ * Types of settings that may be passed to oe_create_enclave() through its
+ * **config** parameter.
+ */
+typedef enum _oe_enclave_setting_type {
+    /** Configure switchless calls (see oe_enclave_setting_switchless_t) */
+    OE_ENCLAVE_SETTING_SWITCHLESS = 0x1,
+    /** Configure the untrusted heap (see oe_enclave_setting_host_heap_t) */
+    OE_ENCLAVE_SETTING_HOST_HEAP = 0x2,
+    /** Collect call statistics (see oe_enclave_setting_call_stats_t) */
+    OE_ENCLAVE_SETTING_CALL_STATS = 0x3,
+    __OE_ENCLAVE_SETTING_MAX = OE_ENUM_MAX,
+} oe_enclave_setting_type_t;
+
+/**
+ * Settings for switchless calls.
+ *
+ * When **num_host_workers** is non-zero, oe_create_enclave() starts that many
+ * host worker threads. Enclave threads post OCALLs to these workers through
+ * untrusted shared memory instead of exiting the enclave. An OCALL that no
+ * worker picks up in time is performed with a regular enclave exit.
+ *
+ * When **num_enclave_workers** is non-zero, oe_create_enclave() also starts
+ * that many enclave worker threads. Each one permanently occupies a TCS and
+ * services switchless ECALLs posted by host threads, so it must be smaller
+ * than the TCS count of the enclave. An ECALL that no worker picks up in time
+ * is performed with a regular enclave entry.
+ */
+typedef struct _oe_enclave_setting_switchless
+{
+    /** The number of host worker threads that service switchless OCALLs */
+    uint32_t num_host_workers;
+
+    /** The number of enclave worker threads that service switchless ECALLs */
+    uint32_t num_enclave_workers;
+} oe_enclave_setting_switchless_t;
+
+/**
+ * Settings for the untrusted heap.
+ *
+ * When **region_size** is non-zero, oe_create_enclave() reserves a region of
+ * host memory of that size, which the enclave sub-allocates to serve
+ * oe_host_malloc(), oe_host_calloc(), oe_host_realloc(), oe_host_strndup()
+ * and oe_host_free() without leaving the enclave. The enclave only performs
+ * an OCALL to obtain another region of the same size once the reserved
+ * memory is exhausted.
+ *
+ * With this setting, memory returned by oe_host_malloc() and related
+ * functions must only be released with oe_host_free() inside the enclave;
+ * the host must not pass it to free().
+ */
+typedef struct _oe_enclave_setting_host_heap
+{
+    /** The size in bytes of each untrusted region */
+    uint64_t region_size;
+} oe_enclave_setting_host_heap_t;
+
+/**
+ * Settings for call statistics.
+ *
+ * With this setting, the host records the count and latency of every
+ * function-id based ECALL and OCALL and of the built-in OCALLs of the enclave.
+ * See oe_get_enclave_call_stats(). Without it, calls are not timed.
+ */
+typedef struct _oe_enclave_setting_call_stats
+{
+    /** Print the statistics to stderr when the enclave is terminated */
+    bool dump_on_terminate;
+} oe_enclave_setting_call_stats_t;
+
+/**
+ * A single enclave creation setting.
+ */
+typedef struct _oe_enclave_setting
+{
+    /** The type of the setting */
+    oe_enclave_setting_type_t setting_type;
+
+    union {
+        /** Valid when **setting_type** is OE_ENCLAVE_SETTING_SWITCHLESS */
+        const oe_enclave_setting_switchless_t* switchless;
+
+        /** Valid when **setting_type** is OE_ENCLAVE_SETTING_HOST_HEAP */
+        const oe_enclave_setting_host_heap_t* host_heap;
+
+        /** Valid when **setting_type** is OE_ENCLAVE_SETTING_CALL_STATS */
+        const oe_enclave_setting_call_stats_t* call_stats;
+    } u;
+} oe_enclave_setting_t;
+
 /**
  * Type of each function in an ocall-table.
  */
@@ -82,10 +172,10 @@ typedef void (*oe_ocall_func_t)(
  *     - OE_ENCLAVE_FLAG_DEBUG - runs the enclave in debug mode.
  *                               DO NOT SHIP CODE with this flag
  *
- * @param config Additional enclave creation configuration data for the specific
- * enclave type. This parameter is reserved and must be NULL.
+ * @param config An optional array of oe_enclave_setting_t structures that
+ * configure additional runtime features of the enclave, or NULL.
  *
- * @param config_size The size of the **config** data buffer in bytes.
+ * @param config_size The size of the **config** array in bytes.
  *
  * @param ocall_table Pointer to table of ocall functions generated by
  * oeedger8r.
@@ -154,6 +244,171 @@ oe_result_t oe_call_enclave(
     const char* func,
     void* args);
 
+/**
+ * Opaque handle of an enclave function (see oe_get_enclave_function_handle()).
+ * Zero is never a valid handle.
+ */
+typedef uint64_t oe_enclave_function_handle_t;
+
+/**
+ * Resolve the name of an enclave function to a handle.
+ *
+ * The handle can be passed to oe_call_enclave_by_handle() any number of times
+ * to call the function without looking up its name again. It remains valid
+ * until the enclave is terminated.
+ *
+ * @param enclave The instance of the enclave that defines the function.
+ *
+ * @param func The name of the enclave function (see oe_call_enclave()).
+ *
+ * @param handle The handle of the function on return.
+ *
+ * @retval OE_OK The function was found.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_NOT_FOUND The enclave does not define the function.
+ *
+ */
+oe_result_t oe_get_enclave_function_handle(
+    oe_enclave_t* enclave,
+    const char* func,
+    oe_enclave_function_handle_t* handle);
+
+/**
+ * Perform a high-level enclave function call (ECALL) by handle.
+ *
+ * This function behaves like oe_call_enclave() but identifies the function by
+ * a handle obtained from oe_get_enclave_function_handle().
+ *
+ * @param enclave The instance of the enclave to be called.
+ *
+ * @param handle The handle of the enclave function that will be called.
+ *
+ * @param args The arguments to be passed to the enclave function.
+ *
+ * @returns This function return **OE_OK** on success.
+ *
+ */
+oe_result_t oe_call_enclave_by_handle(
+    oe_enclave_t* enclave,
+    oe_enclave_function_handle_t handle,
+    void* args);
+
+/**
+ * Handle of an asynchronous enclave function call. See
+ * oe_call_enclave_function_async() and the **_async** wrappers generated by
+ * oeedger8r.
+ */
+typedef struct _oe_async_call oe_async_call_t;
+
+/**
+ * Check whether an asynchronous call has completed.
+ *
+ * A call has completed once its completion callback (if any) has returned.
+ *
+ * @param call The handle of the call.
+ *
+ * @returns true if the call has completed.
+ */
+bool oe_async_call_is_complete(oe_async_call_t* call);
+
+/**
+ * Wait for an asynchronous call to complete.
+ *
+ * This function may be called any number of times, also from several threads.
+ *
+ * @param call The handle of the call.
+ *
+ * @param output_bytes_written Set to the number of bytes written to the
+ * output buffer of the call (may be NULL).
+ *
+ * @returns The result of the call, as oe_call_enclave_function() would have
+ * returned it.
+ */
+oe_result_t oe_async_call_wait(
+    oe_async_call_t* call,
+    size_t* output_bytes_written);
+
+/**
+ * Release the handle of an asynchronous call, waiting for the call to
+ * complete if necessary.
+ *
+ * @param call The handle of the call (may be NULL).
+ */
+void oe_async_call_free(oe_async_call_t* call);
+
+/** Number of buckets of the latency histogram of oe_call_stats_t */
+#define OE_CALL_STATS_NUM_BUCKETS 32
+
+/** Maximum number of ECALL function ids that statistics are kept for */
+#define OE_CALL_STATS_MAX_ECALLS 256
+
+/**
+ * Kinds of calls that statistics are kept for.
+ */
+typedef enum _oe_call_stats_type {
+    /** ECALLs by function id (see oe_call_enclave_function()). This includes
+     * switchless ECALLs and each call of oe_call_enclave_function_batch(),
+     * which is recorded with an equal share of the time of its batch */
+    OE_CALL_STATS_ECALL = 0,
+    /** OCALLs by function id (index into the ocall table of the enclave) */
+    OE_CALL_STATS_OCALL = 1,
+    /** Built-in OCALLs of the runtime, by internal OCALL number */
+    OE_CALL_STATS_BUILTIN_OCALL = 2,
+    /** ECALLs made with oe_call_enclave() or oe_call_enclave_by_handle(), by
+     * index of the function in the ecall table of the enclave */
+    OE_CALL_STATS_LEGACY_ECALL = 3,
+    __OE_CALL_STATS_TYPE_MAX = OE_ENUM_MAX,
+} oe_call_stats_type_t;
+
+/**
+ * Statistics of the calls of a single function.
+ *
+ * ECALL times cover the whole call as seen by the host, including the
+ * transitions and any OCALLs made by the enclave function. OCALL times only
+ * cover the host function. Times are in nanoseconds.
+ */
+typedef struct _oe_call_stats
+{
+    /** The number of calls */
+    uint64_t count;
+
+    /** The sum of the durations of all calls */
+    uint64_t total_time;
+
+    /** The longest duration of a call */
+    uint64_t max_time;
+
+    /** Bucket i counts the calls that took less than 2^(i+1) ns (and at least
+     * 2^i ns unless i is zero). The last bucket also counts longer calls */
+    uint64_t histogram[OE_CALL_STATS_NUM_BUCKETS];
+} oe_call_stats_t;
+
+/**
+ * Get the call statistics of an enclave function or host function.
+ *
+ * The enclave must have been created with the OE_ENCLAVE_SETTING_CALL_STATS
+ * setting. Statistics of ECALLs are only kept for function ids (or, for
+ * OE_CALL_STATS_LEGACY_ECALL, indices) below OE_CALL_STATS_MAX_ECALLS.
+ *
+ * @param enclave The enclave whose calls are reported.
+ *
+ * @param type The kind of call.
+ *
+ * @param function_id The id of the function.
+ *
+ * @param stats The statistics on return.
+ *
+ * @retval OE_OK The statistics were copied.
+ * @retval OE_INVALID_PARAMETER At least one parameter is invalid.
+ * @retval OE_UNSUPPORTED The enclave does not collect statistics.
+ *
+ */
+oe_result_t oe_get_enclave_call_stats(
+    oe_enclave_t* enclave,
+    oe_call_stats_type_t type,
+    uint32_t function_id,
+    oe_call_stats_t* stats);
+
 #if (OE_API_VERSION < 2)
 #define oe_get_report oe_get_report_v1
 #else
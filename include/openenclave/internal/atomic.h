@@ -35,4 +35,46 @@ OE_INLINE uint64_t oe_atomic_decrement(volatile uint64_t* x)
 #endif
 }
 
+/* Atomically add **value** to **x** and return its new value */
+OE_INLINE uint64_t oe_atomic_add(volatile uint64_t* x, uint64_t value)
+{
+#if defined(__GNUC__)
+    return __sync_add_and_fetch(x, value);
+#elif defined(_MSC_VER)
+    return (uint64_t)InterlockedAdd64((volatile LONG64*)x, (LONG64)value);
+#else
+#error "unsupported"
+#endif
+}
+
+/* Atomically replace **x** with **new_value** if it equals **old_value**.
+ * Return true if the exchange took place */
+OE_INLINE bool oe_atomic_compare_and_swap(
+    volatile uint64_t* x,
+    uint64_t old_value,
+    uint64_t new_value)
+{
+#if defined(__GNUC__)
+    return __sync_bool_compare_and_swap(x, old_value, new_value);
+#elif defined(_MSC_VER)
+    return InterlockedCompareExchange64(
+               (volatile LONG64*)x, (LONG64)new_value, (LONG64)old_value) ==
+           (LONG64)old_value;
+#else
+#error "unsupported"
+#endif
+}
+
+/* Hint to the processor that the caller is spinning on a memory location */
+OE_INLINE void oe_cpu_relax(void)
+{
+#if defined(__GNUC__)
+    asm volatile("pause" ::: "memory");
+#elif defined(_MSC_VER)
+    YieldProcessor();
+#else
+#error "unsupported"
+#endif
+}
+
 #endif /* _OE_ATOMIC_H */
@@ -6,6 +6,7 @@
 
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/types.h>
+#include <openenclave/edger8r/common.h>
 #include <openenclave/internal/cpuid.h>
 #include <openenclave/internal/defs.h>
 #include "backtrace.h"
@@ -77,6 +78,11 @@ typedef enum _oe_func {
     OE_ECALL_GET_SGX_REPORT,
     OE_ECALL_VIRTUAL_EXCEPTION_HANDLER,
     OE_ECALL_LOG_INIT,
+    OE_ECALL_INIT_SWITCHLESS,
+    OE_ECALL_SWITCHLESS_WORKER,
+    OE_ECALL_CALL_ENCLAVE_FUNCTION_BATCH,
+    OE_ECALL_THREAD_START,
+    OE_ECALL_GET_LOCK_PROFILE,
     /* Caution: always add new ECALL function numbers here */
 
     OE_OCALL_CALL_HOST = OE_OCALL_BASE,
@@ -97,6 +103,12 @@ typedef enum _oe_func {
     OE_OCALL_GET_TIME,
     OE_OCALL_BACKTRACE_SYMBOLS,
     OE_OCALL_LOG,
+    OE_OCALL_GROW_HOST_HEAP,
+    OE_OCALL_FLUSH_DEFERRED,
+    OE_OCALL_GET_HOST_FUNC,
+    OE_OCALL_THREAD_WAKE_MULTIPLE,
+    OE_OCALL_THREAD_WAIT_TIMEOUT,
+    OE_OCALL_THREAD_CREATE,
     /* Caution: always add new OCALL function numbers here */
 
     __OE_FUNC_MAX = OE_ENUM_MAX,
@@ -223,6 +235,20 @@ typedef struct _oe_call_enclave_function_args
     oe_result_t result;
 } oe_call_enclave_function_args_t;
 
+/*
+**==============================================================================
+**
+** oe_call_enclave_function_batch_args_t
+**
+**==============================================================================
+*/
+
+typedef struct _oe_call_enclave_function_batch_args
+{
+    oe_enclave_function_call_t* calls;
+    uint64_t num_calls;
+} oe_call_enclave_function_batch_args_t;
+
 /*
 **==============================================================================
 **
@@ -305,6 +331,24 @@ typedef struct _oe_call_host_by_address_args
     oe_result_t result;
 } oe_call_host_by_address_args_t;
 
+/*
+**==============================================================================
+**
+** oe_get_host_func_args_t
+**
+**     Find the address of the host function with the given name (see
+**     oe_get_host_function_handle()).
+**
+**==============================================================================
+*/
+
+typedef struct _oe_get_host_func_args
+{
+    oe_host_func_t func;
+    oe_result_t result;
+    OE_ZERO_SIZED_ARRAY char name[];
+} oe_get_host_func_args_t;
+
 /*
 **==============================================================================
 **
@@ -337,6 +381,87 @@ typedef struct _oe_realloc_args
     size_t size;
 } oe_realloc_args_t;
 
+/*
+**==============================================================================
+**
+** oe_scratch_region_t
+**
+**     Host memory preallocated for one TCS. The enclave bump-allocates OCALL
+**     argument frames and marshaling buffers from it, so that an OCALL does
+**     not need extra OCALLs to allocate and free host memory.
+**
+**==============================================================================
+*/
+
+#define OE_SCRATCH_REGION_SIZE (64 * 1024)
+
+typedef struct _oe_scratch_region
+{
+    /* Address of the TCS that owns this region */
+    uint64_t tcs;
+
+    void* base;
+    uint64_t size;
+
+    /* Queue of deferred OCALLs of this TCS (see below) */
+    struct _oe_deferred_ocall_queue* deferred_queue;
+    uint64_t deferred_queue_size;
+} oe_scratch_region_t;
+
+/*
+**==============================================================================
+**
+** oe_deferred_ocall_queue_t
+**
+**     Host memory into which a TCS appends calls to [deferred] host
+**     functions. The header is followed by 'size' bytes of records. Each
+**     record is an oe_call_host_function_args_t (padded to
+**     OE_DEFERRED_OCALL_ALIGNMENT) followed by its input and output buffers.
+**
+**     The host runs the queued calls in order and empties the queue whenever
+**     the TCS exits the enclave, before it handles the OCALL or ERET. The
+**     enclave forces an exit with OE_OCALL_FLUSH_DEFERRED when the queue is
+**     full.
+**
+**==============================================================================
+*/
+
+#define OE_DEFERRED_OCALL_QUEUE_SIZE (16 * 1024)
+
+#define OE_DEFERRED_OCALL_ALIGNMENT 16
+
+typedef struct _oe_deferred_ocall_queue
+{
+    /* Number of bytes of records that follow */
+    uint64_t size;
+    uint64_t reserved;
+} oe_deferred_ocall_queue_t;
+
+/* Size of the call arguments at the start of each record (padded) */
+#define OE_DEFERRED_OCALL_HEADER_SIZE 64
+
+OE_STATIC_ASSERT(
+    sizeof(oe_call_host_function_args_t) <= OE_DEFERRED_OCALL_HEADER_SIZE);
+OE_STATIC_ASSERT(
+    (OE_DEFERRED_OCALL_HEADER_SIZE % OE_DEFERRED_OCALL_ALIGNMENT) == 0);
+OE_STATIC_ASSERT(
+    (sizeof(oe_deferred_ocall_queue_t) % OE_DEFERRED_OCALL_ALIGNMENT) == 0);
+
+/*
+**==============================================================================
+**
+** Untrusted heap
+**
+**     Host memory sub-allocated by the enclave to serve oe_host_malloc() and
+**     related functions (see OE_ENCLAVE_SETTING_HOST_HEAP). Each region is a
+**     multiple of OE_HOST_HEAP_SPAN_SIZE bytes. The enclave obtains further
+**     regions with OE_OCALL_GROW_HOST_HEAP.
+**
+**==============================================================================
+*/
+
+#define OE_HOST_HEAP_SPAN_SIZE (64 * 1024)
+
 /*
 **==============================================================================
 **
@@ -345,6 +470,8 @@ typedef struct _oe_realloc_args
 **     Runtime state to initialize enclave state with, includes
 **     - First 8 leaves of CPUID for enclave emulation
 **     - Enclave handle obtained by oe_create_enclave()
+**     - Untrusted scratch regions, one per TCS
+**     - The first region of the untrusted heap (if configured)
 **
 **==============================================================================
 */
@@ -353,6 +480,10 @@ typedef struct _oe_init_enclave_args
 {
     uint32_t cpuid_table[OE_CPUID_LEAF_COUNT][OE_CPUID_REG_COUNT];
     oe_enclave_t* enclave;
+    oe_scratch_region_t* scratch_regions;
+    uint64_t num_scratch_regions;
+    void* host_heap;
+    uint64_t host_heap_size;
 } oe_init_enclave_args_t;
 
 /*
@@ -29,6 +29,10 @@ const void* __oe_get_heap_base(void);
 const void* __oe_get_heap_end(void);
 size_t __oe_get_heap_size(void);
 
+/* Thread sections */
+size_t __oe_get_num_tcs(void);
+void* __oe_get_tcs(size_t index);
+
 /* The enclave handle passed by host during initialization */
 extern oe_enclave_t* oe_enclave;
 
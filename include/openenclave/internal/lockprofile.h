@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_INTERNAL_LOCKPROFILE_H
+#define _OE_INTERNAL_LOCKPROFILE_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** Lock contention profile
+**
+**     An enclave whose core library is built with USE_LOCK_PROFILING keeps one
+**     entry for each lock and acquiring call site. The call site is the
+**     return address chain obtained with oe_backtrace() when the lock was
+**     obtained, so a lock taken on different paths has several entries. The
+**     host fetches the entries with OE_ECALL_GET_LOCK_PROFILE and maps the
+**     call sites to function names.
+**
+**     Without USE_LOCK_PROFILING, the locks carry no instrumentation and the
+**     ECALL fails with OE_UNSUPPORTED.
+**
+**==============================================================================
+*/
+
+/* Number of return addresses kept for the call site of an entry */
+#define OE_LOCK_PROFILE_FRAMES 8
+
+typedef enum _oe_lock_type {
+    OE_LOCK_TYPE_MUTEX = 0,
+    OE_LOCK_TYPE_COND = 1,
+    OE_LOCK_TYPE_RWLOCK_READ = 2,
+    OE_LOCK_TYPE_RWLOCK_WRITE = 3,
+    OE_LOCK_TYPE_SPINLOCK = 4,
+    __OE_LOCK_TYPE_MAX = OE_ENUM_MAX,
+} oe_lock_type_t;
+
+typedef struct _oe_lock_profile_entry
+{
+    /* Enclave address of the lock */
+    uint64_t lock;
+
+    /* The oe_lock_type_t of the lock */
+    uint32_t type;
+
+    /* Return addresses of the call site, innermost first */
+    uint32_t num_frames;
+    uint64_t frames[OE_LOCK_PROFILE_FRAMES];
+
+    /* Number of times the lock was obtained */
+    uint64_t acquisitions;
+
+    /* Number of acquisitions that had to wait */
+    uint64_t contended;
+
+    /* Number of spin iterations (pauses for spinlocks) while waiting */
+    uint64_t spins;
+
+    /* Number of times a waiting thread was parked on the host */
+    uint64_t parks;
+
+    /* Total TSC cycles spent waiting */
+    uint64_t wait_cycles;
+} oe_lock_profile_entry_t;
+
+/* Argument of OE_ECALL_GET_LOCK_PROFILE */
+typedef struct _oe_get_lock_profile_args
+{
+    oe_result_t result;
+
+    /* Host buffer that receives the entries */
+    oe_lock_profile_entry_t* entries;
+
+    /* In: capacity of entries. Out: number of entries of the enclave */
+    uint64_t num_entries;
+} oe_get_lock_profile_args_t;
+
+/**
+ * Get the lock contention profile of an enclave.
+ *
+ * Copies up to *num_entries entries into **entries** and sets *num_entries to
+ * the number of entries the enclave has. Entries are copied while other
+ * threads may update them, so a profile taken while the enclave is busy is
+ * not a consistent snapshot.
+ *
+ * @retval OE_OK All entries were copied.
+ * @retval OE_BUFFER_TOO_SMALL **entries** was too small (or null).
+ * @retval OE_UNSUPPORTED The enclave was built without USE_LOCK_PROFILING.
+ */
+oe_result_t oe_get_lock_profile(
+    oe_enclave_t* enclave,
+    oe_lock_profile_entry_t* entries,
+    size_t* num_entries);
+
+/**
+ * Print the lock contention profile of an enclave to stderr, most waited-on
+ * locks first, with the call sites resolved to function names.
+ */
+oe_result_t oe_print_lock_profile(oe_enclave_t* enclave);
+
+OE_EXTERNC_END
+
+#endif /* _OE_INTERNAL_LOCKPROFILE_H */
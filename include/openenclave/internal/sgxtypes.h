@@ -548,7 +548,9 @@ oe_thread_data_t* oe_get_thread_data(void);
 
 #define TD_MAGIC 0xc90afe906c5d19a3
 
-#define OE_THREAD_LOCAL_SPACE (3304)
+/* The rest of the td_t page, which holds the thread-local variables of the
+ * enclave. Adding fields to td_t lowers it; note that in CHANGELOG.md */
+#define OE_THREAD_LOCAL_SPACE (3200)
 
 typedef struct _callsite Callsite;
 
@@ -602,6 +604,33 @@ typedef struct _td
     oe_tls_atexit_t* tls_atexit_functions;
     uint64_t num_tls_atexit_functions;
 
+    /* Untrusted scratch region used for OCALL marshaling (see scratch.c) */
+    uint64_t scratch_base;
+    uint64_t scratch_size;
+    uint64_t scratch_used;
+
+    /* Untrusted queue of deferred OCALLs (see scratch.c) */
+    uint64_t deferred_queue;
+    uint64_t deferred_size;
+    uint64_t deferred_used;
+
+    /* Buffer reused to marshal the outermost ECALL (see calls.c) */
+    uint8_t* marshal_buffer;
+    uint64_t marshal_buffer_size;
+    uint64_t marshal_buffer_small_calls;
+
+    /* Per-thread cache of the untrusted heap (see hostheap.c) */
+    struct _oe_host_heap_cache* host_heap_cache;
+
+    /* Whether the thread is on the wait queue of a mutex (see thread.c) */
+    uint64_t mutex_queued;
+
+    /* Index (plus one) of the thread's line in the rwlock reader table */
+    uint64_t rwlock_reader_line;
+
+    /* Per-thread cache of the thread-caching allocator (see threadcache.c) */
+    struct _oe_malloc_cache* malloc_cache;
+
     /* Reserved for thread-local variables. */
     uint8_t thread_local_data[OE_THREAD_LOCAL_SPACE];
 } td_t;
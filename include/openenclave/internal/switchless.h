@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _OE_SWITCHLESS_H
+#define _OE_SWITCHLESS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/types.h>
+#include <openenclave/internal/calls.h>
+
+OE_EXTERNC_BEGIN
+
+/*
+**==============================================================================
+**
+** Switchless OCALLs
+**
+**     The host starts a number of worker threads when the enclave is created.
+**     Each worker owns one slot in an array (the ring) that lives in host
+**     memory. An enclave thread performs an OCALL without exiting by:
+**
+**         (1) Claiming a free slot (FREE -> RESERVED)
+**         (2) Filling in the call arguments and posting it (-> POSTED)
+**         (3) Spinning until the worker picks it up (POSTED -> RUNNING)
+**         (4) Waiting until the worker completes it (RUNNING -> DONE)
+**         (5) Reading the results and releasing the slot (DONE -> FREE)
+**
+**     If no slot is free, or no worker picks up the call within
+**     OE_SWITCHLESS_PICKUP_SPIN_COUNT iterations, the enclave retracts the
+**     call (POSTED -> FREE) and performs a regular OCALL instead. Once picked
+**     up, the call cannot be retracted, so a caller that has spun for
+**     OE_SWITCHLESS_COMPLETION_SPIN_COUNT iterations gives up its CPU with
+**     sleep OCALLs between polls, as an idle worker does.
+**
+** Switchless ECALLs
+**
+**     The host also starts a number of enclave worker threads. Each one
+**     performs a single OE_ECALL_SWITCHLESS_WORKER that occupies a TCS and
+**     polls one ECALL slot. Host threads post ECALLs to these slots with the
+**     same protocol as above. To stop a worker, the host moves its slot from
+**     FREE to STOP, after which the worker returns from its ECALL.
+**
+**==============================================================================
+*/
+
+#define OE_SWITCHLESS_SLOT_FREE 0
+#define OE_SWITCHLESS_SLOT_RESERVED 1
+#define OE_SWITCHLESS_SLOT_POSTED 2
+#define OE_SWITCHLESS_SLOT_RUNNING 3
+#define OE_SWITCHLESS_SLOT_DONE 4
+#define OE_SWITCHLESS_SLOT_STOP 5
+
+/* Maximum number of host worker threads per enclave */
+#define OE_SWITCHLESS_MAX_HOST_WORKERS 64
+
+/* Iterations a caller waits for a worker to pick up a call */
+#define OE_SWITCHLESS_PICKUP_SPIN_COUNT 8192
+
+/* Iterations a caller spins for a running call before it sleeps */
+#define OE_SWITCHLESS_COMPLETION_SPIN_COUNT 16384
+
+/* Sleep OCALLs of 0 ms a caller makes before it sleeps for 1 ms at a time */
+#define OE_SWITCHLESS_COMPLETION_YIELD_COUNT 64
+
+/* Idle iterations after which a worker starts yielding its CPU */
+#define OE_SWITCHLESS_WORKER_SPIN_COUNT 16384
+
+/* Slots are cache-line aligned so that workers do not share lines */
+typedef struct _oe_switchless_slot
+{
+    /* One of the OE_SWITCHLESS_SLOT_* states */
+    volatile uint64_t state;
+
+    /* The transport result of the call (set by the worker) */
+    volatile oe_result_t result;
+
+    /* The arguments of the call (filled in by the enclave) */
+    oe_call_host_function_args_t args;
+} OE_ALIGNED(64) oe_switchless_slot_t;
+
+/* Slot polled by an enclave worker (filled in by the host) */
+typedef struct _oe_switchless_ecall_slot
+{
+    /* One of the OE_SWITCHLESS_SLOT_* states */
+    volatile uint64_t state;
+
+    /* The transport result of the call (set by the worker) */
+    volatile oe_result_t result;
+
+    /* The arguments of the call (filled in by the host) */
+    oe_call_enclave_function_args_t args;
+} OE_ALIGNED(64) oe_switchless_ecall_slot_t;
+
+/*
+**==============================================================================
+**
+** oe_init_switchless_args_t
+**
+**     Arguments of OE_ECALL_INIT_SWITCHLESS. Describes the ring of slots
+**     serviced by the host workers.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_init_switchless_args
+{
+    oe_switchless_slot_t* slots;
+    uint64_t num_slots;
+} oe_init_switchless_args_t;
+
+OE_EXTERNC_END
+
+#endif /* _OE_SWITCHLESS_H */
@@ -7,6 +7,7 @@
 #include <openenclave/bits/defs.h>
 #include <openenclave/bits/result.h>
 #include <openenclave/bits/types.h>
+#include <openenclave/internal/defs.h>
 
 /*
 **==============================================================================
@@ -22,6 +23,54 @@ typedef struct _oe_thread_wake_wait_args
     const void* self_tcs;
 } oe_thread_wake_wait_args_t;
 
+/*
+**==============================================================================
+**
+** oe_thread_wait_timeout_args_t
+**
+**     Wait for an event on the given TCS until the deadline (in nanoseconds
+**     since the Epoch, on the host's realtime clock). The host sets result to
+**     OE_OK if the thread was woken and to OE_TIMEDOUT otherwise.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_wait_timeout_args
+{
+    const void* tcs;
+    uint64_t deadline;
+    oe_result_t result;
+} oe_thread_wait_timeout_args_t;
+
+/*
+**==============================================================================
+**
+** oe_thread_wake_multiple_args_t
+**
+**     Wake the threads waiting on each of the given TCSs with a single OCALL.
+**
+**==============================================================================
+*/
+
+typedef struct _oe_thread_wake_multiple_args
+{
+    uint64_t num_tcs;
+    OE_ZERO_SIZED_ARRAY const void* tcs[];
+} oe_thread_wake_multiple_args_t;
+
+/*
+**==============================================================================
+**
+** OE_OCALL_THREAD_CREATE
+**
+**     Ask the host to start a thread that performs OE_ECALL_THREAD_START with
+**     the given start identifier (arg_in). The host sets arg_out to the
+**     oe_result_t of starting the thread. The host thread retries the ECALL
+**     until a TCS is free.
+**
+**==============================================================================
+*/
+
 #ifdef _OE_ENCLAVE_H
 OE_EXTERNC_BEGIN
 
@@ -161,7 +210,8 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock);
  * A thread calls this function to acquire a lock on a spin lock. If
  * another thread has already acquired a lock, the calling thread spins
  * until the lock is available. If more than one thread is waiting on the
- * spin lock, the selection of the next thread to obtain the lock is arbitrary.
+ * spin lock, they obtain the lock in the order in which they called this
+ * function.
  *
  * @param spinlock Lock this spin lock.
  *
@@ -171,6 +221,22 @@ oe_result_t oe_spin_init(oe_spinlock_t* spinlock);
  */
 oe_result_t oe_spin_lock(oe_spinlock_t* spinlock);
 
+/**
+ * Try to acquire a lock on a spin lock.
+ *
+ * A thread calls this function to acquire a lock on a spin lock without
+ * spinning. The call fails if the lock is held or other threads are waiting
+ * for it.
+ *
+ * @param spinlock Lock this spin lock.
+ *
+ * @return OE_OK the operation was successful
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the lock is held or other threads are waiting for it
+ *
+ */
+oe_result_t oe_spin_trylock(oe_spinlock_t* spinlock);
+
 /**
  * Release the lock on a spin lock.
  *
@@ -202,7 +268,7 @@ oe_result_t oe_spin_destroy(oe_spinlock_t* spinlock);
  */
 typedef struct _oe_mutex
 {
-    uint64_t __impl[4]; /**< Internal private implementation */
+    uint64_t __impl[5]; /**< Internal private implementation */
 } oe_mutex_t;
 
 /**
@@ -336,6 +402,32 @@ oe_result_t oe_cond_init(oe_cond_t* cond);
  */
 oe_result_t oe_cond_wait(oe_cond_t* cond, oe_mutex_t* mutex);
 
+/**
+ * Wait on a condition variable until a deadline.
+ *
+ * This function behaves like oe_cond_wait(), except that it stops waiting
+ * once **deadline** has passed. In either case, the thread acquires the mutex
+ * again before it returns.
+ *
+ * In enclaves, this function performs an OCALL, where the thread waits to be
+ * signaled or for the deadline to pass.
+ *
+ * @param cond Wait on this condition variable.
+ * @param mutex This mutex must be locked by the caller.
+ * @param deadline Absolute time in nanoseconds since the Epoch (UTC), on the
+ * realtime clock of the host.
+ *
+ * @return OE_OK the thread was signaled
+ * @return OE_TIMEDOUT the deadline passed before the thread was signaled
+ * @return OE_INVALID_PARAMETER one or more parameters is invalid
+ * @return OE_BUSY the mutex is not locked by the calling thread.
+ *
+ */
+oe_result_t oe_cond_timedwait(
+    oe_cond_t* cond,
+    oe_mutex_t* mutex,
+    uint64_t deadline);
+
 /**
  * Signal a thread waiting on a condition variable.
  *
@@ -393,7 +485,7 @@ oe_result_t oe_cond_destroy(oe_cond_t* cond);
  */
 typedef struct _oe_rwlock
 {
-    uint64_t __impl[5]; /**< Internal private implementation */
+    uint64_t __impl[6]; /**< Internal private implementation */
 } oe_rwlock_t;
 
 /**
@@ -638,6 +730,33 @@ oe_result_t oe_thread_setspecific(oe_thread_key_t key, const void* value);
  */
 void* oe_thread_getspecific(oe_thread_key_t key);
 
+/**
+ * Start a new enclave thread.
+ *
+ * This function asks the host to start a thread that enters the enclave and
+ * runs **start** with the given argument on a free TCS. The thread exits the
+ * enclave once **start** returns. If all TCSs are busy, the thread enters the
+ * enclave as soon as one is released.
+ *
+ * If **start** never runs because the host gave up on the thread, for
+ * example when the enclave is terminated while all TCSs are busy, **cancel**
+ * is called with the argument instead when the enclave is terminated.
+ *
+ * @param start The function run by the new thread.
+ * @param cancel The function called if **start** never runs (may be null).
+ * @param arg The argument passed to **start** or **cancel**.
+ *
+ * @return OE_OK the host started the thread
+ * @return OE_INVALID_PARAMETER **start** is null
+ * @return OE_OUT_OF_MEMORY insufficient memory exists to start the thread
+ * @return OE_FAILURE the host failed to start the thread
+ *
+ */
+oe_result_t oe_thread_start(
+    void (*start)(void* arg),
+    void (*cancel)(void* arg),
+    void* arg);
+
 OE_EXTERNC_END
 
 #endif //_OE_ENCLAVE_H
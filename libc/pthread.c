@@ -45,6 +45,8 @@ OE_INLINE int _to_errno(oe_result_t result)
             return EPERM;
         case OE_OUT_OF_MEMORY:
             return ENOMEM;
+        case OE_TIMEDOUT:
+            return ETIMEDOUT;
         default:
             return EINVAL; /* unreachable */
     }
@@ -87,6 +89,10 @@ pthread_t __pthread_self()
 
     struct __pthread* self = (struct __pthread*)td->pthread;
 
+    /* Threads started by pthread_create() use the control block instead */
+    if (self->self)
+        return self->self;
+
     return self;
 }
 
@@ -104,6 +110,176 @@ void oe_register_pthread_hooks(oe_pthread_hooks_t* pthread_hooks)
     _pthread_hooks = pthread_hooks;
 }
 
+/*
+**==============================================================================
+**
+** Default pthread_create(), pthread_join() and pthread_detach()
+**
+**     Unless the application registers its own hooks, threads are started
+**     with oe_thread_start(), which asks the host for a thread that enters
+**     the enclave on a free TCS. The pthread_t of such a thread points to a
+**     control block that starts with a struct __pthread; pthread_self()
+**     returns it while the thread runs. The block is released by
+**     pthread_join(), or by the thread itself once it is detached. Thread
+**     attributes are ignored. A thread the host never ran is finished by the
+**     enclave destructor with the result PTHREAD_CANCELED.
+**
+**     All blocks share one mutex, so a joiner never frees a block that the
+**     exiting thread still accesses.
+**
+**==============================================================================
+*/
+
+typedef struct _thread_block
+{
+    /* Must be first: the pthread_t of the thread points here */
+    struct __pthread pthread;
+
+    /* Signaled when the thread has returned (protected by _thread_lock) */
+    oe_cond_t cond;
+    bool done;
+    bool detached;
+    bool joining;
+} thread_block_t;
+
+static oe_mutex_t _thread_lock = OE_MUTEX_INITIALIZER;
+
+static void _free_thread_block(thread_block_t* block)
+{
+    oe_cond_destroy(&block->cond);
+    oe_free(block);
+}
+
+/* Mark the thread done, then wake its joiner or release a detached block */
+static void _thread_done(thread_block_t* block)
+{
+    bool detached;
+
+    oe_mutex_lock(&_thread_lock);
+    {
+        block->done = true;
+        detached = block->detached;
+
+        if (!detached)
+            oe_cond_broadcast(&block->cond);
+    }
+    oe_mutex_unlock(&_thread_lock);
+
+    if (detached)
+        _free_thread_block(block);
+}
+
+static void _thread_start(void* arg)
+{
+    thread_block_t* block = (thread_block_t*)arg;
+    struct __pthread* self = (struct __pthread*)oe_get_td()->pthread;
+
+    self->self = &block->pthread;
+    block->pthread.result = block->pthread.start(block->pthread.start_arg);
+    self->self = NULL;
+
+    _thread_done(block);
+}
+
+static void _thread_cancel(void* arg)
+{
+    thread_block_t* block = (thread_block_t*)arg;
+
+    block->pthread.result = PTHREAD_CANCELED;
+    _thread_done(block);
+}
+
+static int _pthread_create(
+    pthread_t* thread,
+    void* (*start_routine)(void*),
+    void* arg)
+{
+    thread_block_t* block;
+
+    if (!thread || !start_routine)
+        return EINVAL;
+
+    if (!(block = (thread_block_t*)oe_calloc(1, sizeof(thread_block_t))))
+        return ENOMEM;
+
+    block->pthread.self = &block->pthread;
+    block->pthread.locale = C_LOCALE;
+    block->pthread.start = start_routine;
+    block->pthread.start_arg = arg;
+    oe_cond_init(&block->cond);
+
+    /* The thread may exit before the call returns; it does not free the
+     * block until the thread is joined or detached */
+    *thread = &block->pthread;
+
+    if (oe_thread_start(_thread_start, _thread_cancel, block) != OE_OK)
+    {
+        _free_thread_block(block);
+        return EAGAIN;
+    }
+
+    return 0;
+}
+
+static int _pthread_join(pthread_t thread, void** retval)
+{
+    thread_block_t* block = (thread_block_t*)thread;
+
+    if (!block)
+        return ESRCH;
+
+    if (thread == __pthread_self())
+        return EDEADLK;
+
+    oe_mutex_lock(&_thread_lock);
+    {
+        if (block->detached || block->joining)
+        {
+            oe_mutex_unlock(&_thread_lock);
+            return EINVAL;
+        }
+
+        block->joining = true;
+
+        while (!block->done)
+            oe_cond_wait(&block->cond, &_thread_lock);
+    }
+    oe_mutex_unlock(&_thread_lock);
+
+    if (retval)
+        *retval = block->pthread.result;
+
+    _free_thread_block(block);
+    return 0;
+}
+
+static int _pthread_detach(pthread_t thread)
+{
+    thread_block_t* block = (thread_block_t*)thread;
+    bool done;
+
+    if (!block)
+        return ESRCH;
+
+    oe_mutex_lock(&_thread_lock);
+    {
+        if (block->detached || block->joining)
+        {
+            oe_mutex_unlock(&_thread_lock);
+            return EINVAL;
+        }
+
+        block->detached = true;
+        done = block->done;
+    }
+    oe_mutex_unlock(&_thread_lock);
+
+    if (done)
+        _free_thread_block(block);
+
+    return 0;
+}
+
 int pthread_create(
     pthread_t* thread,
     const pthread_attr_t* attr,
@@ -111,10 +287,7 @@ int pthread_create(
     void* arg)
 {
     if (!_pthread_hooks || !_pthread_hooks->create)
-    {
-        oe_assert("pthread_create(): panic" == NULL);
-        return -1;
-    }
+        return _pthread_create(thread, start_routine, arg);
 
     return _pthread_hooks->create(thread, attr, start_routine, arg);
 }
@@ -122,10 +295,7 @@ int pthread_create(
 int pthread_join(pthread_t thread, void** retval)
 {
     if (!_pthread_hooks || !_pthread_hooks->join)
-    {
-        assert("pthread_join(): panic" == NULL);
-        return -1;
-    }
+        return _pthread_join(thread, retval);
 
     return _pthread_hooks->join(thread, retval);
 }
@@ -133,10 +303,7 @@ int pthread_join(pthread_t thread, void** retval)
 int pthread_detach(pthread_t thread)
 {
     if (!_pthread_hooks || !_pthread_hooks->detach)
-    {
-        assert("pthread_detach(): panic" == NULL);
-        return -1;
-    }
+        return _pthread_detach(thread);
 
     return _pthread_hooks->detach(thread);
 }
@@ -173,6 +340,11 @@ int pthread_spin_lock(pthread_spinlock_t* spinlock)
     return _to_errno(oe_spin_lock((oe_spinlock_t*)spinlock));
 }
 
+int pthread_spin_trylock(pthread_spinlock_t* spinlock)
+{
+    return _to_errno(oe_spin_trylock((oe_spinlock_t*)spinlock));
+}
+
 int pthread_spin_unlock(pthread_spinlock_t* spinlock)
 {
     return _to_errno(oe_spin_unlock((oe_spinlock_t*)spinlock));
@@ -296,11 +468,23 @@ int pthread_cond_timedwait(
     pthread_mutex_t* mutex,
     const struct timespec* ts)
 {
-    OE_UNUSED(cond);
-    OE_UNUSED(mutex);
-    OE_UNUSED(ts);
-    assert("pthread_cond_timedwait(): panic" == NULL);
-    return -1;
+    uint64_t deadline = 0;
+
+    if (!ts || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000)
+        return EINVAL;
+
+    /* A deadline before the Epoch has passed already */
+    if (ts->tv_sec > 0)
+    {
+        if ((uint64_t)ts->tv_sec > OE_UINT64_MAX / 1000000000 - 1)
+            deadline = OE_UINT64_MAX;
+        else
+            deadline = (uint64_t)ts->tv_sec * 1000000000 +
+                       (uint64_t)ts->tv_nsec;
+    }
+
+    return _to_errno(
+        oe_cond_timedwait((oe_cond_t*)cond, (oe_mutex_t*)mutex, deadline));
 }
 
 int pthread_cond_signal(pthread_cond_t* cond)
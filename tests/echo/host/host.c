@@ -34,9 +34,19 @@ int main(int argc, const char* argv[])
     }
 
     const uint32_t flags = oe_get_create_flags();
+    oe_enclave_setting_call_stats_t call_stats = {false};
+    oe_enclave_setting_t setting;
+
+    setting.setting_type = OE_ENCLAVE_SETTING_CALL_STATS;
+    setting.u.call_stats = &call_stats;
 
     if ((result = oe_create_echo_enclave(
-             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave)) != OE_OK)
+             argv[1],
+             OE_ENCLAVE_TYPE_SGX,
+             flags,
+             &setting,
+             sizeof(setting),
+             &enclave)) != OE_OK)
         oe_put_err("oe_create_enclave(): result=%u", result);
 
     char out_parameter[100];
@@ -53,6 +63,38 @@ int main(int argc, const char* argv[])
     if (strcmp("Hello World", out_parameter) != 0)
         oe_put_err("ecall failed: %s != %s\n", "Hello World", out_parameter);
 
+    /* Check the statistics of the ECALL and of the OCALL it made */
+    {
+        oe_call_stats_t stats;
+        uint64_t histogram_count = 0;
+
+        result = oe_get_enclave_call_stats(
+            enclave, OE_CALL_STATS_ECALL, fcn_id_enc_echo, &stats);
+        OE_TEST(result == OE_OK);
+        OE_TEST(stats.count == 1);
+        OE_TEST(stats.total_time == stats.max_time);
+
+        for (size_t i = 0; i < OE_CALL_STATS_NUM_BUCKETS; i++)
+            histogram_count += stats.histogram[i];
+
+        OE_TEST(histogram_count == 1);
+
+        /* The ECALL was made by function id, not by ecall table index */
+        result = oe_get_enclave_call_stats(
+            enclave, OE_CALL_STATS_LEGACY_ECALL, 0, &stats);
+        OE_TEST(result == OE_OK);
+        OE_TEST(stats.count == 0);
+
+        result = oe_get_enclave_call_stats(
+            enclave, OE_CALL_STATS_OCALL, fcn_id_host_echo, &stats);
+        OE_TEST(result == OE_OK);
+        OE_TEST(stats.count == 1);
+
+        result = oe_get_enclave_call_stats(
+            enclave, OE_CALL_STATS_OCALL, fcn_id_host_echo + 1, &stats);
+        OE_TEST(result == OE_INVALID_PARAMETER);
+    }
+
     result = oe_terminate_enclave(enclave);
     OE_TEST(result == OE_OK);
 
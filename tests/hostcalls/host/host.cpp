@@ -181,6 +181,31 @@ static void _test_host_strndup(oe_enclave_t* enclave)
     OE_TEST(test_host_free(enclave, out_str) == OE_OK);
 }
 
+static void _test_host_heap_growth(oe_enclave_t* enclave)
+{
+    const size_t count = 64;
+    const size_t size = 4096;
+    void_ptr ptrs[count];
+
+    /* Allocate more than one region worth of blocks */
+    for (size_t i = 0; i < count; i++)
+    {
+        OE_TEST(test_host_malloc(enclave, size, &ptrs[i]) == OE_OK);
+        OE_TEST(ptrs[i] != NULL);
+        memset(ptrs[i], (int)i, size);
+    }
+
+    /* Blocks must not overlap */
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t* bytes = (uint8_t*)ptrs[i];
+        OE_TEST(bytes[0] == (uint8_t)i && bytes[size - 1] == (uint8_t)i);
+    }
+
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(test_host_free(enclave, ptrs[i]) == OE_OK);
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -205,6 +230,29 @@ int main(int argc, const char* argv[])
 
     oe_terminate_enclave(enclave);
 
+    /* Repeat with the untrusted heap, using the smallest region size */
+    oe_enclave_setting_host_heap_t host_heap_setting = {1};
+    oe_enclave_setting_t setting;
+    setting.setting_type = OE_ENCLAVE_SETTING_HOST_HEAP;
+    setting.u.host_heap = &host_heap_setting;
+
+    if ((result = oe_create_hostcalls_enclave(
+             argv[1],
+             OE_ENCLAVE_TYPE_SGX,
+             flags,
+             &setting,
+             sizeof(setting),
+             &enclave)) != OE_OK)
+        oe_put_err("oe_create_enclave(): result=%u", result);
+
+    _test_host_malloc(enclave);
+    _test_host_calloc(enclave);
+    _test_host_realloc(enclave);
+    _test_host_strndup(enclave);
+    _test_host_heap_growth(enclave);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
     printf("=== passed all tests (%s)\n", argv[0]);
 
     return 0;
@@ -116,6 +116,22 @@ OE_ECALL void TestMyOCall(void* args_)
         oe_result_t result = oe_call_host("my_ocall", a);
         OE_TEST(result == OE_OK);
         args->result = a->out;
+
+        /* Call my_ocall() again through a handle */
+        oe_host_function_handle_t handle = 0;
+        result = oe_get_host_function_handle("my_ocall", &handle);
+        OE_TEST(result == OE_OK);
+        OE_TEST(handle != 0);
+
+        for (uint64_t i = 0; i < 3; i++)
+        {
+            a->in = i;
+            a->out = 0;
+            result = oe_call_host_by_handle(handle, a);
+            OE_TEST(result == OE_OK);
+            OE_TEST(a->out == i * 7);
+        }
+
         oe_host_free(a);
     }
 
@@ -146,6 +162,16 @@ OE_ECALL void TestOCallEdgeCases(void* args_)
     /* OCALL doesn't exist. */
     result = oe_call_host("B", NULL);
     OE_TEST(result == OE_NOT_FOUND);
+
+    /* Handle of an OCALL that doesn't exist. */
+    oe_host_function_handle_t handle = 1;
+    result = oe_get_host_function_handle("B", &handle);
+    OE_TEST(result == OE_NOT_FOUND);
+    OE_TEST(handle == 0);
+
+    /* Invalid handle. */
+    result = oe_call_host_by_handle(0, NULL);
+    OE_TEST(result == OE_INVALID_PARAMETER);
 }
 
 OE_ECALL void test_callback(void* arg)
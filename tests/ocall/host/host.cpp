@@ -105,6 +105,32 @@ int main(int argc, const char* argv[])
         OE_TEST(args.out == args.in);
     }
 
+    /* Call Test2() by handle */
+    {
+        oe_enclave_function_handle_t handle = 0;
+        OE_TEST(
+            oe_get_enclave_function_handle(enclave, "Test2", &handle) ==
+            OE_OK);
+        OE_TEST(handle != 0);
+
+        for (int i = 0; i < 3; i++)
+        {
+            Test2Args args;
+            args.in = 1000 + i;
+            args.out = 0;
+            OE_TEST(oe_call_enclave_by_handle(enclave, handle, &args) == OE_OK);
+            OE_TEST(args.out == args.in);
+        }
+
+        OE_TEST(
+            oe_get_enclave_function_handle(enclave, "Test", &handle) ==
+            OE_NOT_FOUND);
+        OE_TEST(handle == 0);
+        OE_TEST(
+            oe_call_enclave_by_handle(enclave, 0, NULL) ==
+            OE_INVALID_PARAMETER);
+    }
+
     /* Call Test4() */
     {
         oe_result_t result = oe_call_enclave(enclave, "Test4", NULL);
@@ -129,6 +129,24 @@ void ecall_string_fun7(char* s1, char* s2)
     OE_TEST(s2 == NULL);
 }
 
+// Replace the first character of s with '#'
+static void _mark_string(char* s)
+{
+    OE_TEST(oe_is_within_enclave(s, strlen(s) + 1));
+    OE_TEST(s[0] == 'H');
+    s[0] = '#';
+}
+
+void ecall_string_fun8(char* s)
+{
+    _mark_string(s);
+}
+
+void ecall_string_fun9(char* s)
+{
+    _mark_string(s);
+}
+
 void test_wstring_edl_ocalls()
 {
     const wchar_t* str_value = L"Hello, World\n";
@@ -3,6 +3,7 @@
 
 #include "../edltestutils.h"
 
+#include <openenclave/edger8r/host.h>
 #include <openenclave/host.h>
 #include <openenclave/internal/tests.h>
 #include <wchar.h>
@@ -41,6 +42,24 @@ void test_string_edl_ecalls(oe_enclave_t* enclave)
     // Multiple string params. One null.
     OE_TEST(ecall_string_fun7(enclave, str, NULL) == OE_OK);
 
+    // Marshaling buffer on the stack, in the thread's buffer (too large for
+    // the stack) and on the heap.
+    {
+        static char large[2 * OE_EDGER8R_MAX_STACK_BUFFER_SIZE];
+
+        sprintf(str, "%s", str_value);
+        OE_TEST(ecall_string_fun8(enclave, str) == OE_OK);
+        OE_TEST(strcmp(str, "#ello, World\n") == 0);
+
+        memset(large, 'H', sizeof(large) - 1);
+        OE_TEST(ecall_string_fun8(enclave, large) == OE_OK);
+        OE_TEST(large[0] == '#' && large[1] == 'H');
+
+        sprintf(str, "%s", str_value);
+        OE_TEST(ecall_string_fun9(enclave, str) == OE_OK);
+        OE_TEST(strcmp(str, "#ello, World\n") == 0);
+    }
+
     printf("=== test_string_edl_ecalls passed\n");
 }
 
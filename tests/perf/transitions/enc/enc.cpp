@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/enclavelibc.h>
+#include <openenclave/internal/tests.h>
+#include "transitions_t.h"
+
+void enc_empty()
+{
+}
+
+void enc_ocall_empty(uint64_t iterations)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+        OE_TEST(host_empty() == OE_OK);
+}
+
+void enc_nested(uint64_t depth)
+{
+    if (depth > 1)
+        OE_TEST(host_nested(depth - 1) == OE_OK);
+}
+
+void enc_in(unsigned char* buffer, size_t size)
+{
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+}
+
+void enc_out(unsigned char* buffer, size_t size)
+{
+    oe_memset(buffer, 0xAA, size);
+}
+
+void enc_ocall_in(size_t size, uint64_t iterations)
+{
+    unsigned char* buffer = NULL;
+
+    if (size)
+    {
+        OE_TEST((buffer = (unsigned char*)oe_malloc(size)) != NULL);
+        oe_memset(buffer, 0x55, size);
+    }
+
+    for (uint64_t i = 0; i < iterations; i++)
+        OE_TEST(host_in(buffer, size) == OE_OK);
+
+    oe_free(buffer);
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    2048, /* HeapPageCount */
+    64,   /* StackPageCount */
+    32);  /* TCSCount */
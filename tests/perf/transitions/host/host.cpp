@@ -0,0 +1,397 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/types.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "transitions_u.h"
+
+/*
+**==============================================================================
+**
+** Transition microbenchmarks
+**
+**     Every benchmark times each operation individually on one or more host
+**     threads and reports the mean latency, the throughput of all threads
+**     together and latency percentiles as JSON. OCALL round trips are timed
+**     on the host between consecutive entries of the OCALL function, so they
+**     cover exactly one exit and one re-entry of the enclave.
+**
+**     Usage: transitions_host ENCLAVE_PATH [--quick] [--output FILE]
+**
+**     --quick divides all iteration counts by 1000 (ctest uses it to check
+**     that every benchmark runs).
+**
+**==============================================================================
+*/
+
+typedef std::vector<uint64_t> samples_t;
+
+struct result_t
+{
+    std::string name;
+    size_t threads;
+    size_t payload;
+    uint64_t iterations;
+    double ns_per_op;
+    double ops_per_sec;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t max;
+};
+
+static oe_enclave_t* _enclave;
+static bool _quick;
+static std::vector<result_t> _results;
+
+static const size_t _payloads[] = {0, 64, 4096, 1024 * 1024};
+static const size_t _thread_counts[] = {1, 2, 4, 8, 16, 32};
+/* Number of ECALLs in a chain (depth 2 is ECALL -> OCALL -> ECALL) */
+static const uint64_t _depths[] = {2, 4, 8};
+
+static uint64_t _now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static uint64_t _iterations(uint64_t n)
+{
+    return _quick ? std::max<uint64_t>(n / 1000, 10) : n;
+}
+
+/* Payloads are copied in full, so larger ones get fewer iterations */
+static uint64_t _payload_iterations(size_t payload)
+{
+    if (payload >= 1024 * 1024)
+        return _iterations(200);
+
+    if (payload >= 4096)
+        return _iterations(20000);
+
+    return _iterations(100000);
+}
+
+/* Time each call of op() */
+template <typename OP>
+static void _time_each(uint64_t iterations, samples_t& samples, OP op)
+{
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        uint64_t start = _now();
+        op();
+        samples.push_back(_now() - start);
+    }
+}
+
+/* Run body(iterations, samples) on each of num_threads threads */
+template <typename BODY>
+static void _run(
+    const char* name,
+    size_t num_threads,
+    size_t payload,
+    uint64_t iterations,
+    BODY body)
+{
+    std::vector<samples_t> thread_samples(num_threads);
+    std::vector<std::thread> threads;
+    samples_t samples;
+    result_t result;
+    uint64_t start;
+    uint64_t elapsed;
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < num_threads; i++)
+        thread_samples[i].reserve(iterations);
+
+    start = _now();
+
+    for (size_t i = 0; i < num_threads; i++)
+        threads.emplace_back(
+            [&, i]() { body(iterations, thread_samples[i]); });
+
+    for (auto& thread : threads)
+        thread.join();
+
+    elapsed = _now() - start;
+
+    for (auto& s : thread_samples)
+        samples.insert(samples.end(), s.begin(), s.end());
+
+    OE_TEST(!samples.empty());
+    std::sort(samples.begin(), samples.end());
+
+    for (uint64_t sample : samples)
+        total += sample;
+
+    result.name = name;
+    result.threads = num_threads;
+    result.payload = payload;
+    result.iterations = samples.size();
+    result.ns_per_op = (double)total / (double)samples.size();
+    result.ops_per_sec = (double)samples.size() * 1e9 / (double)elapsed;
+    result.p50 = samples[(samples.size() - 1) * 50 / 100];
+    result.p90 = samples[(samples.size() - 1) * 90 / 100];
+    result.p99 = samples[(samples.size() - 1) * 99 / 100];
+    result.max = samples.back();
+
+    _results.push_back(result);
+
+    fprintf(
+        stderr,
+        "%-16s threads=%-2zu payload=%-7zu %10.1f ns/op\n",
+        name,
+        num_threads,
+        payload,
+        result.ns_per_op);
+}
+
+/*
+**==============================================================================
+**
+** OCALLs
+**
+**==============================================================================
+*/
+
+static thread_local samples_t* _ocall_samples;
+static thread_local uint64_t _last_ocall;
+
+/* Record the time since the previous OCALL of this thread */
+static void _record_ocall()
+{
+    uint64_t now = _now();
+
+    if (_last_ocall)
+        _ocall_samples->push_back(now - _last_ocall);
+
+    _last_ocall = now;
+}
+
+void host_empty()
+{
+    _record_ocall();
+}
+
+void host_in(unsigned char* buffer, size_t size)
+{
+    OE_UNUSED(buffer);
+    OE_UNUSED(size);
+    _record_ocall();
+}
+
+void host_nested(uint64_t depth)
+{
+    OE_TEST(enc_nested(_enclave, depth) == OE_OK);
+}
+
+/* Let the enclave make iterations + 1 OCALLs and keep the intervals */
+template <typename ECALL>
+static void _time_ocalls(uint64_t iterations, samples_t& samples, ECALL ecall)
+{
+    _ocall_samples = &samples;
+    _last_ocall = 0;
+
+    OE_TEST(ecall(iterations + 1) == OE_OK);
+
+    _ocall_samples = NULL;
+}
+
+/*
+**==============================================================================
+**
+** Benchmarks
+**
+**==============================================================================
+*/
+
+static void _run_benchmarks()
+{
+    for (size_t threads : _thread_counts)
+    {
+        _run(
+            "ecall_empty",
+            threads,
+            0,
+            _iterations(100000),
+            [](uint64_t n, samples_t& samples) {
+                _time_each(n, samples, []() {
+                    OE_TEST(enc_empty(_enclave) == OE_OK);
+                });
+            });
+    }
+
+    for (size_t threads : _thread_counts)
+    {
+        _run(
+            "ocall_empty",
+            threads,
+            0,
+            _iterations(100000),
+            [](uint64_t n, samples_t& samples) {
+                _time_ocalls(n, samples, [](uint64_t count) {
+                    return enc_ocall_empty(_enclave, count);
+                });
+            });
+    }
+
+    for (uint64_t depth : _depths)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "nested_depth_%llu", OE_LLU(depth));
+
+        _run(
+            name,
+            1,
+            0,
+            _iterations(20000),
+            [depth](uint64_t n, samples_t& samples) {
+                _time_each(n, samples, [depth]() {
+                    OE_TEST(enc_nested(_enclave, depth) == OE_OK);
+                });
+            });
+    }
+
+    for (size_t payload : _payloads)
+    {
+        std::vector<unsigned char> buffer(payload ? payload : 1, 0x11);
+        unsigned char* data = buffer.data();
+
+        _run(
+            "ecall_in",
+            1,
+            payload,
+            _payload_iterations(payload),
+            [data, payload](uint64_t n, samples_t& samples) {
+                _time_each(n, samples, [data, payload]() {
+                    OE_TEST(enc_in(_enclave, data, payload) == OE_OK);
+                });
+            });
+
+        _run(
+            "ecall_out",
+            1,
+            payload,
+            _payload_iterations(payload),
+            [data, payload](uint64_t n, samples_t& samples) {
+                _time_each(n, samples, [data, payload]() {
+                    OE_TEST(enc_out(_enclave, data, payload) == OE_OK);
+                });
+            });
+
+        _run(
+            "ocall_in",
+            1,
+            payload,
+            _payload_iterations(payload),
+            [payload](uint64_t n, samples_t& samples) {
+                _time_ocalls(n, samples, [payload](uint64_t count) {
+                    return enc_ocall_in(_enclave, payload, count);
+                });
+            });
+    }
+}
+
+static void _write_json(FILE* os, uint32_t flags)
+{
+    bool simulate = (flags & OE_ENCLAVE_FLAG_SIMULATE) != 0;
+
+    fprintf(os, "{\n");
+    fprintf(os, "  \"benchmark\": \"transitions\",\n");
+    fprintf(os, "  \"mode\": \"%s\",\n", simulate ? "simulation" : "hardware");
+    fprintf(os, "  \"quick\": %s,\n", _quick ? "true" : "false");
+    fprintf(os, "  \"results\": [\n");
+
+    for (size_t i = 0; i < _results.size(); i++)
+    {
+        const result_t& r = _results[i];
+
+        fprintf(
+            os,
+            "    {\"name\": \"%s\", \"threads\": %zu, \"payload\": %zu, "
+            "\"iterations\": %llu, \"ns_per_op\": %.1f, "
+            "\"ops_per_sec\": %.1f, \"p50_ns\": %llu, \"p90_ns\": %llu, "
+            "\"p99_ns\": %llu, \"max_ns\": %llu}%s\n",
+            r.name.c_str(),
+            r.threads,
+            r.payload,
+            OE_LLU(r.iterations),
+            r.ns_per_op,
+            r.ops_per_sec,
+            OE_LLU(r.p50),
+            OE_LLU(r.p90),
+            OE_LLU(r.p99),
+            OE_LLU(r.max),
+            i + 1 < _results.size() ? "," : "");
+    }
+
+    fprintf(os, "  ]\n");
+    fprintf(os, "}\n");
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    const char* output = NULL;
+    FILE* os = stdout;
+
+    if (argc < 2)
+    {
+        fprintf(
+            stderr,
+            "Usage: %s ENCLAVE_PATH [--quick] [--output FILE]\n",
+            argv[0]);
+        return 1;
+    }
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            _quick = true;
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            fprintf(stderr, "%s: unknown option: %s\n", argv[0], argv[i]);
+            return 1;
+        }
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    if ((result = oe_create_transitions_enclave(
+             argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &_enclave)) !=
+        OE_OK)
+    {
+        fprintf(stderr, "%s: cannot create enclave: %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    _run_benchmarks();
+
+    OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+
+    if (output && !(os = fopen(output, "w")))
+    {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], output);
+        return 1;
+    }
+
+    _write_json(os, flags);
+
+    if (os != stdout)
+        fclose(os);
+
+    fprintf(stderr, "=== passed all tests (transitions)\n");
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include "switchless_t.h"
+
+int enc_echo_regular(const char* in, char out[100], int repeats)
+{
+    char buf[100];
+
+    for (int i = 0; i < repeats; i++)
+    {
+        int ret = 0;
+        OE_TEST(host_echo_regular(&ret, in, buf) == OE_OK);
+        OE_TEST(ret == 0);
+        OE_TEST(strcmp(in, buf) == 0);
+    }
+
+    strcpy(out, buf);
+    return 0;
+}
+
+int enc_echo_switchless(const char* in, char out[100], int repeats)
+{
+    char buf[100];
+
+    for (int i = 0; i < repeats; i++)
+    {
+        int ret = 0;
+        OE_TEST(host_echo_switchless(&ret, in, buf) == OE_OK);
+        OE_TEST(ret == 0);
+        OE_TEST(strcmp(in, buf) == 0);
+    }
+
+    strcpy(out, buf);
+    return 0;
+}
+
+int enc_call_deferred(int count, int check_every, bool switchless)
+{
+    for (int i = 0; i < count; i++)
+    {
+        OE_TEST(host_deferred(i) == OE_OK);
+
+        if (check_every && (i + 1) % check_every == 0)
+        {
+            int received = -1;
+
+            /* A synchronous OCALL runs the queued calls first */
+            if (switchless)
+                OE_TEST(host_get_num_deferred_switchless(&received) == OE_OK);
+            else
+                OE_TEST(host_get_num_deferred(&received) == OE_OK);
+
+            OE_TEST(received == i + 1);
+        }
+    }
+
+    return 0;
+}
+
+int enc_add_regular(int a, int b)
+{
+    return a + b;
+}
+
+int enc_add_switchless(int a, int b)
+{
+    return a + b;
+}
+
+OE_SET_ENCLAVE_SGX(
+    1,    /* ProductID */
+    1,    /* SecurityVersion */
+    true, /* AllowDebug */
+    1024, /* HeapPageCount */
+    1024, /* StackPageCount */
+    4);   /* TCSCount */
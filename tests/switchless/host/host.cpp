@@ -0,0 +1,342 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/host.h>
+#include <openenclave/host.h>
+#include <openenclave/internal/switchless.h>
+#include <openenclave/internal/tests.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "switchless_u.h"
+
+#define NUM_HOST_WORKERS 2
+#define NUM_ENCLAVE_WORKERS 1
+#define NUM_REPEATS 10000
+
+int host_echo_regular(const char* in, char out[100])
+{
+    strcpy(out, in);
+    return 0;
+}
+
+int host_echo_switchless(const char* in, char out[100])
+{
+    strcpy(out, in);
+    return 0;
+}
+
+static std::atomic<int> _num_deferred;
+
+void host_deferred(int value)
+{
+    /* Deferred calls arrive in order */
+    OE_TEST(value == _num_deferred);
+    _num_deferred++;
+}
+
+int host_get_num_deferred()
+{
+    return _num_deferred;
+}
+
+int host_get_num_deferred_switchless()
+{
+    return _num_deferred;
+}
+
+static double _run_deferred_ocalls(
+    oe_enclave_t* enclave,
+    int check_every,
+    bool switchless)
+{
+    int ret = -1;
+
+    _num_deferred = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    OE_TEST(
+        enc_call_deferred(
+            enclave, &ret, NUM_REPEATS, check_every, switchless) == OE_OK);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    OE_TEST(ret == 0);
+
+    /* The remaining calls ran when the ECALL returned */
+    OE_TEST(_num_deferred == NUM_REPEATS);
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double _run_ocalls(oe_enclave_t* enclave, bool switchless)
+{
+    char out[100];
+    int ret = -1;
+    oe_result_t result;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (switchless)
+        result = enc_echo_switchless(
+            enclave, &ret, "switchless", out, NUM_REPEATS);
+    else
+        result = enc_echo_regular(enclave, &ret, "regular", out, NUM_REPEATS);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    OE_TEST(result == OE_OK);
+    OE_TEST(ret == 0);
+    OE_TEST(strcmp(out, switchless ? "switchless" : "regular") == 0);
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double _run_ecalls(oe_enclave_t* enclave, bool switchless)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < NUM_REPEATS; i++)
+    {
+        int ret = -1;
+
+        if (switchless)
+            OE_TEST(enc_add_switchless(enclave, &ret, i, 1) == OE_OK);
+        else
+            OE_TEST(enc_add_regular(enclave, &ret, i, 1) == OE_OK);
+
+        OE_TEST(ret == i + 1);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double _run_batched_ecalls(oe_enclave_t* enclave)
+{
+    static enc_add_regular_args_t calls[NUM_REPEATS];
+
+    for (int i = 0; i < NUM_REPEATS; i++)
+    {
+        calls[i].a = i;
+        calls[i].b = 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    OE_TEST(enc_add_regular_batch(enclave, calls, NUM_REPEATS) == OE_OK);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < NUM_REPEATS; i++)
+    {
+        OE_TEST(calls[i]._result == OE_OK);
+        OE_TEST(calls[i]._retval == i + 1);
+    }
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void _test_batch_marshaling(oe_enclave_t* enclave)
+{
+    const char* strings[] = {"a", "batched", "echo"};
+    char outs[OE_COUNTOF(strings)][100];
+    enc_echo_regular_args_t calls[OE_COUNTOF(strings)];
+
+    for (size_t i = 0; i < OE_COUNTOF(strings); i++)
+    {
+        calls[i].in = (char*)strings[i];
+        calls[i].out = outs[i];
+        calls[i].repeats = 1;
+    }
+
+    OE_TEST(enc_echo_regular_batch(enclave, calls, OE_COUNTOF(calls)) == OE_OK);
+
+    for (size_t i = 0; i < OE_COUNTOF(strings); i++)
+    {
+        OE_TEST(calls[i]._result == OE_OK);
+        OE_TEST(calls[i]._retval == 0);
+        OE_TEST(strcmp(outs[i], strings[i]) == 0);
+    }
+
+    /* An empty batch does not enter the enclave */
+    OE_TEST(enc_add_regular_batch(enclave, NULL, 0) == OE_OK);
+    OE_TEST(oe_call_enclave_function_batch(enclave, NULL, 1) != OE_OK);
+}
+
+static std::atomic<int> _num_async_completed;
+
+static void _on_add_completed(enc_add_regular_args_t* call, void* arg)
+{
+    OE_TEST(call->_result == OE_OK);
+    OE_TEST(call->_retval == call->a + call->b);
+    OE_TEST(arg == &_num_async_completed);
+    _num_async_completed++;
+}
+
+static void _test_async_calls(oe_enclave_t* enclave, bool terminate)
+{
+    const char* string = "asynchronous echo";
+    char out[100] = {0};
+    enc_echo_regular_args_t echo_call;
+    static enc_add_regular_args_t add_calls[64];
+    oe_async_call_t* handle = NULL;
+    size_t output_bytes_written = 0;
+
+    /* Wait for a call through its handle */
+    echo_call.in = (char*)string;
+    echo_call.out = out;
+    echo_call.repeats = 1;
+    OE_TEST(enc_echo_regular_async(enclave, &echo_call, NULL, NULL, &handle) ==
+            OE_OK);
+    OE_TEST(oe_async_call_wait(handle, &output_bytes_written) == OE_OK);
+    OE_TEST(oe_async_call_is_complete(handle));
+    OE_TEST(output_bytes_written > 0);
+    OE_TEST(echo_call._result == OE_OK);
+    OE_TEST(echo_call._retval == 0);
+    OE_TEST(strcmp(out, string) == 0);
+
+    /* Waiting again returns the same outcome */
+    OE_TEST(oe_async_call_wait(handle, NULL) == OE_OK);
+    oe_async_call_free(handle);
+
+    /* Detached calls report their completion through the callback */
+    _num_async_completed = 0;
+
+    for (int i = 0; i < (int)OE_COUNTOF(add_calls); i++)
+    {
+        add_calls[i].a = i;
+        add_calls[i].b = 2;
+        OE_TEST(
+            enc_add_regular_async(
+                enclave,
+                &add_calls[i],
+                _on_add_completed,
+                &_num_async_completed,
+                NULL) == OE_OK);
+    }
+
+    /* Terminating the enclave completes the queued calls first */
+    if (terminate)
+        OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    while (_num_async_completed != (int)OE_COUNTOF(add_calls))
+        std::this_thread::yield();
+
+    OE_TEST(
+        oe_call_enclave_function_async(
+            NULL, 0, NULL, 0, NULL, 0, NULL, NULL, NULL) ==
+        OE_INVALID_PARAMETER);
+}
+
+int main(int argc, const char* argv[])
+{
+    oe_result_t result;
+    oe_enclave_t* enclave = NULL;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    const uint32_t flags = oe_get_create_flags();
+
+    /* Without workers, switchless calls fall back to regular calls */
+    result = oe_create_switchless_enclave(
+        argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave);
+    OE_TEST(result == OE_OK);
+    _run_ocalls(enclave, true);
+    _run_ecalls(enclave, true);
+    _test_batch_marshaling(enclave);
+    _run_deferred_ocalls(enclave, 7, false);
+    _run_deferred_ocalls(enclave, 7, true);
+    _test_async_calls(enclave, true);
+
+    /* Reject malformed settings */
+    oe_enclave_setting_switchless_t too_many_host_workers = {
+        OE_SWITCHLESS_MAX_HOST_WORKERS + 1, 0};
+    oe_enclave_setting_switchless_t too_many_enclave_workers = {0, 4};
+    oe_enclave_setting_t bad_setting;
+    bad_setting.setting_type = OE_ENCLAVE_SETTING_SWITCHLESS;
+
+    bad_setting.u.switchless = &too_many_host_workers;
+    result = oe_create_switchless_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_SGX,
+        flags,
+        &bad_setting,
+        sizeof(bad_setting),
+        &enclave);
+    OE_TEST(result == OE_INVALID_PARAMETER);
+
+    /* The enclave only has 4 TCSs */
+    bad_setting.u.switchless = &too_many_enclave_workers;
+    result = oe_create_switchless_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_SGX,
+        flags,
+        &bad_setting,
+        sizeof(bad_setting),
+        &enclave);
+    OE_TEST(result == OE_INVALID_PARAMETER);
+
+    /* Create the enclave with host and enclave workers */
+    oe_enclave_setting_switchless_t switchless_setting = {NUM_HOST_WORKERS,
+                                                          NUM_ENCLAVE_WORKERS};
+    oe_enclave_setting_t setting;
+    setting.setting_type = OE_ENCLAVE_SETTING_SWITCHLESS;
+    setting.u.switchless = &switchless_setting;
+
+    result = oe_create_switchless_enclave(
+        argv[1],
+        OE_ENCLAVE_TYPE_SGX,
+        flags,
+        &setting,
+        sizeof(setting),
+        &enclave);
+    OE_TEST(result == OE_OK);
+
+    double regular = _run_ocalls(enclave, false);
+    double switchless = _run_ocalls(enclave, true);
+    double deferred = _run_deferred_ocalls(enclave, 0, false);
+
+    printf(
+        "%d regular OCALLs: %.2f ms, %d switchless OCALLs: %.2f ms, "
+        "%d deferred OCALLs: %.2f ms\n",
+        NUM_REPEATS,
+        regular,
+        NUM_REPEATS,
+        switchless,
+        NUM_REPEATS,
+        deferred);
+
+    /* Switchless OCALLs also run the queued calls first */
+    _run_deferred_ocalls(enclave, 7, true);
+
+    regular = _run_ecalls(enclave, false);
+    switchless = _run_ecalls(enclave, true);
+    double batched = _run_batched_ecalls(enclave);
+
+    printf(
+        "%d regular ECALLs: %.2f ms, %d switchless ECALLs: %.2f ms, "
+        "%d batched ECALLs: %.2f ms\n",
+        NUM_REPEATS,
+        regular,
+        NUM_REPEATS,
+        switchless,
+        NUM_REPEATS,
+        batched);
+
+    /* The pool leaves the TCSs of the enclave workers alone */
+    _test_async_calls(enclave, false);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (switchless)\n");
+
+    return 0;
+}
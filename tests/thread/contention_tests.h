@@ -0,0 +1,36 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifndef _contention_tests_h
+#define _contention_tests_h
+
+#include <openenclave/bits/types.h>
+
+// Number of host threads contending for one enclave mutex.
+const size_t NUM_CONTENTION_THREADS = 16;
+
+// Lock/unlock pairs performed by each thread in a single ECALL.
+const size_t CONTENTION_ITERS = 20000;
+
+// Number of ECALLs made by each thread.
+const size_t CONTENTION_ECALLS = 10;
+
+// Read lock/unlock pairs performed by each thread in a single ECALL.
+const size_t RWLOCK_SCALING_ITERS = 20000;
+
+// Maximum number of host threads contending for one enclave spinlock.
+const size_t SPINLOCK_SCALING_THREADS = 32;
+
+// Lock/unlock pairs of a spinlock performed by each thread in a single ECALL.
+const size_t SPINLOCK_SCALING_ITERS = 20000;
+
+// Maximum number of host threads allocating in the enclave at once.
+const size_t MALLOC_SCALING_THREADS = 16;
+
+// Rounds of allocations performed by each thread in a single ECALL.
+const size_t MALLOC_SCALING_ITERS = 2000;
+
+// Blocks allocated, reallocated and freed by each round.
+const size_t MALLOC_SCALING_BLOCKS = 16;
+
+#endif /* _contention_tests_h */
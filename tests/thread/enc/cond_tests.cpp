@@ -8,6 +8,8 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
+#include <openenclave/internal/time.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "thread_t.h"
@@ -105,3 +107,36 @@ void cb_test_signal_thread_impl()
     // from either of the calls and then check the exit_thread flag and quit.
     oe_mutex_unlock(&mutex);
 }
+
+// Wait on a condition variable that is never signaled.
+void enc_test_cond_timedwait()
+{
+    static oe_mutex_t timed_mutex = OE_MUTEX_INITIALIZER;
+    static oe_cond_t timed_cond = OE_COND_INITIALIZER;
+    const uint64_t timeout_ms = 50;
+    uint64_t start = oe_get_time();
+    uint64_t deadline = (start + timeout_ms) * 1000000;
+
+    OE_TEST(oe_mutex_lock(&timed_mutex) == 0);
+
+#ifdef _PTHREAD_ENC_
+    struct timespec ts;
+    ts.tv_sec = (time_t)(deadline / 1000000000);
+    ts.tv_nsec = (long)(deadline % 1000000000);
+    OE_TEST(
+        pthread_cond_timedwait(&timed_cond, &timed_mutex, &ts) == ETIMEDOUT);
+#else
+    OE_TEST(
+        oe_cond_timedwait(&timed_cond, &timed_mutex, deadline) == OE_TIMEDOUT);
+#endif
+
+    OE_TEST(oe_get_time() >= start + timeout_ms);
+
+    // The thread holds the mutex again and has left the queue.
+    OE_TEST(oe_mutex_unlock(&timed_mutex) == 0);
+#ifdef _PTHREAD_ENC_
+    OE_TEST(pthread_cond_destroy(&timed_cond) == 0);
+#else
+    OE_TEST(oe_cond_destroy(&timed_cond) == OE_OK);
+#endif
+}
@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#ifdef _PTHREAD_ENC_
+#include "thread.h"
+#endif
+
+#include <openenclave/enclave.h>
+#include <openenclave/internal/malloc.h>
+#include <openenclave/internal/tests.h>
+#include <openenclave/internal/thread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../contention_tests.h"
+#include "thread_t.h"
+
+static oe_mutex_t contention_mutex = OE_MUTEX_INITIALIZER;
+static size_t contention_count = 0;
+
+static oe_rwlock_t scaling_rwlock = OE_RWLOCK_INITIALIZER;
+static volatile size_t scaling_data = 0;
+
+static oe_spinlock_t scaling_spinlock = OE_SPINLOCK_INITIALIZER;
+static size_t spinlock_count = 0;
+
+// Repeatedly take a mutex shared by all threads. A thread that finds the
+// mutex held spins for a while; only if it is still held does the thread
+// block in the host (thread wait OCALL) until the owner wakes it on unlock
+// (thread wake OCALL).
+void enc_contention_loop(size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+    {
+        OE_TEST(oe_mutex_lock(&contention_mutex) == 0);
+        contention_count++;
+        OE_TEST(oe_mutex_unlock(&contention_mutex) == 0);
+    }
+}
+
+size_t enc_contention_count()
+{
+    size_t count;
+
+    OE_TEST(oe_mutex_lock(&contention_mutex) == 0);
+    count = contention_count;
+    OE_TEST(oe_mutex_unlock(&contention_mutex) == 0);
+
+    return count;
+}
+
+// Repeatedly take a read lock shared by all threads. While no writer takes
+// the lock, readers only touch their own line of the reader table.
+void enc_rwlock_read_loop(size_t iterations)
+{
+    size_t sum = 0;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        OE_TEST(oe_rwlock_rdlock(&scaling_rwlock) == 0);
+        sum += scaling_data;
+        OE_TEST(oe_rwlock_unlock(&scaling_rwlock) == 0);
+    }
+
+    OE_TEST(sum == 0);
+}
+
+// Repeatedly take a spinlock shared by all threads. Waiters take a ticket
+// and are served in order, pausing in proportion to their place in line.
+void enc_spinlock_loop(size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+    {
+        OE_TEST(oe_spin_lock(&scaling_spinlock) == 0);
+        spinlock_count++;
+        OE_TEST(oe_spin_unlock(&scaling_spinlock) == 0);
+    }
+}
+
+size_t enc_spinlock_count()
+{
+    size_t count;
+
+    OE_TEST(oe_spin_trylock(&scaling_spinlock) == 0);
+    OE_TEST(oe_spin_trylock(&scaling_spinlock) != 0);
+    count = spinlock_count;
+    OE_TEST(oe_spin_unlock(&scaling_spinlock) == 0);
+
+    return count;
+}
+
+// Allocate, grow and free blocks of mixed sizes, as containers do. With the
+// thread-caching allocator, small blocks come from the caller's TCS cache.
+void enc_malloc_loop(size_t iterations)
+{
+    unsigned char* blocks[MALLOC_SCALING_BLOCKS];
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        for (size_t j = 0; j < MALLOC_SCALING_BLOCKS; j++)
+        {
+            size_t size = (size_t)16 << (j % 9);
+
+            OE_TEST((blocks[j] = (unsigned char*)malloc(size)) != NULL);
+            memset(blocks[j], (int)j, size);
+        }
+
+        for (size_t j = 0; j < MALLOC_SCALING_BLOCKS; j++)
+        {
+            size_t size = (size_t)16 << (j % 9);
+
+            blocks[j] = (unsigned char*)realloc(blocks[j], size * 2 + 1);
+            OE_TEST(blocks[j] != NULL);
+            OE_TEST(blocks[j][0] == (unsigned char)j);
+            OE_TEST(blocks[j][size - 1] == (unsigned char)j);
+        }
+
+        for (size_t j = 0; j < MALLOC_SCALING_BLOCKS; j++)
+            free(blocks[j]);
+    }
+}
+
+void enc_malloc_check_stats()
+{
+    oe_malloc_stats_t stats;
+
+    OE_TEST(oe_get_malloc_stats(&stats) == OE_OK);
+    OE_TEST(stats.in_use_bytes > 0);
+    OE_TEST(stats.in_use_bytes <= stats.system_bytes);
+    OE_TEST(stats.system_bytes <= stats.peak_system_bytes);
+}
@@ -9,6 +9,8 @@
 #include <openenclave/enclave.h>
 #include <openenclave/internal/tests.h>
 #include <openenclave/internal/thread.h>
+#include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <atomic>
@@ -55,6 +57,40 @@ void enc_test_mutex()
     oe_host_printf("enc_test_mutex: %lld\n", OE_LLU(oe_thread_self()));
 }
 
+static oe_mutex_t trylock_mutex = OE_MUTEX_INITIALIZER;
+
+static void* _trylock_thread(void* arg)
+{
+    OE_UNUSED(arg);
+
+    // The mutex is held by the creating thread
+    OE_TEST(oe_mutex_trylock(&trylock_mutex) != 0);
+    return NULL;
+}
+
+void enc_test_mutex_trylock()
+{
+    pthread_t thread;
+
+    OE_TEST(oe_mutex_trylock(&trylock_mutex) == 0);
+
+    // Recursive trylock and lock increase the reference count
+    OE_TEST(oe_mutex_trylock(&trylock_mutex) == 0);
+    OE_TEST(oe_mutex_lock(&trylock_mutex) == 0);
+
+    OE_TEST(pthread_create(&thread, NULL, _trylock_thread, NULL) == 0);
+    OE_TEST(pthread_join(thread, NULL) == 0);
+
+    OE_TEST(oe_mutex_unlock(&trylock_mutex) == 0);
+    OE_TEST(oe_mutex_unlock(&trylock_mutex) == 0);
+    OE_TEST(oe_mutex_unlock(&trylock_mutex) == 0);
+    OE_TEST(oe_mutex_unlock(&trylock_mutex) != 0);
+
+    // Once released, the mutex can be obtained again
+    OE_TEST(oe_mutex_trylock(&trylock_mutex) == 0);
+    OE_TEST(oe_mutex_unlock(&trylock_mutex) == 0);
+}
+
 static void _test_mutex1(size_t* count)
 {
     OE_TEST(oe_mutex_lock(&mutex1) == 0);
@@ -271,6 +307,79 @@ void enc_lock_and_unlock_mutexes(const char* mutex_ids)
     }
 }
 
+// test_thread_create
+#define NUM_CREATED_THREADS 8
+
+struct created_thread
+{
+    size_t value;
+    pthread_t self;
+};
+
+static std::atomic<size_t> g_created_thread_count(0);
+static std::atomic<bool> g_detached_thread_go(false);
+
+static void* _created_thread(void* arg)
+{
+    created_thread* thread = (created_thread*)arg;
+
+    thread->self = pthread_self();
+    OE_TEST(pthread_join(thread->self, NULL) == EDEADLK);
+    ++g_created_thread_count;
+
+    return (void*)(thread->value * 2);
+}
+
+static void* _detached_thread(void* arg)
+{
+    OE_UNUSED(arg);
+
+    while (!g_detached_thread_go)
+        ;
+
+    ++g_created_thread_count;
+    return NULL;
+}
+
+// Start threads with the default pthread_create() and join them
+void enc_test_thread_create()
+{
+    created_thread threads[NUM_CREATED_THREADS];
+    pthread_t handles[NUM_CREATED_THREADS];
+    pthread_t detached;
+
+    g_created_thread_count = 0;
+
+    for (size_t i = 0; i < NUM_CREATED_THREADS; i++)
+    {
+        threads[i].value = i + 1;
+        threads[i].self = 0;
+        OE_TEST(
+            pthread_create(
+                &handles[i], NULL, _created_thread, &threads[i]) == 0);
+    }
+
+    for (size_t i = 0; i < NUM_CREATED_THREADS; i++)
+    {
+        void* retval = NULL;
+
+        OE_TEST(pthread_join(handles[i], &retval) == 0);
+        OE_TEST((size_t)retval == threads[i].value * 2);
+        OE_TEST(pthread_equal(threads[i].self, handles[i]));
+        OE_TEST(!pthread_equal(threads[i].self, pthread_self()));
+    }
+
+    OE_TEST(g_created_thread_count == NUM_CREATED_THREADS);
+
+    // A detached thread releases itself when it returns
+    OE_TEST(pthread_create(&detached, NULL, _detached_thread, NULL) == 0);
+    OE_TEST(pthread_detach(detached) == 0);
+    g_detached_thread_go = true;
+
+    while (g_created_thread_count != NUM_CREATED_THREADS + 1)
+        ;
+}
+
 // test_tcs_exhaustion
 static std::atomic<size_t> g_tcs_used_thread_count(0);
 
@@ -306,4 +415,4 @@ OE_SET_ENCLAVE_SGX(
     true, /* AllowDebug */
     128,  /* HeapPageCount */
     16,   /* StackPageCount */
-    16);  /* TCSCount */
+    48);  /* TCSCount (more than the former limit of 32) */
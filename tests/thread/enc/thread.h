@@ -27,11 +27,13 @@ typedef pthread_t oe_thread_t;
 typedef pthread_mutex_t oe_mutex_t;
 #define OE_MUTEX_INITIALIZER __mutex_initializer_recursive()
 #define oe_mutex_lock pthread_mutex_lock
+#define oe_mutex_trylock pthread_mutex_trylock
 #define oe_mutex_unlock pthread_mutex_unlock
 
 typedef pthread_spinlock_t oe_spinlock_t;
 #define OE_SPINLOCK_INITIALIZER 0
 #define oe_spin_lock pthread_spin_lock
+#define oe_spin_trylock pthread_spin_trylock
 #define oe_spin_unlock pthread_spin_unlock
 
 typedef pthread_cond_t oe_cond_t;
@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <openenclave/host.h>
+#include <openenclave/internal/error.h>
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "../contention_tests.h"
+#include "thread_u.h"
+
+// The host wrapper of an ECALL that runs a benchmark loop in the enclave.
+typedef oe_result_t (*loop_ecall_t)(oe_enclave_t* enclave, size_t iterations);
+
+static void contention_thread(
+    oe_enclave_t* enclave,
+    loop_ecall_t ecall,
+    size_t iterations)
+{
+    for (size_t i = 0; i < CONTENTION_ECALLS; i++)
+    {
+        OE_TEST(ecall(enclave, iterations) == OE_OK);
+    }
+}
+
+// Make CONTENTION_ECALLS calls of the given ECALL from each of num_threads
+// host threads at once and return the elapsed time in seconds.
+static double run_contention(
+    oe_enclave_t* enclave,
+    size_t num_threads,
+    loop_ecall_t ecall,
+    size_t iterations)
+{
+    std::vector<std::thread> threads;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        threads.push_back(
+            std::thread(contention_thread, enclave, ecall, iterations));
+    }
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        threads[i].join();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Benchmark an enclave mutex contended by an increasing number of host
+// threads. Short critical sections are mostly handed over while waiters
+// spin; longer waits turn lock and unlock into thread wait and wake OCALLs.
+void test_mutex_contention(oe_enclave_t* enclave)
+{
+    size_t expected = 0;
+    size_t count = 0;
+
+    printf("test_mutex_contention Starting\n");
+
+    for (size_t n = 1; n <= NUM_CONTENTION_THREADS; n *= 2)
+    {
+        double seconds =
+            run_contention(enclave, n, enc_contention_loop, CONTENTION_ITERS);
+        size_t ops = n * CONTENTION_ECALLS * CONTENTION_ITERS;
+
+        expected += ops;
+
+        printf(
+            "test_mutex_contention: threads=%zu lock/unlock=%zu "
+            "seconds=%.3f ops/sec=%.0f\n",
+            n,
+            ops,
+            seconds,
+            (double)ops / seconds);
+    }
+
+    // No increment may be lost under contention.
+    OE_TEST(enc_contention_count(enclave, &count) == OE_OK);
+    OE_TEST(count == expected);
+
+    printf("test_mutex_contention Complete\n");
+}
+
+// Benchmark read locks of an enclave rwlock taken by an increasing number of
+// host threads. With reader-biased locking the throughput should grow with
+// the number of threads instead of collapsing on a shared counter.
+void test_rwlock_scaling(oe_enclave_t* enclave)
+{
+    printf("test_rwlock_scaling Starting\n");
+
+    for (size_t n = 1; n <= NUM_CONTENTION_THREADS; n *= 2)
+    {
+        double seconds = run_contention(
+            enclave, n, enc_rwlock_read_loop, RWLOCK_SCALING_ITERS);
+        size_t ops = n * CONTENTION_ECALLS * RWLOCK_SCALING_ITERS;
+
+        printf(
+            "test_rwlock_scaling: threads=%zu rdlock/unlock=%zu "
+            "seconds=%.3f ops/sec=%.0f\n",
+            n,
+            ops,
+            seconds,
+            (double)ops / seconds);
+    }
+
+    printf("test_rwlock_scaling Complete\n");
+}
+
+// Benchmark an enclave spinlock contended by 1 to 32 host threads (each on
+// its own TCS). A ticket lock hands the lock over in arrival order, so the
+// throughput should level off rather than collapse as threads are added.
+void test_spinlock_scaling(oe_enclave_t* enclave)
+{
+    size_t expected = 0;
+    size_t count = 0;
+
+    printf("test_spinlock_scaling Starting\n");
+
+    for (size_t n = 1; n <= SPINLOCK_SCALING_THREADS; n *= 2)
+    {
+        double seconds = run_contention(
+            enclave, n, enc_spinlock_loop, SPINLOCK_SCALING_ITERS);
+        size_t ops = n * CONTENTION_ECALLS * SPINLOCK_SCALING_ITERS;
+
+        expected += ops;
+
+        printf(
+            "test_spinlock_scaling: threads=%zu lock/unlock=%zu "
+            "seconds=%.3f ops/sec=%.0f\n",
+            n,
+            ops,
+            seconds,
+            (double)ops / seconds);
+    }
+
+    // No increment may be lost under contention.
+    OE_TEST(enc_spinlock_count(enclave, &count) == OE_OK);
+    OE_TEST(count == expected);
+
+    printf("test_spinlock_scaling Complete\n");
+}
+
+// Benchmark malloc/realloc/free in the enclave from 1 to 16 host threads
+// (each on its own TCS). With the thread-caching allocator, each thread is
+// served from its TCS cache and the throughput should grow with the threads.
+void test_malloc_scaling(oe_enclave_t* enclave)
+{
+    printf("test_malloc_scaling Starting\n");
+
+    for (size_t n = 1; n <= MALLOC_SCALING_THREADS; n *= 2)
+    {
+        double seconds = run_contention(
+            enclave, n, enc_malloc_loop, MALLOC_SCALING_ITERS);
+        size_t ops = n * CONTENTION_ECALLS * MALLOC_SCALING_ITERS *
+                     MALLOC_SCALING_BLOCKS;
+
+        printf(
+            "test_malloc_scaling: threads=%zu malloc/realloc/free=%zu "
+            "seconds=%.3f ops/sec=%.0f\n",
+            n,
+            ops,
+            seconds,
+            (double)ops / seconds);
+    }
+
+    OE_TEST(enc_malloc_check_stats(enclave) == OE_OK);
+
+    printf("test_malloc_scaling Complete\n");
+}
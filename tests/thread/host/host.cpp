@@ -3,6 +3,7 @@
 
 #include <openenclave/host.h>
 #include <openenclave/internal/error.h>
+#include <openenclave/internal/lockprofile.h>
 #include <openenclave/internal/tests.h>
 #include <atomic>
 #include <cassert>
@@ -211,6 +212,11 @@ void test_thread_locking_patterns(oe_enclave_t* enclave)
 
 void test_readers_writer_lock(oe_enclave_t* enclave);
 
+void test_mutex_contention(oe_enclave_t* enclave);
+void test_rwlock_scaling(oe_enclave_t* enclave);
+void test_spinlock_scaling(oe_enclave_t* enclave);
+void test_malloc_scaling(oe_enclave_t* enclave);
+
 // test_tcs_exhaustion
 static std::atomic<size_t> g_tcs_out_thread_count(0);
 
@@ -286,6 +292,41 @@ size_t host_tcs_out_thread_count()
     return g_tcs_out_thread_count;
 }
 
+// The enclave keeps a lock profile only when oecore is built with
+// USE_LOCK_PROFILING. test_mutex_contention() must have run before.
+void test_lock_profile(oe_enclave_t* enclave)
+{
+    size_t num_entries = 0;
+    oe_result_t result = oe_get_lock_profile(enclave, NULL, &num_entries);
+
+#if defined(OE_USE_LOCK_PROFILING)
+    OE_TEST(result == OE_BUFFER_TOO_SMALL);
+    OE_TEST(num_entries > 0);
+
+    std::vector<oe_lock_profile_entry_t> entries(num_entries);
+    result = oe_get_lock_profile(enclave, entries.data(), &num_entries);
+    OE_TEST(result == OE_OK);
+
+    uint64_t contended = 0;
+    for (size_t i = 0; i < num_entries; i++)
+    {
+        const oe_lock_profile_entry_t& entry = entries[i];
+
+        OE_TEST(entry.contended <= entry.acquisitions);
+        OE_TEST(entry.num_frames <= OE_LOCK_PROFILE_FRAMES);
+
+        if (entry.type == OE_LOCK_TYPE_MUTEX)
+            contended += entry.contended;
+    }
+
+    // The contention tests make many threads wait for one mutex
+    OE_TEST(contended > 0);
+    printf("test_lock_profile: %zu entries\n", num_entries);
+#else
+    OE_TEST(result == OE_UNSUPPORTED);
+#endif
+}
+
 int main(int argc, const char* argv[])
 {
     oe_result_t result;
@@ -308,16 +349,32 @@ int main(int argc, const char* argv[])
 
     test_mutex(enclave);
 
+    OE_TEST(enc_test_mutex_trylock(enclave) == OE_OK);
+
     test_cond(enclave);
 
     test_cond_broadcast(enclave);
 
+    OE_TEST(enc_test_cond_timedwait(enclave) == OE_OK);
+
+    OE_TEST(enc_test_thread_create(enclave) == OE_OK);
+
     test_thread_wake_wait(enclave);
 
     test_thread_locking_patterns(enclave);
 
     test_readers_writer_lock(enclave);
 
+    test_mutex_contention(enclave);
+
+    test_rwlock_scaling(enclave);
+
+    test_spinlock_scaling(enclave);
+
+    test_malloc_scaling(enclave);
+
+    test_lock_profile(enclave);
+
     test_tcs_exhaustion(enclave);
 
     if ((result = oe_terminate_enclave(enclave)) != OE_OK)
@@ -340,7 +340,7 @@ let get_cast_to_mem_expr (ptype, decl)=
 (*
    Prepare input_buffer
 *)
-let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:string) =
+let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_expr:string) =
   fprintf os "    /* Compute input buffer size. Include in and in-out parameters. */\n";
   fprintf os "    OE_ADD_SIZE(_input_buffer_size, sizeof(%s_args_t));\n" fd.Ast.fname;
   List.iter (fun (ptype, decl) ->
@@ -374,7 +374,7 @@ let oe_prepare_input_buffer (os:out_channel) (fd:Ast.func_decl) (alloc_func:stri
   fprintf os "    /* Allocate marshaling buffer */\n";
   fprintf os "    _total_buffer_size = _input_buffer_size;\n";
   fprintf os "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);\n\n";
-  fprintf os "    _buffer = (uint8_t*) %s(_total_buffer_size);\n" alloc_func;
+  fprintf os "    _buffer = (uint8_t*) %s;\n" alloc_expr;
   fprintf os "    _input_buffer = _buffer;\n";
   fprintf os "    _output_buffer = _buffer + _input_buffer_size;\n";
   fprintf os "    if (_buffer == NULL) { \n";
@@ -642,13 +642,56 @@ let gen_fill_marshal_struct (os:out_channel) (fd:Ast.func_decl)  (args:string) =
   ) fd.Ast.plist;
   fprintf os "\n"
 
-let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
+(* The size of the marshaling buffer of a function as a C constant
+ * expression, if the size of every in, out and in-out parameter is known at
+ * compile time. *)
+let oe_get_static_buffer_size (fd:Ast.func_decl) =
+  let is_const av = match av with Some (Ast.AString _) -> false | _ -> true in
+  let args_size = sprintf "sizeof(%s_args_t)" fd.Ast.fname in
+  let param_sizes = List.map (fun (ptype, decl) ->
+    match ptype with
+    | Ast.PTPtr (_, ptr_attr) when ptr_attr.Ast.pa_chkptr ->
+      let size = oe_get_param_size (ptype, decl, "_args.") in
+      let static = not ptr_attr.Ast.pa_isstr && not ptr_attr.Ast.pa_iswstr &&
+                   is_const ptr_attr.Ast.pa_size.Ast.ps_size &&
+                   is_const ptr_attr.Ast.pa_size.Ast.ps_count in
+      (match ptr_attr.Ast.pa_direction with
+       | Ast.PtrIn | Ast.PtrOut -> if static then Some [size] else None
+       | Ast.PtrInOut -> if static then Some [size; size] else None
+       | _ -> Some [])
+    | _ -> Some []
+  ) fd.Ast.plist in
+  if List.mem None param_sizes then None
+  else
+    let sizes = args_size :: args_size ::
+      List.concat (List.map (function Some l -> l | None -> []) param_sizes) in
+    Some (String.concat " + "
+      (List.map (sprintf "OE_EDGER8R_ALIGN_SIZE(%s)") sizes))
+
+let oe_get_host_ecall_function (os:out_channel) (tf:Ast.trusted_func) =
+  let fd = tf.Ast.tf_fdecl in
+  let static_size = oe_get_static_buffer_size fd in
+  let host_buffer =
+    match tf.Ast.tf_host_buffer, static_size with
+    | Ast.HB_DEFAULT, Some _ -> Ast.HB_STACK
+    | Ast.HB_DEFAULT, None -> Ast.HB_THREAD
+    | hb, _ -> hb
+  in
   fprintf os "%s" (oe_gen_wrapper_prototype fd true);
   fprintf os "\n";
   fprintf os "{\n";
   fprintf os "    oe_result_t _result = OE_FAILURE;\n\n";
   fprintf os "    /* Marshaling struct */ \n";
   fprintf os "    %s_args_t _args, *_pargs_in = NULL, *_pargs_out=NULL;\n\n" fd.Ast.fname;
+  (if host_buffer = Ast.HB_STACK then
+    begin
+    fprintf os "    /* Marshaling buffer on the stack (larger calls use the thread's buffer) */\n";
+    fprintf os "    oe_edger8r_buffer_unit_t _stack_buffer[OE_EDGER8R_STACK_BUFFER_UNITS(\n";
+    fprintf os "        %s)];\n\n"
+      (match static_size with
+       | Some size -> size
+       | None -> "OE_EDGER8R_MAX_STACK_BUFFER_SIZE")
+    end);
   fprintf os "    /* Marshaling buffer and sizes */ \n";
   fprintf os "    size_t _input_buffer_size = 0;\n";
   fprintf os "    size_t _output_buffer_size = 0;\n";
@@ -662,9 +705,18 @@ let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
   fprintf os "    /* Fill marshaling struct */\n";
   fprintf os "    memset(&_args, 0, sizeof(_args));\n";
   gen_fill_marshal_struct os fd "_args";
-  oe_prepare_input_buffer os fd "malloc";
+  oe_prepare_input_buffer os fd
+    (match host_buffer with
+     | Ast.HB_STACK ->
+       "(_total_buffer_size <= sizeof(_stack_buffer)\n" ^
+       "        ? (void*)_stack_buffer\n" ^
+       "        : oe_acquire_ecall_buffer(_total_buffer_size))"
+     | Ast.HB_THREAD -> "oe_acquire_ecall_buffer(_total_buffer_size)"
+     | _ -> "malloc(_total_buffer_size)");
   fprintf os "    /* Call enclave function */\n";
-  fprintf os "    if((_result = oe_call_enclave_function(\n";
+  fprintf os "    if((_result = %s(\n"
+    (if tf.Ast.tf_is_switchless then "oe_switchless_call_enclave_function"
+     else "oe_call_enclave_function");
   fprintf os "                        enclave,\n";
   fprintf os "                        %s,\n" (get_function_id fd);
   fprintf os "                        _input_buffer, _input_buffer_size,\n";
@@ -674,11 +726,221 @@ let oe_get_host_ecall_function (os:out_channel) (fd:Ast.func_decl) =
   oe_process_output_buffer os fd;
   fprintf os "    _result = OE_OK;\n";
   fprintf os "done:    \n";  
+  (match host_buffer with
+   | Ast.HB_STACK ->
+     fprintf os "    if (_buffer && _buffer != (uint8_t*)_stack_buffer)\n";
+     fprintf os "        oe_release_ecall_buffer(_buffer);\n"
+   | Ast.HB_THREAD ->
+     fprintf os "    if (_buffer)\n";
+     fprintf os "        oe_release_ecall_buffer(_buffer);\n"
+   | _ ->
+     fprintf os "    if (_buffer)\n";
+     fprintf os "        free(_buffer);\n");
+  fprintf os "    return _result;\n";
+  fprintf os "}\n\n"
+
+(* Prototype of the batch variant of an ecall wrapper *)
+let oe_gen_batch_wrapper_prototype (fd: Ast.func_decl) =
+  sprintf "oe_result_t %s_batch(\n        oe_enclave_t* enclave,\n        %s_args_t* _calls,\n        size_t _num_calls)"
+    fd.Ast.fname fd.Ast.fname
+
+(* Declare locals named after the parameters and load them from a call *)
+let oe_gen_batch_param_locals (os:out_channel) (fd: Ast.func_decl) =
+  let params = List.map conv_array_to_ptr fd.Ast.plist in
+  List.iter (fun (pt, decl) ->
+    fprintf os "    %s\n" (String.trim (mk_ms_member_decl pt decl false))
+  ) params;
+  List.iter (fun (_, decl) ->
+    fprintf os "    %s = _call->%s;\n" decl.Ast.identifier decl.Ast.identifier
+  ) params;
+  fprintf os "\n"
+
+(* Marshal one call of a batch into its own buffer *)
+let oe_gen_batch_prepare_function (os:out_channel) (fd: Ast.func_decl) =
+  fprintf os "static oe_result_t _%s_batch_prepare(\n" fd.Ast.fname;
+  fprintf os "        %s_args_t* _call,\n" fd.Ast.fname;
+  fprintf os "        oe_enclave_function_call_t* _entry)\n";
+  fprintf os "{\n";
+  fprintf os "    oe_result_t _result = OE_FAILURE;\n\n";
+  fprintf os "    /* Marshaling struct */ \n";
+  fprintf os "    %s_args_t _args, *_pargs_in = NULL;\n\n" fd.Ast.fname;
+  fprintf os "    /* Marshaling buffer and sizes */ \n";
+  fprintf os "    size_t _input_buffer_size = 0;\n";
+  fprintf os "    size_t _output_buffer_size = 0;\n";
+  fprintf os "    size_t _total_buffer_size = 0;\n";
+  fprintf os "    uint8_t* _buffer = NULL;\n";
+  fprintf os "    uint8_t* _input_buffer = NULL;\n";
+  fprintf os "    uint8_t* _output_buffer = NULL;\n";
+  fprintf os "    size_t _input_buffer_offset = 0;\n\n";
+  fprintf os "    /* Parameters of the call */\n";
+  oe_gen_batch_param_locals os fd;
+  fprintf os "    /* Fill marshaling struct */\n";
+  fprintf os "    memset(&_args, 0, sizeof(_args));\n";
+  gen_fill_marshal_struct os fd "_args";
+  oe_prepare_input_buffer os fd "malloc(_total_buffer_size)";
+  fprintf os "    /* The buffer is owned by the entry from now on */\n";
+  fprintf os "    _entry->function_id = %s;\n" (get_function_id fd);
+  fprintf os "    _entry->input_buffer = _input_buffer;\n";
+  fprintf os "    _entry->input_buffer_size = _input_buffer_size;\n";
+  fprintf os "    _entry->output_buffer = _output_buffer;\n";
+  fprintf os "    _entry->output_buffer_size = _output_buffer_size;\n";
+  fprintf os "    _buffer = NULL;\n\n";
+  fprintf os "    _result = OE_OK;\n";
+  fprintf os "done:\n";
   fprintf os "    if (_buffer)\n";
   fprintf os "        free(_buffer);\n";
   fprintf os "    return _result;\n";
   fprintf os "}\n\n"
 
+(* Unmarshal the outcome of one call of a batch *)
+let oe_gen_batch_complete_function (os:out_channel) (fd: Ast.func_decl) =
+  fprintf os "static oe_result_t _%s_batch_complete(\n" fd.Ast.fname;
+  fprintf os "        %s_args_t* _call,\n" fd.Ast.fname;
+  fprintf os "        const oe_enclave_function_call_t* _entry)\n";
+  fprintf os "{\n";
+  fprintf os "    oe_result_t _result = OE_FAILURE;\n\n";
+  fprintf os "    /* Marshaling struct */ \n";
+  fprintf os "    %s_args_t _args, *_pargs_out = NULL;\n\n" fd.Ast.fname;
+  fprintf os "    /* Marshaling buffer and sizes */ \n";
+  fprintf os "    size_t _output_buffer_size = _entry->output_buffer_size;\n";
+  fprintf os "    uint8_t* _output_buffer = (uint8_t*)_entry->output_buffer;\n";
+  fprintf os "    size_t _output_buffer_offset = 0;\n";
+  fprintf os "    size_t _output_bytes_written = _entry->output_bytes_written;\n";
+  (if fd.Ast.rtype <> Ast.Void then
+    fprintf os "    %s* _retval = &_call->_retval;\n" (get_ret_tystr fd));
+  fprintf os "\n";
+  fprintf os "    /* Parameters of the call */\n";
+  oe_gen_batch_param_locals os fd;
+  fprintf os "    /* Fill marshaling struct (for the sizes of the parameters) */\n";
+  fprintf os "    memset(&_args, 0, sizeof(_args));\n";
+  gen_fill_marshal_struct os fd "_args";
+  fprintf os "    /* Check the transport result of the call */\n";
+  fprintf os "    if ((_result = _entry->result) != OE_OK)\n";
+  fprintf os "        goto done;\n\n";
+  oe_process_output_buffer os fd;
+  fprintf os "    _result = OE_OK;\n";
+  fprintf os "done:\n";
+  fprintf os "    return _result;\n";
+  fprintf os "}\n\n"
+
+(* Generate the batch variant of an ecall wrapper. Each call is marshaled as
+ * by the regular wrapper and all of them are made with a single ECALL. *)
+let oe_gen_host_ecall_batch_function (os:out_channel) (tf:Ast.trusted_func) =
+  let fd = tf.Ast.tf_fdecl in
+  oe_gen_batch_prepare_function os fd;
+  oe_gen_batch_complete_function os fd;
+  fprintf os "%s" (oe_gen_batch_wrapper_prototype fd);
+  fprintf os "\n";
+  fprintf os "{\n";
+  fprintf os "    oe_result_t _result = OE_FAILURE;\n";
+  fprintf os "    oe_enclave_function_call_t* _entries = NULL;\n";
+  fprintf os "    size_t _num_prepared = 0;\n";
+  fprintf os "    size_t _i;\n\n";
+  fprintf os "    if (!_calls || _num_calls == 0) {\n";
+  fprintf os "        _result = _num_calls ? OE_INVALID_PARAMETER : OE_OK;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    _entries = (oe_enclave_function_call_t*) calloc(_num_calls, sizeof(*_entries));\n";
+  fprintf os "    if (_entries == NULL) {\n";
+  fprintf os "        _result = OE_OUT_OF_MEMORY;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    /* Marshal each call */\n";
+  fprintf os "    for (; _num_prepared < _num_calls; _num_prepared++) {\n";
+  fprintf os "        if ((_result = _%s_batch_prepare(\n" fd.Ast.fname;
+  fprintf os "                 &_calls[_num_prepared], &_entries[_num_prepared])) != OE_OK)\n";
+  fprintf os "            goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    /* Call enclave functions */\n";
+  fprintf os "    if ((_result = oe_call_enclave_function_batch(\n";
+  fprintf os "                        enclave, _entries, _num_calls)) != OE_OK)\n";
+  fprintf os "        goto done;\n\n";
+  fprintf os "    /* Unmarshal the outcome of each call */\n";
+  fprintf os "    for (_i = 0; _i < _num_calls; _i++)\n";
+  fprintf os "        _calls[_i]._result = _%s_batch_complete(&_calls[_i], &_entries[_i]);\n\n" fd.Ast.fname;
+  fprintf os "    _result = OE_OK;\n";
+  fprintf os "done:\n";
+  fprintf os "    for (_i = 0; _i < _num_prepared; _i++)\n";
+  fprintf os "        free((void*)_entries[_i].input_buffer);\n";
+  fprintf os "    if (_entries)\n";
+  fprintf os "        free(_entries);\n";
+  fprintf os "    return _result;\n";
+  fprintf os "}\n\n"
+
+(* Prototype of the asynchronous variant of an ecall wrapper *)
+let oe_gen_async_wrapper_prototype (fd: Ast.func_decl) =
+  sprintf "oe_result_t %s_async(\n        oe_enclave_t* enclave,\n        %s_args_t* _call,\n        void (*_callback)(%s_args_t* _call, void* _arg),\n        void* _callback_arg,\n        oe_async_call_t** _async_call)"
+    fd.Ast.fname fd.Ast.fname fd.Ast.fname
+
+(* Generate the asynchronous variant of an ecall wrapper. The call is
+ * marshaled and unmarshaled as a call of a batch, so this must follow the
+ * batch wrapper of the same function. *)
+let oe_gen_host_ecall_async_function (os:out_channel) (tf:Ast.trusted_func) =
+  let fd = tf.Ast.tf_fdecl in
+  let fname = fd.Ast.fname in
+  fprintf os "typedef struct _%s_async_context {\n" fname;
+  fprintf os "    %s_args_t* call;\n" fname;
+  fprintf os "    oe_enclave_function_call_t entry;\n";
+  fprintf os "    void (*callback)(%s_args_t* _call, void* _arg);\n" fname;
+  fprintf os "    void* callback_arg;\n";
+  fprintf os "} _%s_async_context_t;\n\n" fname;
+  fprintf os "static void _%s_async_complete(\n" fname;
+  fprintf os "        oe_result_t _result,\n";
+  fprintf os "        size_t _output_bytes_written,\n";
+  fprintf os "        void* _arg)\n";
+  fprintf os "{\n";
+  fprintf os "    _%s_async_context_t* _context = (_%s_async_context_t*)_arg;\n\n" fname fname;
+  fprintf os "    _context->entry.result = _result;\n";
+  fprintf os "    _context->entry.output_bytes_written = _output_bytes_written;\n";
+  fprintf os "    _context->call->_result = _%s_batch_complete(_context->call, &_context->entry);\n\n" fname;
+  fprintf os "    free((void*)_context->entry.input_buffer);\n\n";
+  fprintf os "    if (_context->callback)\n";
+  fprintf os "        _context->callback(_context->call, _context->callback_arg);\n\n";
+  fprintf os "    free(_context);\n";
+  fprintf os "}\n\n";
+  fprintf os "%s" (oe_gen_async_wrapper_prototype fd);
+  fprintf os "\n";
+  fprintf os "{\n";
+  fprintf os "    oe_result_t _result = OE_FAILURE;\n";
+  fprintf os "    _%s_async_context_t* _context = NULL;\n\n" fname;
+  fprintf os "    if (!_call) {\n";
+  fprintf os "        _result = OE_INVALID_PARAMETER;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    _context = (_%s_async_context_t*) calloc(1, sizeof(*_context));\n" fname;
+  fprintf os "    if (_context == NULL) {\n";
+  fprintf os "        _result = OE_OUT_OF_MEMORY;\n";
+  fprintf os "        goto done;\n";
+  fprintf os "    }\n\n";
+  fprintf os "    _context->call = _call;\n";
+  fprintf os "    _context->callback = _callback;\n";
+  fprintf os "    _context->callback_arg = _callback_arg;\n";
+  fprintf os "    _call->_result = OE_UNEXPECTED;\n\n";
+  fprintf os "    /* Marshal the call */\n";
+  fprintf os "    if ((_result = _%s_batch_prepare(_call, &_context->entry)) != OE_OK)\n" fname;
+  fprintf os "        goto done;\n\n";
+  fprintf os "    /* Queue the call (the context is released when it completes) */\n";
+  fprintf os "    if ((_result = oe_call_enclave_function_async(\n";
+  fprintf os "                        enclave,\n";
+  fprintf os "                        (uint32_t)_context->entry.function_id,\n";
+  fprintf os "                        _context->entry.input_buffer,\n";
+  fprintf os "                        _context->entry.input_buffer_size,\n";
+  fprintf os "                        _context->entry.output_buffer,\n";
+  fprintf os "                        _context->entry.output_buffer_size,\n";
+  fprintf os "                        _%s_async_complete,\n" fname;
+  fprintf os "                        _context,\n";
+  fprintf os "                        _async_call)) != OE_OK)\n";
+  fprintf os "        goto done;\n\n";
+  fprintf os "    _context = NULL;\n";
+  fprintf os "    _result = OE_OK;\n";
+  fprintf os "done:\n";
+  fprintf os "    if (_context) {\n";
+  fprintf os "        free((void*)_context->entry.input_buffer);\n";
+  fprintf os "        free(_context);\n";
+  fprintf os "    }\n";
+  fprintf os "    return _result;\n";
+  fprintf os "}\n\n"
+
 let iter_ptr_params f params = 
   List.iter (fun (ptype, decl)->
     match ptype with
@@ -709,15 +971,32 @@ let oe_gen_ocall_enclave_wrapper (os:out_channel) (uf:Ast.untrusted_func) =
   fprintf os "    /* Fill marshaling struct */\n";
   fprintf os "    memset(&_args, 0, sizeof(_args));\n";
   gen_fill_marshal_struct os fd "_args";
-  oe_prepare_input_buffer os fd "oe_allocate_ocall_buffer";
-  fprintf os "    /* Call host function */\n";
-  fprintf os "    if((_result = oe_call_host_function(\n";
-  fprintf os "                        %s,\n" (get_function_id fd);
-  fprintf os "                        _input_buffer, _input_buffer_size,\n";
-  fprintf os "                        _output_buffer, _output_buffer_size,\n";
-  fprintf os "                         &_output_bytes_written)) != OE_OK)\n";
-  fprintf os "        goto done;\n\n";
-  oe_process_output_buffer os fd;
+  oe_prepare_input_buffer os fd "oe_allocate_ocall_buffer(_total_buffer_size)";
+  (if uf.Ast.uf_fattr.Ast.fa_deferred then
+    begin
+    (* Deferred calls have no outputs, so there is nothing to unmarshal *)
+    fprintf os "    /* Queue call to host function */\n";
+    fprintf os "    if((_result = oe_deferred_call_host_function(\n";
+    fprintf os "                        %s,\n" (get_function_id fd);
+    fprintf os "                        _input_buffer, _input_buffer_size,\n";
+    fprintf os "                        _output_buffer, _output_buffer_size)) != OE_OK)\n";
+    fprintf os "        goto done;\n\n";
+    fprintf os "    OE_UNUSED(_pargs_out);\n";
+    fprintf os "    OE_UNUSED(_output_bytes_written);\n\n";
+    end
+  else
+    begin
+    fprintf os "    /* Call host function */\n";
+    fprintf os "    if((_result = %s(\n"
+      (if uf.Ast.uf_is_switchless then "oe_switchless_call_host_function"
+       else "oe_call_host_function");
+    fprintf os "                        %s,\n" (get_function_id fd);
+    fprintf os "                        _input_buffer, _input_buffer_size,\n";
+    fprintf os "                        _output_buffer, _output_buffer_size,\n";
+    fprintf os "                         &_output_bytes_written)) != OE_OK)\n";
+    fprintf os "        goto done;\n\n";
+    oe_process_output_buffer os fd
+    end);
 
   (* Propagate errno *)
   (if propagate_errno then
@@ -869,6 +1148,24 @@ let warn_non_portable_types (fd:Ast.func_decl) =
     (if uses_type (Ast.Long Ast.Unsigned) fd || uses_type ulong_t fd then
       print_portability_warning_with_recommendation "unsigned long" "uint64_t or uint32_t")
 
+(* A deferred ocall returns before the host function runs, so it can have
+ * no outputs of any kind. *)
+let validate_deferred_ocall (f: Ast.untrusted_func) =
+  let fd = f.Ast.uf_fdecl in
+  (if fd.Ast.rtype <> Ast.Void then
+      failwithf "Function '%s': deferred ocalls must return void." fd.Ast.fname);
+  (if f.Ast.uf_propagate_errno then
+      failwithf "Function '%s': deferred ocalls cannot propagate errno." fd.Ast.fname);
+  (if f.Ast.uf_is_switchless then
+      failwithf "Function '%s': deferred ocalls cannot be switchless." fd.Ast.fname);
+  iter_ptr_params (fun (_, decl, attr) ->
+    match attr.Ast.pa_direction with
+    | Ast.PtrOut | Ast.PtrInOut ->
+      failwithf "Function '%s': parameter '%s' of a deferred ocall cannot be out or in-out."
+        fd.Ast.fname decl.Ast.identifier
+    | _ -> ()
+  ) fd.Ast.plist
+
 (* Valid oe support *)
 let validate_oe_support (ec: enclave_content) (ep: edger8r_params) =
   (* check supported options *)
@@ -876,8 +1173,6 @@ let validate_oe_support (ec: enclave_content) (ep: edger8r_params) =
   List.iter (fun f -> 
     (if f.Ast.tf_is_priv then 
         failwithf "Function '%s': 'private' specifier is not supported by oeedger8r" f.Ast.tf_fdecl.fname);
-    (if f.Ast.tf_is_switchless then
-        failwithf "Function '%s': switchless ecalls and ocalls are not yet supported by Open Enclave SDK." f.Ast.tf_fdecl.fname);  
     warn_non_portable_types f.Ast.tf_fdecl;   
   ) ec.tfunc_decls;
   List.iter (fun f -> 
@@ -886,10 +1181,10 @@ let validate_oe_support (ec: enclave_content) (ep: edger8r_params) =
         printf "Warning: Function '%s': Calling convention '%s' for ocalls is not supported by oeedger8r.\n" f.Ast.uf_fdecl.fname cconv_str);
     (if f.Ast.uf_fattr.fa_dllimport then
         failwithf "Function '%s': dllimport is not supported by oeedger8r." f.Ast.uf_fdecl.fname);
+    (if f.Ast.uf_fattr.Ast.fa_deferred then
+        validate_deferred_ocall f);
     (if f.Ast.uf_allow_list != [] then
         printf "Warning: Function '%s': Reentrant ocalls are not supported by Open Enclave. Allow list ignored.\n" f.Ast.uf_fdecl.fname);
-    (if f.Ast.uf_is_switchless then
-        failwithf "Function '%s': switchless ecalls and ocalls are not yet supported by Open Enclave SDK." f.Ast.uf_fdecl.fname);
     warn_non_portable_types f.Ast.uf_fdecl;          
   ) ec.ufunc_decls
 
@@ -982,6 +1277,12 @@ let gen_u_h (ec: enclave_content) (ep: edger8r_params) =
   if ec.tfunc_decls <> [] then (
     fprintf os "/* List of ecalls */\n\n";
     List.iter (fun f -> fprintf os "%s;\n" (oe_gen_wrapper_prototype f.Ast.tf_fdecl true)) ec.tfunc_decls;
+    fprintf os "\n";
+    fprintf os "/* Batch variants of the ecalls */\n\n";
+    List.iter (fun f -> fprintf os "%s;\n" (oe_gen_batch_wrapper_prototype f.Ast.tf_fdecl)) ec.tfunc_decls;
+    fprintf os "\n";
+    fprintf os "/* Asynchronous variants of the ecalls */\n\n";
+    List.iter (fun f -> fprintf os "%s;\n" (oe_gen_async_wrapper_prototype f.Ast.tf_fdecl)) ec.tfunc_decls;
     fprintf os "\n");
   if ec.ufunc_decls <> [] then (
     fprintf os "/* List of ocalls */\n\n";
@@ -1004,7 +1305,11 @@ let gen_u_c (ec: enclave_content) (ep: edger8r_params) =
   fprintf os "OE_EXTERNC_BEGIN\n\n";
   if ec.tfunc_decls <> [] then (
     fprintf os "/* Wrappers for ecalls */\n\n";
-    List.iter (fun d -> oe_get_host_ecall_function os d.Ast.tf_fdecl; fprintf os "\n\n")  ec.tfunc_decls);
+    List.iter (fun d -> oe_get_host_ecall_function os d; fprintf os "\n\n")  ec.tfunc_decls;
+    fprintf os "/* Batch and asynchronous wrappers for ecalls */\n\n";
+    List.iter (fun d ->
+      oe_gen_host_ecall_batch_function os d;
+      oe_gen_host_ecall_async_function os d)  ec.tfunc_decls);
   if ec.ufunc_decls <> [] then (
     fprintf os "\n/* ocall functions */\n\n";
     List.iter (fun d -> oe_gen_ocall_host_wrapper os d) ec.ufunc_decls);
@@ -102,8 +102,16 @@ let get_call_conv_str (cc: call_conv) =
 type func_attr = {
   fa_dllimport : bool;                   (* use 'dllimport'? *)
   fa_convention: call_conv;              (* the calling convention *)
+  fa_deferred  : bool;                   (* queue the call until the next exit? *)
 }
 
+(* Where the host-side wrapper of a trusted function places its marshaling
+ * buffer: on the stack, in a buffer owned by the calling thread or on the
+ * heap. By default the stack is used if the size of the buffer is known at
+ * compile time, and the thread's buffer otherwise.
+ *)
+type host_buffer = HB_DEFAULT | HB_STACK | HB_THREAD | HB_HEAP
+
 (* A declarator can be an identifier or an identifier with array form.
  * For a simlpe identifier, the `array_dims' is an empty list `[]'.
  * A dimension with size -1 means that user explicitly declared `ary[]'.
@@ -158,6 +166,7 @@ type trusted_func = {
   tf_fdecl   : func_decl;
   tf_is_priv : bool;
   tf_is_switchless : bool;
+  tf_host_buffer : host_buffer;
 }
 
 type untrusted_func = {